@@ -0,0 +1,422 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Time.hpp>
+#include <wendy/Path.hpp>
+
+#include "Bench.hpp"
+#include "Fixtures.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <new>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+std::atomic<wendy::uint64> allocations(0);
+
+} /*namespace*/
+
+void* operator new (size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  if (void* pointer = std::malloc(size ? size : 1))
+    return pointer;
+
+  throw std::bad_alloc();
+}
+
+void* operator new [] (size_t size)
+{
+  return operator new (size);
+}
+
+void operator delete (void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete [] (void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete (void* pointer, size_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete [] (void* pointer, size_t) noexcept
+{
+  std::free(pointer);
+}
+
+namespace wendy
+{
+
+namespace
+{
+
+struct Benchmark
+{
+  std::string name;
+  BenchmarkFunction function;
+  std::vector<uint64> sizes;
+};
+
+struct BenchmarkResult
+{
+  std::string name;
+  uint64 size;
+  uint64 iterations;
+  double nsPerOp;
+  double allocationsPerOp;
+  double itemsPerSecond;
+  double bytesPerSecond;
+};
+
+std::vector<Benchmark>& benchmarks()
+{
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+const uint64 MAX_ITERATIONS = 1000000000;
+
+std::string escapeJSON(const std::string& string)
+{
+  std::string result;
+
+  for (char c : string)
+  {
+    if (c == '"' || c == '\\')
+      result.append(1, '\\');
+
+    result.append(1, c);
+  }
+
+  return result;
+}
+
+bool writeJSON(const char* path, const std::vector<BenchmarkResult>& results)
+{
+  std::ofstream stream(path);
+  if (!stream.is_open())
+  {
+    logError("Failed to open %s for writing", path);
+    return false;
+  }
+
+  stream.precision(12);
+  stream << "{\n";
+  stream << "  \"version\": \"" << WENDY_VERSION << "\",\n";
+#if WENDY_DEBUG
+  stream << "  \"build\": \"debug\",\n";
+#else
+  stream << "  \"build\": \"release\",\n";
+#endif
+  stream << "  \"benchmarks\": [\n";
+
+  for (size_t i = 0;  i < results.size();  i++)
+  {
+    const BenchmarkResult& r = results[i];
+
+    stream << "    {\n";
+    stream << "      \"name\": \"" << escapeJSON(r.name) << "\",\n";
+    stream << "      \"size\": " << r.size << ",\n";
+    stream << "      \"iterations\": " << r.iterations << ",\n";
+    stream << "      \"ns_per_op\": " << r.nsPerOp << ",\n";
+    stream << "      \"allocs_per_op\": " << r.allocationsPerOp << ",\n";
+    stream << "      \"items_per_second\": " << r.itemsPerSecond << ",\n";
+    stream << "      \"bytes_per_second\": " << r.bytesPerSecond << "\n";
+    stream << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+
+  stream << "  ]\n";
+  stream << "}\n";
+
+  return true;
+}
+
+} /*namespace*/
+
+class BenchmarkRunner
+{
+public:
+  static BenchmarkResult run(const Benchmark& benchmark,
+                             uint64 size,
+                             double minTime);
+};
+
+BenchmarkResult BenchmarkRunner::run(const Benchmark& benchmark,
+                                     uint64 size,
+                                     double minTime)
+{
+  BenchmarkState state(size, minTime);
+  benchmark.function(state);
+
+  BenchmarkResult result;
+  result.name = benchmark.name;
+  if (size)
+    result.name += format("/%llu", (unsigned long long) size);
+  result.size = size;
+  result.iterations = state.m_iterations;
+  result.nsPerOp = 0.0;
+  result.allocationsPerOp = 0.0;
+  result.itemsPerSecond = 0.0;
+  result.bytesPerSecond = 0.0;
+
+  if (state.m_iterations)
+  {
+    result.nsPerOp = state.m_elapsed * 1e9 / state.m_iterations;
+    result.allocationsPerOp = double(state.m_allocations) / state.m_iterations;
+  }
+
+  if (state.m_elapsed > 0.0)
+  {
+    result.itemsPerSecond = state.m_items * state.m_iterations / state.m_elapsed;
+    result.bytesPerSecond = state.m_bytes * state.m_iterations / state.m_elapsed;
+  }
+
+  return result;
+}
+
+BenchmarkState::BenchmarkState(uint64 size, double minTime):
+  m_size(size),
+  m_iterations(0),
+  m_checkpoint(0),
+  m_items(0),
+  m_bytes(0),
+  m_allocations(0),
+  m_allocationBase(0),
+  m_minTime(minTime),
+  m_elapsed(0.0),
+  m_start(0.0),
+  m_paused(true)
+{
+}
+
+void BenchmarkState::pause()
+{
+  if (m_paused)
+    return;
+
+  m_elapsed += Timer::currentTime() - m_start;
+  m_allocations += allocationCount() - m_allocationBase;
+  m_paused = true;
+}
+
+void BenchmarkState::resume()
+{
+  if (!m_paused)
+    return;
+
+  m_allocationBase = allocationCount();
+  m_start = Timer::currentTime();
+  m_paused = false;
+}
+
+bool BenchmarkState::checkpoint()
+{
+  // Undo the increment made by the failed fast path check
+  m_iterations--;
+
+  if (m_iterations == 0)
+  {
+    // The first call starts the measurement after the fixture is set up
+    m_checkpoint = 1;
+    m_iterations = 1;
+    resume();
+    return true;
+  }
+
+  pause();
+
+  if (m_elapsed >= m_minTime || m_iterations >= MAX_ITERATIONS)
+    return false;
+
+  // Aim slightly past the minimum time, but never grow more than tenfold
+  const double predicted = m_iterations * m_minTime * 1.2 / std::max(m_elapsed, 1e-9);
+  const double limit = double(m_iterations) * 10.0;
+
+  m_checkpoint = uint64(std::min(std::max(predicted, double(m_iterations + 1)), limit));
+  m_checkpoint = std::min(m_checkpoint, MAX_ITERATIONS);
+  m_iterations++;
+
+  resume();
+  return true;
+}
+
+BenchmarkRegistration::BenchmarkRegistration(const char* name,
+                                             BenchmarkFunction function)
+{
+  Benchmark benchmark;
+  benchmark.name = name;
+  benchmark.function = function;
+  benchmarks().push_back(benchmark);
+}
+
+BenchmarkRegistration::BenchmarkRegistration(const char* name,
+                                             BenchmarkFunction function,
+                                             std::initializer_list<uint64> sizes):
+  BenchmarkRegistration(name, function)
+{
+  benchmarks().back().sizes = sizes;
+}
+
+uint64 allocationCount()
+{
+  return allocations.load(std::memory_order_relaxed);
+}
+
+} /*namespace wendy*/
+
+using namespace wendy;
+
+namespace
+{
+
+void usage()
+{
+  std::printf("Usage: wendy_bench [OPTION]...\n"
+              "\n"
+              "Options:\n"
+              "  --filter=TEXT     only run benchmarks whose name contains TEXT\n"
+              "  --min-time=SECS   minimum measured time per benchmark (default 0.5)\n"
+              "  --max-size=N      skip sized runs larger than N\n"
+              "  --json=FILE       write results as JSON to FILE\n"
+              "  --list            list benchmarks and exit\n"
+              "  --help            show this help and exit\n");
+}
+
+} /*namespace*/
+
+int main(int argc, char** argv)
+{
+  std::string filter;
+  std::string jsonPath;
+  double minTime = 0.5;
+  uint64 maxSize = ~uint64(0);
+  bool listOnly = false;
+
+  for (int i = 1;  i < argc;  i++)
+  {
+    const char* arg = argv[i];
+
+    if (std::strncmp(arg, "--filter=", 9) == 0)
+      filter = arg + 9;
+    else if (std::strncmp(arg, "--min-time=", 11) == 0)
+      minTime = std::atof(arg + 11);
+    else if (std::strncmp(arg, "--max-size=", 11) == 0)
+      maxSize = std::strtoull(arg + 11, nullptr, 10);
+    else if (std::strncmp(arg, "--json=", 7) == 0)
+      jsonPath = arg + 7;
+    else if (std::strcmp(arg, "--list") == 0)
+      listOnly = true;
+    else if (std::strcmp(arg, "--help") == 0)
+    {
+      usage();
+      std::exit(EXIT_SUCCESS);
+    }
+    else
+    {
+      usage();
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  std::vector<BenchmarkResult> results;
+
+  if (!listOnly)
+  {
+    std::printf("%-48s %12s %14s %12s %14s\n",
+                "Benchmark", "Iterations", "ns/op", "allocs/op", "items/s");
+  }
+
+  for (const Benchmark& b : benchmarks())
+  {
+    if (!filter.empty() && b.name.find(filter) == std::string::npos)
+      continue;
+
+    std::vector<uint64> sizes = b.sizes;
+    if (sizes.empty())
+      sizes.push_back(0);
+
+    for (uint64 size : sizes)
+    {
+      if (size > maxSize)
+        continue;
+
+      if (listOnly)
+      {
+        if (size)
+          std::printf("%s/%llu\n", b.name.c_str(), (unsigned long long) size);
+        else
+          std::printf("%s\n", b.name.c_str());
+
+        continue;
+      }
+
+      const BenchmarkResult result = BenchmarkRunner::run(b, size, minTime);
+      if (!result.iterations)
+      {
+        // The benchmark returned without running, e.g. for lack of a context
+        std::printf("%-48s %12s\n", result.name.c_str(), "skipped");
+        continue;
+      }
+
+      std::printf("%-48s %12llu %14.1f %12.2f %14.4g\n",
+                  result.name.c_str(),
+                  (unsigned long long) result.iterations,
+                  result.nsPerOp,
+                  result.allocationsPerOp,
+                  result.itemsPerSecond);
+      std::fflush(stdout);
+
+      results.push_back(result);
+    }
+  }
+
+  removeFixtureFiles();
+
+  if (!jsonPath.empty())
+  {
+    if (!writeJSON(jsonPath.c_str(), results))
+      std::exit(EXIT_FAILURE);
+  }
+
+  std::exit(EXIT_SUCCESS);
+}
+
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <functional>
+
+namespace wendy
+{
+
+/*! @brief Per-run state of a single benchmark.
+ *
+ *  A benchmark function sets up its fixture and then loops on @c running,
+ *  which decides how many iterations are needed for a stable measurement.  A
+ *  benchmark that returns without calling @c running is reported as skipped.
+ */
+class BenchmarkState
+{
+  friend class BenchmarkRunner;
+public:
+  /*! @return @c true if another iteration should be run, otherwise @c false.
+   */
+  bool running()
+  {
+    if (m_iterations++ < m_checkpoint)
+      return true;
+
+    return checkpoint();
+  }
+  /*! Stops the clock and allocation counter, for per-iteration setup that
+   *  should not be measured.
+   */
+  void pause();
+  /*! Restarts the clock and allocation counter after @c pause.
+   */
+  void resume();
+  /*! Sets the number of items processed per iteration.
+   */
+  void setItemsPerIteration(uint64 count) { m_items = count; }
+  /*! Sets the number of bytes processed per iteration.
+   */
+  void setBytesPerIteration(uint64 count) { m_bytes = count; }
+  /*! @return The size parameter of this run, or zero if it has none.
+   */
+  uint64 size() const { return m_size; }
+private:
+  BenchmarkState(uint64 size, double minTime);
+  bool checkpoint();
+  uint64 m_size;
+  uint64 m_iterations;
+  uint64 m_checkpoint;
+  uint64 m_items;
+  uint64 m_bytes;
+  uint64 m_allocations;
+  uint64 m_allocationBase;
+  double m_minTime;
+  double m_elapsed;
+  double m_start;
+  bool m_paused;
+};
+
+typedef std::function<void (BenchmarkState&)> BenchmarkFunction;
+
+/*! @brief Static benchmark registration helper.
+ *
+ *  Declare one of these at namespace scope to add a benchmark to the program.
+ *  A benchmark registered with a list of sizes is run once for each size.
+ */
+class BenchmarkRegistration
+{
+public:
+  BenchmarkRegistration(const char* name, BenchmarkFunction function);
+  BenchmarkRegistration(const char* name,
+                        BenchmarkFunction function,
+                        std::initializer_list<uint64> sizes);
+};
+
+/*! @return The number of heap allocations made so far by the process.
+ */
+uint64 allocationCount();
+
+} /*namespace wendy*/
+
@@ -0,0 +1,623 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Time.hpp>
+#include <wendy/Profile.hpp>
+#include <wendy/Job.hpp>
+#include <wendy/ID.hpp>
+#include <wendy/Transform.hpp>
+#include <wendy/Rect.hpp>
+#include <wendy/Primitive.hpp>
+#include <wendy/Frustum.hpp>
+#include <wendy/Path.hpp>
+#include <wendy/Resource.hpp>
+#include <wendy/Pixel.hpp>
+#include <wendy/Vertex.hpp>
+#include <wendy/Image.hpp>
+#include <wendy/Compressor.hpp>
+#include <wendy/Mesh.hpp>
+
+#include <algorithm>
+
+#include "Bench.hpp"
+#include "Fixtures.hpp"
+
+namespace wendy
+{
+
+namespace
+{
+
+const uint VOLUME_COUNT = 4096;
+const uint BATCH_SIZE = 16;
+
+const uint REF_COUNT = 1024;
+
+class PlainObject : public RefObject
+{
+};
+
+class AtomicObject : public AtomicRefObject
+{
+};
+
+Frustum createFrustum()
+{
+  Transform3 transform;
+  transform.position = vec3(0.f, 0.f, 50.f);
+
+  Frustum frustum(radians(60.f), 16.f / 9.f, 0.1f, 200.f);
+  frustum.transformBy(transform);
+  return frustum;
+}
+
+void benchMeshRead(BenchmarkState& state)
+{
+  ResourceCache cache;
+  cache.addSearchPath(fixtureDirectory());
+
+  const uint size = uint(state.size());
+  const std::string name = writeGridMeshFile(cache, size);
+
+  state.setItemsPerIteration(size * size * 2);
+
+  while (state.running())
+  {
+    Ref<Mesh> mesh = Mesh::read(cache, name);
+    if (!mesh)
+      panic("Failed to read mesh fixture %s", name.c_str());
+  }
+}
+
+void benchResourceCacheFindResource(BenchmarkState& state)
+{
+  ResourceCache cache;
+
+  const uint count = uint(state.size());
+
+  std::vector<std::unique_ptr<Resource>> resources;
+  std::vector<std::string> names;
+
+  for (uint i = 0;  i < count;  i++)
+  {
+    names.push_back(format("resource%u.png", i));
+    resources.emplace_back(new Resource(ResourceInfo(cache, names.back())));
+  }
+
+  FixtureRandom random;
+  std::vector<uint> order(1024);
+  for (uint& index : order)
+    index = random.integer(0, count - 1);
+
+  state.setItemsPerIteration(order.size());
+
+  while (state.running())
+  {
+    for (uint index : order)
+    {
+      if (!cache.findResource(names[index]))
+        panic("Failed to find resource %s", names[index].c_str());
+    }
+  }
+}
+
+void benchResourceCacheFindFile(BenchmarkState& state)
+{
+  ResourceCache cache;
+  cache.addSearchPath(fixtureDirectory());
+
+  const std::string name = writeGridMeshFile(cache, 16);
+
+  state.setItemsPerIteration(2);
+
+  while (state.running())
+  {
+    if (cache.findFile(name).isEmpty())
+      panic("Failed to find file %s", name.c_str());
+    if (!cache.findFile("missing.obj").isEmpty())
+      panic("Found missing file");
+  }
+}
+
+/*! Writes a batch of distinct mesh files of roughly the specified size.
+ */
+std::vector<std::string> writeMeshBatch(ResourceCache& cache, uint size)
+{
+  std::vector<std::string> names;
+
+  for (uint i = 0;  i < BATCH_SIZE;  i++)
+    names.push_back(writeGridMeshFile(cache, size + i));
+
+  return names;
+}
+
+void benchMeshReadBatch(BenchmarkState& state)
+{
+  ResourceCache cache;
+  cache.addSearchPath(fixtureDirectory());
+
+  const std::vector<std::string> names = writeMeshBatch(cache, uint(state.size()));
+
+  state.setItemsPerIteration(names.size());
+
+  while (state.running())
+  {
+    std::vector<Ref<Mesh>> meshes;
+
+    for (const std::string& name : names)
+      meshes.push_back(Mesh::read(cache, name));
+  }
+}
+
+void benchMeshLoadAsyncBatch(BenchmarkState& state)
+{
+  ResourceCache cache;
+  cache.addSearchPath(fixtureDirectory());
+
+  const std::vector<std::string> names = writeMeshBatch(cache, uint(state.size()));
+
+  state.setItemsPerIteration(names.size());
+
+  while (state.running())
+  {
+    std::vector<AsyncResource<Mesh>> meshes;
+
+    for (const std::string& name : names)
+      meshes.push_back(cache.loadAsync<Mesh>(name));
+
+    // Only the time spent on this thread is measured, as that is what would
+    // cause a frame hitch
+    while (cache.pendingLoadCount())
+    {
+      state.pause();
+      std::this_thread::yield();
+      state.resume();
+
+      cache.finishLoads(0.0);
+    }
+
+    for (const AsyncResource<Mesh>& mesh : meshes)
+    {
+      if (!mesh.isReady())
+        panic("Failed to load mesh fixture");
+    }
+  }
+}
+
+void benchMeshGenerateNormals(BenchmarkState& state)
+{
+  ResourceCache cache;
+
+  Ref<Mesh> prototype = createGridMesh(cache, uint(state.size()));
+  Ref<Mesh> mesh = new Mesh(ResourceInfo(cache));
+
+  state.setItemsPerIteration(prototype->triangleCount());
+
+  while (state.running())
+  {
+    state.pause();
+    mesh->vertices = prototype->vertices;
+    mesh->sections = prototype->sections;
+    state.resume();
+
+    mesh->generateNormals(Mesh::SMOOTH_FACES);
+  }
+}
+
+void benchImageFlipVertical(BenchmarkState& state)
+{
+  ResourceCache cache;
+
+  const uint size = uint(state.size());
+
+  Ref<Image> image = Image::create(ResourceInfo(cache),
+                                   PixelFormat::RGBA8,
+                                   size, size);
+
+  state.setItemsPerIteration(size * size);
+  state.setBytesPerIteration(size * size * PixelFormat::RGBA8.size());
+
+  while (state.running())
+    image->flipVertical();
+}
+
+template <const PixelFormat& F>
+void benchCompressImage(BenchmarkState& state)
+{
+  ResourceCache cache;
+  FixtureRandom random;
+
+  const uint size = uint(state.size());
+  const PixelFormat& format = (F == PixelFormat::RGB_BC1) ? PixelFormat::RGB8
+                                                          : PixelFormat::RGBA8;
+
+  Ref<Image> image = Image::create(ResourceInfo(cache), format, size, size);
+
+  // Smooth gradients with some noise, roughly like texture content
+  uint8* texels = (uint8*) image->pixels();
+
+  for (uint y = 0;  y < size;  y++)
+  {
+    for (uint x = 0;  x < size;  x++)
+    {
+      for (uint c = 0;  c < format.channelCount();  c++)
+      {
+        const uint value = (x * (c + 1) + y * (4 - c)) * 255 / (size * 4);
+        *texels++ = uint8(min(value + random.integer(0, 8), 255u));
+      }
+    }
+  }
+
+  state.setItemsPerIteration(size * size);
+  state.setBytesPerIteration(size * size * format.size());
+
+  while (state.running())
+    compressImage(*image, F);
+}
+
+void benchFrustumIntersectsSphere(BenchmarkState& state)
+{
+  FixtureRandom random;
+
+  const Frustum frustum = createFrustum();
+
+  std::vector<Sphere> spheres(VOLUME_COUNT);
+  for (Sphere& s : spheres)
+    s.set(random.position(100.f), random.uniform(0.5f, 5.f));
+
+  state.setItemsPerIteration(VOLUME_COUNT);
+
+  uint visible = 0;
+
+  while (state.running())
+  {
+    for (const Sphere& s : spheres)
+      visible += frustum.intersects(s);
+  }
+
+  if (!visible)
+    logWarning("No spheres were visible");
+}
+
+void benchFrustumIntersectsAABB(BenchmarkState& state)
+{
+  FixtureRandom random;
+
+  const Frustum frustum = createFrustum();
+
+  std::vector<AABB> boxes(VOLUME_COUNT);
+  for (AABB& b : boxes)
+    b.set(random.position(100.f), vec3(random.uniform(0.5f, 5.f)));
+
+  state.setItemsPerIteration(VOLUME_COUNT);
+
+  uint visible = 0;
+
+  while (state.running())
+  {
+    for (const AABB& b : boxes)
+      visible += frustum.intersects(b);
+  }
+
+  if (!visible)
+    logWarning("No boxes were visible");
+}
+
+class NullLogConsumer : public LogConsumer
+{
+public:
+  NullLogConsumer(): count(0) { }
+  void onLogEntry(LogEntryType, const char*) { count++; }
+  uint count;
+};
+
+void benchLogWarning(BenchmarkState& state)
+{
+  NullLogConsumer consumer;
+
+  state.setItemsPerIteration(BATCH_SIZE);
+
+  while (state.running())
+  {
+    for (uint i = 0;  i < BATCH_SIZE;  i++)
+      logWarning("Rendering empty primitive range %u", i);
+  }
+
+  flushLog();
+}
+
+void benchLogWarningDisabled(BenchmarkState& state)
+{
+  NullLogConsumer consumer;
+
+  const LogEntryType previousLevel = logLevel();
+  setLogLevel(ERROR_LOG_ENTRY);
+
+  state.setItemsPerIteration(BATCH_SIZE);
+
+  while (state.running())
+  {
+    for (uint i = 0;  i < BATCH_SIZE;  i++)
+      logWarning("Rendering empty primitive range %u", i);
+  }
+
+  setLogLevel(previousLevel);
+
+  if (consumer.count)
+    panic("Disabled log entries were delivered");
+}
+
+template <typename T>
+Ref<T> createObject(T* object)
+{
+  Ref<T> result(object);
+  return result;
+}
+
+template <typename T>
+void benchRefCopy(BenchmarkState& state)
+{
+  std::vector<Ref<T>> source;
+  for (uint i = 0;  i < REF_COUNT;  i++)
+    source.push_back(new T());
+
+  std::vector<Ref<T>> target(REF_COUNT);
+
+  state.setItemsPerIteration(REF_COUNT);
+
+  while (state.running())
+  {
+    for (uint i = 0;  i < REF_COUNT;  i++)
+      target[i] = source[i];
+  }
+}
+
+template <typename T>
+void benchRefMove(BenchmarkState& state)
+{
+  std::vector<T*> source;
+  for (uint i = 0;  i < REF_COUNT;  i++)
+    source.push_back(new T());
+
+  std::vector<Ref<T>> target(source.begin(), source.end());
+
+  state.setItemsPerIteration(REF_COUNT);
+
+  while (state.running())
+  {
+    for (uint i = 0;  i < REF_COUNT;  i++)
+      target[i] = createObject(source[i]);
+  }
+}
+
+void benchProfileNodeCall(BenchmarkState& state)
+{
+  Profile profile;
+  Profile::setCurrent(&profile);
+  profile.beginFrame();
+
+  state.setItemsPerIteration(BATCH_SIZE);
+
+  while (state.running())
+  {
+    for (uint i = 0;  i < BATCH_SIZE;  i++)
+      ProfileNodeCall call("benchProfileNodeCall");
+  }
+
+  profile.endFrame();
+  Profile::setCurrent(nullptr);
+}
+
+void benchProfileZone(BenchmarkState& state)
+{
+  Profile profile;
+  Profile::setCurrent(&profile);
+  profile.beginFrame();
+
+  // Size one records event history as well
+  if (state.size())
+    profile.setHistory(1);
+
+  state.setItemsPerIteration(BATCH_SIZE);
+
+  while (state.running())
+  {
+    for (uint i = 0;  i < BATCH_SIZE;  i++)
+    {
+      WENDY_PROFILE_ZONE("benchProfileZone");
+    }
+  }
+
+  profile.endFrame();
+  Profile::setCurrent(nullptr);
+}
+
+void benchProfileZoneInactive(BenchmarkState& state)
+{
+  state.setItemsPerIteration(BATCH_SIZE);
+
+  while (state.running())
+  {
+    for (uint i = 0;  i < BATCH_SIZE;  i++)
+    {
+      WENDY_PROFILE_ZONE("benchProfileZoneInactive");
+    }
+  }
+}
+
+void benchHandlePoolChurn(BenchmarkState& state)
+{
+  FixtureRandom random;
+
+  const uint count = uint(state.size());
+
+  HandlePool pool;
+  std::vector<Handle> handles;
+
+  for (uint i = 0;  i < count;  i++)
+    handles.push_back(pool.allocate());
+
+  std::vector<uint> order(BATCH_SIZE);
+  for (uint& o : order)
+    o = uint(random.uniform(0.f, float(count - 1)));
+
+  state.setItemsPerIteration(BATCH_SIZE);
+
+  while (state.running())
+  {
+    for (uint i : order)
+    {
+      pool.release(handles[i]);
+      handles[i] = pool.allocate();
+    }
+  }
+
+  if (pool.size() != count)
+    panic("Handle pool lost handles");
+}
+
+void benchJobSystemSubmit(BenchmarkState& state)
+{
+  std::unique_ptr<JobSystem> jobs = JobSystem::create();
+  if (!jobs)
+    panic("Failed to create job system");
+
+  const uint count = uint(state.size());
+
+  state.setItemsPerIteration(count);
+
+  std::atomic<uint> total(0);
+
+  while (state.running())
+  {
+    JobCounter counter;
+
+    for (uint i = 0;  i < count;  i++)
+      jobs->submit([&total]() { total++; }, &counter);
+
+    jobs->wait(counter);
+  }
+
+  if (!total)
+    logWarning("No jobs were run");
+}
+
+void benchJobSystemParallelFor(BenchmarkState& state)
+{
+  std::unique_ptr<JobSystem> jobs = JobSystem::create();
+  if (!jobs)
+    panic("Failed to create job system");
+
+  FixtureRandom random;
+
+  const Frustum frustum = createFrustum();
+
+  std::vector<Sphere> spheres(VOLUME_COUNT * BATCH_SIZE);
+  for (Sphere& s : spheres)
+    s.set(random.position(100.f), random.uniform(0.5f, 5.f));
+
+  std::vector<uint8> results(spheres.size());
+
+  const uint grainSize = uint(state.size());
+
+  state.setItemsPerIteration(spheres.size());
+
+  while (state.running())
+  {
+    jobs->parallelFor(0, uint(spheres.size()), grainSize, [&](uint begin, uint end)
+    {
+      for (uint i = begin;  i < end;  i++)
+        results[i] = frustum.intersects(spheres[i]);
+    });
+  }
+
+  if (std::find(results.begin(), results.end(), 1) == results.end())
+    logWarning("No spheres were visible");
+}
+
+BenchmarkRegistration findResource("ResourceCache::findResource",
+                                   benchResourceCacheFindResource,
+                                   { 100, 10000 });
+BenchmarkRegistration findFile("ResourceCache::findFile",
+                               benchResourceCacheFindFile);
+BenchmarkRegistration meshRead("Mesh::read", benchMeshRead, { 16, 64, 256 });
+BenchmarkRegistration meshReadBatch("Mesh::read batch",
+                                    benchMeshReadBatch,
+                                    { 4 });
+BenchmarkRegistration meshLoadAsyncBatch("ResourceCache::loadAsync<Mesh> blocking",
+                                         benchMeshLoadAsyncBatch,
+                                         { 4 });
+BenchmarkRegistration meshGenerateNormals("Mesh::generateNormals",
+                                          benchMeshGenerateNormals,
+                                          { 16, 64, 256 });
+BenchmarkRegistration imageFlipVertical("Image::flipVertical",
+                                        benchImageFlipVertical,
+                                        { 256, 1024, 4096 });
+BenchmarkRegistration compressImageBC1("compressImage(RGB_BC1)",
+                                       benchCompressImage<PixelFormat::RGB_BC1>,
+                                       { 256, 1024 });
+BenchmarkRegistration compressImageBC3("compressImage(RGBA_BC3)",
+                                       benchCompressImage<PixelFormat::RGBA_BC3>,
+                                       { 256, 1024 });
+BenchmarkRegistration frustumSphere("Frustum::intersects(Sphere)",
+                                    benchFrustumIntersectsSphere);
+BenchmarkRegistration frustumAABB("Frustum::intersects(AABB)",
+                                  benchFrustumIntersectsAABB);
+BenchmarkRegistration logWarningQueued("logWarning",
+                                       benchLogWarning);
+BenchmarkRegistration logWarningDisabled("logWarning disabled",
+                                         benchLogWarningDisabled);
+BenchmarkRegistration refCopyPlain("Ref<RefObject> copy",
+                                   benchRefCopy<PlainObject>);
+BenchmarkRegistration refCopyAtomic("Ref<AtomicRefObject> copy",
+                                    benchRefCopy<AtomicObject>);
+BenchmarkRegistration refMovePlain("Ref<RefObject> return",
+                                   benchRefMove<PlainObject>);
+BenchmarkRegistration refMoveAtomic("Ref<AtomicRefObject> return",
+                                    benchRefMove<AtomicObject>);
+BenchmarkRegistration profileNodeCall("ProfileNodeCall",
+                                      benchProfileNodeCall);
+BenchmarkRegistration profileZone("WENDY_PROFILE_ZONE",
+                                  benchProfileZone,
+                                  { 0, 1 });
+BenchmarkRegistration profileZoneInactive("WENDY_PROFILE_ZONE no profile",
+                                          benchProfileZoneInactive);
+BenchmarkRegistration handlePoolChurn("HandlePool release+allocate",
+                                      benchHandlePoolChurn,
+                                      { 1000, 50000 });
+BenchmarkRegistration jobSubmit("JobSystem::submit+wait",
+                                benchJobSystemSubmit,
+                                { 1, 256 });
+BenchmarkRegistration jobParallelFor("JobSystem::parallelFor",
+                                     benchJobSystemParallelFor,
+                                     { 1024, 65536 });
+
+} /*namespace*/
+
+} /*namespace wendy*/
+
@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Path.hpp>
+#include <wendy/Resource.hpp>
+#include <wendy/Primitive.hpp>
+#include <wendy/Vertex.hpp>
+#include <wendy/Mesh.hpp>
+
+#include "Fixtures.hpp"
+
+#include <algorithm>
+
+namespace wendy
+{
+
+namespace
+{
+
+std::vector<Path> fixtureFiles;
+
+} /*namespace*/
+
+FixtureRandom::FixtureRandom(uint32 seed):
+  m_engine(seed)
+{
+}
+
+float FixtureRandom::uniform(float minimum, float maximum)
+{
+  // Avoid std::uniform_real_distribution, as its output is not specified to
+  // be identical between standard library implementations
+  const float unit = float(m_engine() >> 8) / float(1 << 24);
+  return minimum + (maximum - minimum) * unit;
+}
+
+uint32 FixtureRandom::integer(uint32 minimum, uint32 maximum)
+{
+  const uint32 range = maximum - minimum + 1;
+  if (!range)
+    return m_engine();
+
+  return minimum + m_engine() % range;
+}
+
+vec3 FixtureRandom::position(float extent)
+{
+  const float x = uniform(-extent, extent);
+  const float y = uniform(-extent, extent);
+  const float z = uniform(-extent, extent);
+  return vec3(x, y, z);
+}
+
+const Path& fixtureDirectory()
+{
+  static Path directory;
+
+  if (directory.isEmpty())
+  {
+    directory = Path("wendy-bench-fixtures");
+
+    if (!directory.isDirectory() && !directory.createDirectory())
+      panic("Failed to create fixture directory %s", directory.name().c_str());
+  }
+
+  return directory;
+}
+
+void removeFixtureFiles()
+{
+  for (Path& p : fixtureFiles)
+    p.remove();
+
+  fixtureFiles.clear();
+
+  if (fixtureDirectory().isDirectory())
+    fixtureDirectory().destroyDirectory();
+}
+
+Ref<Mesh> createGridMesh(ResourceCache& cache, uint size)
+{
+  FixtureRandom random(size);
+
+  Ref<Mesh> mesh = new Mesh(ResourceInfo(cache));
+  mesh->vertices.resize((size + 1) * (size + 1));
+
+  for (uint y = 0;  y <= size;  y++)
+  {
+    for (uint x = 0;  x <= size;  x++)
+    {
+      Vertex3fn2ft3fv& v = mesh->vertices[y * (size + 1) + x];
+      v.position = vec3(float(x), random.uniform(-0.5f, 0.5f), float(y));
+      v.texcoord = vec2(float(x), float(y)) / float(size);
+      v.normal = vec3(0.f);
+    }
+  }
+
+  mesh->sections.resize(1);
+
+  MeshSection& section = mesh->sections.back();
+  section.materialName = "grid";
+  section.triangles.resize(size * size * 2);
+
+  for (uint y = 0;  y < size;  y++)
+  {
+    for (uint x = 0;  x < size;  x++)
+    {
+      const uint32 base = y * (size + 1) + x;
+
+      MeshTriangle* t = &section.triangles[(y * size + x) * 2];
+      t[0].setIndices(base, base + size + 1, base + 1);
+      t[1].setIndices(base + 1, base + size + 1, base + size + 2);
+    }
+  }
+
+  return mesh;
+}
+
+std::string writeGridMeshFile(ResourceCache& cache, uint size)
+{
+  const std::string name = format("grid%u.obj", size);
+  const Path path = fixtureDirectory() + name;
+
+  if (std::find(fixtureFiles.begin(), fixtureFiles.end(), path) == fixtureFiles.end())
+  {
+    Ref<Mesh> mesh = createGridMesh(cache, size);
+    mesh->generateNormals();
+
+    if (!mesh->write(path))
+      panic("Failed to write mesh fixture %s", path.name().c_str());
+
+    fixtureFiles.push_back(path);
+    cache.clearFileCache();
+  }
+
+  return name;
+}
+
+} /*namespace wendy*/
+
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <random>
+
+namespace wendy
+{
+
+class Mesh;
+class Path;
+class ResourceCache;
+
+/*! @brief Deterministic random source for benchmark fixtures.
+ *
+ *  All fixtures are generated from a fixed seed so that results are
+ *  comparable between runs and machines.
+ */
+class FixtureRandom
+{
+public:
+  FixtureRandom(uint32 seed = 0x57656e64u);
+  float uniform(float minimum, float maximum);
+  uint32 integer(uint32 minimum, uint32 maximum);
+  vec3 position(float extent);
+private:
+  std::mt19937 m_engine;
+};
+
+/*! @return The directory used for temporary fixture files.
+ */
+const Path& fixtureDirectory();
+
+/*! Removes all fixture files created by this process.
+ */
+void removeFixtureFiles();
+
+/*! Creates an unnamed grid mesh with @c size by @c size quads, with slightly
+ *  perturbed heights, texture coordinates and no normals.
+ */
+Ref<Mesh> createGridMesh(ResourceCache& cache, uint size);
+
+/*! Writes a grid mesh of the specified size as an OBJ file in the fixture
+ *  directory and returns its name.
+ */
+std::string writeGridMeshFile(ResourceCache& cache, uint size);
+
+} /*namespace wendy*/
+
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Network.hpp>
+
+#include "Bench.hpp"
+#include "Fixtures.hpp"
+
+namespace wendy
+{
+
+namespace
+{
+
+enum PacketValueType
+{
+  VALUE_8,
+  VALUE_16,
+  VALUE_32,
+  VALUE_32F,
+  VALUE_STRING
+};
+
+struct PacketValue
+{
+  PacketValueType type;
+  uint32 integer;
+  float real;
+  std::string string;
+};
+
+/*! Creates a deterministic stream of values that fits in a single packet,
+ *  resembling a burst of small object synchronization events.
+ */
+std::vector<PacketValue> createPacketStream(size_t capacity)
+{
+  FixtureRandom random;
+
+  std::vector<PacketValue> values;
+  size_t size = 0;
+
+  for (;;)
+  {
+    PacketValue value;
+    value.type = PacketValueType(random.integer(VALUE_8, VALUE_STRING));
+    value.integer = random.integer(0, ~0u);
+    value.real = random.uniform(-1000.f, 1000.f);
+
+    size_t valueSize = 0;
+
+    switch (value.type)
+    {
+      case VALUE_8:
+        valueSize = 1;
+        break;
+      case VALUE_16:
+        valueSize = 2;
+        break;
+      case VALUE_32:
+      case VALUE_32F:
+        valueSize = 4;
+        break;
+      case VALUE_STRING:
+        value.string = format("object%u", value.integer % 1000);
+        valueSize = value.string.length() + 1;
+        break;
+    }
+
+    if (size + valueSize > capacity)
+      break;
+
+    size += valueSize;
+    values.push_back(value);
+  }
+
+  return values;
+}
+
+void writePacketStream(PacketData& data, const std::vector<PacketValue>& values)
+{
+  for (const PacketValue& v : values)
+  {
+    switch (v.type)
+    {
+      case VALUE_8:
+        data.write8(uint8(v.integer));
+        break;
+      case VALUE_16:
+        data.write16(uint16(v.integer));
+        break;
+      case VALUE_32:
+        data.write32(v.integer);
+        break;
+      case VALUE_32F:
+        data.write32f(v.real);
+        break;
+      case VALUE_STRING:
+        data.write(v.string);
+        break;
+    }
+  }
+}
+
+void benchPacketDataWrite(BenchmarkState& state)
+{
+  std::vector<uint8> buffer(state.size());
+  const std::vector<PacketValue> values = createPacketStream(buffer.size());
+
+  state.setItemsPerIteration(values.size());
+  state.setBytesPerIteration(buffer.size());
+
+  while (state.running())
+  {
+    PacketData data(buffer.data(), buffer.size());
+    writePacketStream(data, values);
+  }
+}
+
+void benchPacketDataRead(BenchmarkState& state)
+{
+  std::vector<uint8> buffer(state.size());
+  const std::vector<PacketValue> values = createPacketStream(buffer.size());
+
+  PacketData source(buffer.data(), buffer.size());
+  writePacketStream(source, values);
+
+  state.setItemsPerIteration(values.size());
+  state.setBytesPerIteration(source.size());
+
+  uint32 checksum = 0;
+
+  while (state.running())
+  {
+    PacketData data(buffer.data(), buffer.size(), source.size());
+
+    for (const PacketValue& v : values)
+    {
+      switch (v.type)
+      {
+        case VALUE_8:
+          checksum += data.read8();
+          break;
+        case VALUE_16:
+          checksum += data.read16();
+          break;
+        case VALUE_32:
+          checksum += data.read32();
+          break;
+        case VALUE_32F:
+          checksum += uint32(data.read32f());
+          break;
+        case VALUE_STRING:
+          checksum += uint32(data.read<std::string>().length());
+          break;
+      }
+    }
+  }
+
+  if (!checksum)
+    logWarning("Packet stream checksum is zero");
+}
+
+BenchmarkRegistration packetWrite("PacketData::write",
+                                  benchPacketDataWrite,
+                                  { 1024, 65536 });
+BenchmarkRegistration packetRead("PacketData::read",
+                                 benchPacketDataRead,
+                                 { 1024, 65536 });
+
+} /*namespace*/
+
+} /*namespace wendy*/
+
@@ -0,0 +1,382 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Path.hpp>
+#include <wendy/Resource.hpp>
+#include <wendy/Transform.hpp>
+#include <wendy/Primitive.hpp>
+#include <wendy/Frustum.hpp>
+#include <wendy/Camera.hpp>
+
+#include <wendy/Texture.hpp>
+#include <wendy/RenderBuffer.hpp>
+#include <wendy/Program.hpp>
+#include <wendy/RenderContext.hpp>
+#include <wendy/Pass.hpp>
+#include <wendy/Material.hpp>
+#include <wendy/RenderQueue.hpp>
+#include <wendy/Renderer.hpp>
+#include <wendy/Font.hpp>
+
+#if WENDY_INCLUDE_UI_SYSTEM
+#include <wendy/Drawer.hpp>
+#endif
+
+#include "Bench.hpp"
+#include "Fixtures.hpp"
+
+namespace wendy
+{
+
+namespace
+{
+
+const uint FRAME_WIDTH = 512;
+const uint FRAME_HEIGHT = 512;
+
+/*! Headless context rendering into a texture, shared by all benchmarks in
+ *  this file.
+ */
+class RenderFixture
+{
+public:
+  ResourceCache cache;
+  std::unique_ptr<RenderContext> context;
+  Ref<Texture> texture;
+  Ref<TextureFramebuffer> framebuffer;
+};
+
+/*! @return The shared render fixture, or @c nullptr if no headless context
+ *  could be created, in which case the calling benchmark should be skipped.
+ */
+RenderFixture* renderFixture()
+{
+  static RenderFixture fixture;
+  static bool initialized = false;
+
+  if (!initialized)
+  {
+    initialized = true;
+
+    fixture.cache.addSearchPath(Path(WENDY_BENCH_MEDIA_DIR));
+
+    fixture.context = RenderContext::createHeadless(fixture.cache,
+                                                    FRAME_WIDTH,
+                                                    FRAME_HEIGHT);
+    if (!fixture.context)
+      return nullptr;
+
+    RenderContext& context = *fixture.context;
+
+    fixture.texture = Texture::create(ResourceInfo(fixture.cache),
+                                      context,
+                                      TextureParams(TEXTURE_2D, TF_NONE),
+                                      TextureData(PixelFormat::RGBA8,
+                                                  FRAME_WIDTH,
+                                                  FRAME_HEIGHT));
+    if (!fixture.texture)
+      panic("Failed to create render fixture texture");
+
+    fixture.framebuffer = TextureFramebuffer::create(context);
+    if (!fixture.framebuffer)
+      panic("Failed to create render fixture framebuffer");
+
+    fixture.framebuffer->setColorBuffer(fixture.texture);
+    context.setFramebuffer(*fixture.framebuffer);
+  }
+
+  return fixture.context ? &fixture : nullptr;
+}
+
+/*! @return A line of text with the specified number of characters.
+ */
+std::string createText(uint64 length)
+{
+  const char pangram[] = "The quick brown fox jumps over the lazy dog. ";
+
+  std::string text;
+  text.reserve(length);
+
+  while (text.length() < length)
+    text.append(1, pangram[text.length() % (sizeof(pangram) - 1)]);
+
+  return text;
+}
+
+const char* modelVertexShader =
+  "#version 150\n"
+  "in vec3 vPosition;\n"
+  "void main()\n"
+  "{\n"
+  "  gl_Position = wyMVP * vec4(vPosition, 1.0);\n"
+  "}\n";
+
+const char* instanceVertexShader =
+  "#version 150\n"
+  "in vec3 vPosition;\n"
+  "void main()\n"
+  "{\n"
+  "  gl_Position = wyVP * wyInstanceM * vec4(vPosition, 1.0);\n"
+  "}\n";
+
+const char* solidFragmentShader =
+  "#version 150\n"
+  "out vec4 color;\n"
+  "void main()\n"
+  "{\n"
+  "  color = vec4(1.0);\n"
+  "}\n";
+
+/*! @return A program made from the specified vertex shader and a solid color
+ *  fragment shader.
+ */
+Ref<Program> createProgram(RenderContext& context,
+                           const char* name,
+                           const char* vertexShaderText)
+{
+  ResourceCache& cache = context.cache();
+
+  Ref<Shader> vertexShader = Shader::create(ResourceInfo(cache),
+                                            context,
+                                            VERTEX_SHADER,
+                                            vertexShaderText);
+  Ref<Shader> fragmentShader = Shader::create(ResourceInfo(cache),
+                                              context,
+                                              FRAGMENT_SHADER,
+                                              solidFragmentShader);
+  if (!vertexShader || !fragmentShader)
+    panic("Failed to create shaders for %s", name);
+
+  Ref<Program> program = Program::create(ResourceInfo(cache),
+                                         context,
+                                         *vertexShader,
+                                         *fragmentShader);
+  if (!program)
+    panic("Failed to create program %s", name);
+
+  return program;
+}
+
+/*! Renders a queue of small quads sharing a single pass and primitive range,
+ *  as produced by many scene nodes using the same model.
+ */
+void benchRenderOperations(BenchmarkState& state, const char* vertexShaderText)
+{
+  RenderFixture* fixture = renderFixture();
+  if (!fixture)
+    return;
+
+  RenderContext& context = *fixture->context;
+
+  const vec3 vertices[] =
+  {
+    vec3(-0.5f, -0.5f, 0.f), vec3(0.5f, -0.5f, 0.f),
+    vec3(0.5f, 0.5f, 0.f), vec3(-0.5f, 0.5f, 0.f)
+  };
+
+  const uint8 indices[] = { 0, 1, 2, 0, 2, 3 };
+
+  Ref<VertexBuffer> vertexBuffer = VertexBuffer::create(context, 4, Vertex3fv::format, USAGE_STATIC);
+  Ref<IndexBuffer> indexBuffer = IndexBuffer::create(context, 6, INDEX_UINT8, USAGE_STATIC);
+  if (!vertexBuffer || !indexBuffer)
+    panic("Failed to create quad buffers");
+
+  vertexBuffer->copyFrom(vertices, 4);
+  indexBuffer->copyFrom(indices, 6);
+
+  const PrimitiveRange range(TRIANGLE_LIST, *vertexBuffer, *indexBuffer);
+
+  Ref<Program> program = createProgram(context, "quad", vertexShaderText);
+
+  Pass pass;
+  pass.setProgram(program);
+
+  Ref<Camera> camera = new Camera();
+  camera->setFarZ(1000.f);
+
+  Ref<Renderer> renderer = Renderer::create(context);
+  if (!renderer)
+    panic("Failed to create renderer");
+
+  RenderQueue queue(context);
+
+  const uint count = uint(state.size());
+  const uint side = 1 + uint(std::sqrt(float(count)));
+
+  for (uint i = 0;  i < count;  i++)
+  {
+    Transform3 transform;
+    transform.position = vec3(float(i % side) - side / 2.f,
+                              float(i / side) - side / 2.f,
+                              -float(side));
+    transform.scale = 0.5f;
+
+    RenderOp op;
+    op.range = range;
+    op.state = &pass;
+    op.transform = queue.addTransform(transform);
+    queue.addOperation(op, float(side));
+  }
+
+  while (state.running())
+  {
+    context.clearBuffers();
+    renderer->render(queue, *camera);
+    context.finishFrame();
+  }
+
+  state.setItemsPerIteration(count);
+}
+
+void benchRenderModelMatrix(BenchmarkState& state)
+{
+  benchRenderOperations(state, modelVertexShader);
+}
+
+void benchRenderInstanced(BenchmarkState& state)
+{
+  benchRenderOperations(state, instanceVertexShader);
+}
+
+void benchFontLayoutOf(BenchmarkState& state)
+{
+  RenderFixture* fixture = renderFixture();
+  if (!fixture)
+    return;
+
+  Ref<Font> font = Font::read(*fixture->context, "wendy/UIDefault.font");
+  if (!font)
+    panic("Failed to load font fixture");
+
+  const std::string text = createText(state.size());
+
+  while (state.running())
+    font->layoutOf(text.c_str());
+
+  state.setItemsPerIteration(text.length());
+}
+
+void benchFontDrawText(BenchmarkState& state)
+{
+  RenderFixture* fixture = renderFixture();
+  if (!fixture)
+    return;
+
+  RenderContext& context = *fixture->context;
+
+  Ref<Font> font = Font::read(context, "wendy/UIDefault.font");
+  if (!font)
+    panic("Failed to load font fixture");
+
+  Ref<SharedProgramState> state2D = new SharedProgramState();
+  state2D->setOrthoProjectionMatrix(float(FRAME_WIDTH), float(FRAME_HEIGHT));
+  context.setSharedProgramState(state2D);
+
+  const std::string text = createText(64);
+  const uint lineCount = uint(state.size());
+
+  while (state.running())
+  {
+    context.clearColorBuffer(vec4(0.f, 0.f, 0.f, 1.f));
+
+    for (uint i = 0;  i < lineCount;  i++)
+    {
+      const vec2 pen(4.f, float(i % 32) * font->height());
+      font->drawText(pen, vec4(1.f), text.c_str());
+    }
+
+    context.finishFrame();
+  }
+
+  context.setSharedProgramState(nullptr);
+
+  state.setItemsPerIteration(lineCount);
+}
+
+#if WENDY_INCLUDE_UI_SYSTEM
+
+void benchDrawerWidgets(BenchmarkState& state)
+{
+  RenderFixture* fixture = renderFixture();
+  if (!fixture)
+    return;
+
+  RenderContext& context = *fixture->context;
+
+  std::unique_ptr<Drawer> drawer = Drawer::create(context);
+  if (!drawer)
+    panic("Failed to create drawer fixture");
+
+  const uint widgetCount = uint(state.size());
+
+  while (state.running())
+  {
+    context.clearColorBuffer(vec4(0.f, 0.f, 0.f, 1.f));
+
+    drawer->begin();
+
+    for (uint i = 0;  i < widgetCount;  i++)
+    {
+      const Rect area(float(i % 8) * 64.f, float(i / 8 % 32) * 16.f, 60.f, 14.f);
+      drawer->drawButton(area, STATE_NORMAL, "Button");
+      drawer->drawRect(area, vec4(1.f));
+    }
+
+    drawer->end();
+
+    context.finishFrame();
+  }
+
+  state.setItemsPerIteration(widgetCount);
+}
+
+#endif /*WENDY_INCLUDE_UI_SYSTEM*/
+
+BenchmarkRegistration fontLayoutOf("Font::layoutOf",
+                                   benchFontLayoutOf,
+                                   { 16, 256 });
+BenchmarkRegistration renderModelMatrix("Renderer::render wyM",
+                                        benchRenderModelMatrix,
+                                        { 100, 2000 });
+BenchmarkRegistration renderInstanced("Renderer::render wyInstanceM",
+                                      benchRenderInstanced,
+                                      { 100, 2000 });
+BenchmarkRegistration fontDrawText("Font::drawText frame",
+                                   benchFontDrawText,
+                                   { 1, 32 });
+
+#if WENDY_INCLUDE_UI_SYSTEM
+BenchmarkRegistration drawerWidgets("Drawer widgets frame",
+                                    benchDrawerWidgets,
+                                    { 16, 256 });
+#endif /*WENDY_INCLUDE_UI_SYSTEM*/
+
+} /*namespace*/
+
+} /*namespace wendy*/
+
@@ -0,0 +1,254 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Time.hpp>
+#include <wendy/Transform.hpp>
+#include <wendy/Primitive.hpp>
+#include <wendy/Frustum.hpp>
+#include <wendy/AABBTree.hpp>
+#include <wendy/Camera.hpp>
+
+#include <wendy/Texture.hpp>
+#include <wendy/RenderBuffer.hpp>
+#include <wendy/Program.hpp>
+#include <wendy/RenderContext.hpp>
+#include <wendy/Pass.hpp>
+#include <wendy/Material.hpp>
+#include <wendy/RenderQueue.hpp>
+#include <wendy/Scene.hpp>
+
+#include "Bench.hpp"
+#include "Fixtures.hpp"
+
+namespace wendy
+{
+
+namespace
+{
+
+/*! Populates a scene graph with the specified total number of nodes, spread
+ *  over roots with zero to three children each.
+ */
+void createSceneGraph(SceneGraph& graph, uint64 nodeCount)
+{
+  FixtureRandom random;
+
+  const float extent = 10.f * std::cbrt(float(nodeCount));
+
+  uint64 created = 0;
+
+  while (created < nodeCount)
+  {
+    SceneNode* root = new SceneNode();
+    root->setLocalPosition(random.position(extent));
+    root->setLocalBounds(Sphere(vec3(0.f), random.uniform(0.5f, 2.f)));
+    graph.addRootNode(*root);
+    created++;
+
+    const uint64 childCount = std::min(uint64(random.integer(0, 3)),
+                                       nodeCount - created);
+
+    for (uint64 i = 0;  i < childCount;  i++)
+    {
+      SceneNode* child = new SceneNode();
+      child->setLocalPosition(random.position(2.f));
+      child->setLocalBounds(Sphere(vec3(0.f), random.uniform(0.5f, 1.f)));
+      root->addChild(*child);
+      created++;
+    }
+  }
+}
+
+Frustum createFrustum(uint64 nodeCount)
+{
+  const float extent = 10.f * std::cbrt(float(nodeCount));
+
+  Transform3 transform;
+  transform.position = vec3(0.f, 0.f, extent);
+
+  Frustum frustum(radians(60.f), 16.f / 9.f, 0.1f, extent);
+  frustum.transformBy(transform);
+  return frustum;
+}
+
+void benchRenderBucketOrder(BenchmarkState& state)
+{
+  FixtureRandom random;
+
+  const uint count = uint(state.size());
+
+  std::vector<RenderOpKey> keys(count);
+  for (RenderOpKey& k : keys)
+  {
+    k = RenderOpKey::makeOpaqueKey(uint8(random.integer(0, 3)),
+                                   uint16(random.integer(0, 255)),
+                                   random.uniform(0.f, 1.f));
+  }
+
+  RenderOp operation;
+  RenderBucket bucket;
+
+  state.setItemsPerIteration(count);
+
+  while (state.running())
+  {
+    state.pause();
+    bucket.removeOperations();
+    for (RenderOpKey k : keys)
+      bucket.addOperation(operation, k);
+    state.resume();
+
+    if (bucket.order().size() != count)
+      panic("Render bucket lost operations");
+  }
+
+  const std::vector<uint32>& order = bucket.order();
+
+  for (size_t i = 1;  i < order.size();  i++)
+  {
+    const uint64 a = keys[order[i - 1]], b = keys[order[i]];
+    if (a > b || (a == b && order[i - 1] > order[i]))
+      panic("Render bucket order is not stable");
+  }
+}
+
+void benchSceneGraphQueryFrustum(BenchmarkState& state)
+{
+  SceneGraph graph;
+  createSceneGraph(graph, state.size());
+
+  const Frustum frustum = createFrustum(state.size());
+
+  std::vector<SceneNode*> nodes;
+  nodes.reserve(graph.roots().size());
+
+  state.setItemsPerIteration(graph.roots().size());
+
+  // The first query builds the bounding volume hierarchy
+  graph.query(frustum, nodes);
+
+  while (state.running())
+  {
+    nodes.clear();
+    graph.query(frustum, nodes);
+  }
+}
+
+void benchSceneGraphQuerySphere(BenchmarkState& state)
+{
+  SceneGraph graph;
+  createSceneGraph(graph, state.size());
+
+  const Sphere sphere(vec3(0.f), 5.f * std::cbrt(float(state.size())));
+
+  std::vector<SceneNode*> nodes;
+  nodes.reserve(graph.roots().size());
+
+  state.setItemsPerIteration(graph.roots().size());
+
+  // The first query builds the bounding volume hierarchy
+  graph.query(sphere, nodes);
+
+  while (state.running())
+  {
+    nodes.clear();
+    graph.query(sphere, nodes);
+  }
+}
+
+void benchFrustumIntersectsBatch(BenchmarkState& state)
+{
+  FixtureRandom random;
+
+  const uint64 count = state.size();
+  const Frustum frustum = createFrustum(count);
+  const float extent = 10.f * std::cbrt(float(count));
+
+  SphereBatch spheres;
+  AABBBatch boxes;
+
+  for (uint64 i = 0;  i < count;  i++)
+  {
+    const vec3 center = random.position(extent);
+    const float radius = random.uniform(0.5f, 2.f);
+
+    spheres.add(Sphere(center, radius));
+    boxes.add(AABB(center, vec3(radius * 1.5f)));
+  }
+
+  std::vector<uint32> visible;
+
+  state.setItemsPerIteration(count);
+
+  while (state.running())
+    frustum.intersects(spheres, boxes, visible);
+}
+
+void benchSceneNodeTransforms(BenchmarkState& state)
+{
+  SceneGraph graph;
+  createSceneGraph(graph, state.size());
+
+  state.setItemsPerIteration(state.size());
+
+  const vec3 offset(0.f, 0.001f, 0.f);
+
+  while (state.running())
+  {
+    for (SceneNode* r : graph.roots())
+    {
+      r->setLocalPosition(r->localTransform().position + offset);
+
+      for (const SceneNode* c : r->children())
+        c->worldTransform();
+    }
+  }
+}
+
+const std::initializer_list<uint64> SCENE_SIZES = { 10000, 100000, 1000000 };
+
+BenchmarkRegistration renderBucketOrder("RenderBucket::order",
+                                        benchRenderBucketOrder,
+                                        { 1000, 10000, 65000, 1000000 });
+BenchmarkRegistration queryFrustum("SceneGraph::query(Frustum)",
+                                   benchSceneGraphQueryFrustum,
+                                   SCENE_SIZES);
+BenchmarkRegistration querySphere("SceneGraph::query(Sphere)",
+                                  benchSceneGraphQuerySphere,
+                                  SCENE_SIZES);
+BenchmarkRegistration intersectsBatch("Frustum::intersects batch",
+                                      benchFrustumIntersectsBatch,
+                                      SCENE_SIZES);
+BenchmarkRegistration nodeTransforms("SceneNode::worldTransform",
+                                     benchSceneNodeTransforms,
+                                     SCENE_SIZES);
+
+} /*namespace*/
+
+} /*namespace wendy*/
+
@@ -72,8 +72,16 @@ extern "C" {
 #define GL_VERSION_3_1 1
 #define GL_VERSION_3_2 1
 
+#define GL_ARB_ES3_compatibility 1
+#define GL_ARB_buffer_storage 1
+#define GL_ARB_get_program_binary 1
+#define GL_ARB_instanced_arrays 1
+#define GL_ARB_texture_compression_bptc 1
 #define GL_ARB_texture_float 1
+#define GL_ARB_texture_swizzle 1
+#define GL_EXT_texture_compression_s3tc 1
 #define GL_EXT_texture_filter_anisotropic 1
+#define GL_EXT_texture_sRGB 1
 #define GL_KHR_debug 1
 
 
@@ -90,8 +98,16 @@ extern int GREG_VERSION_3_0;
 extern int GREG_VERSION_3_1;
 extern int GREG_VERSION_3_2;
 
+extern int GREG_ARB_ES3_compatibility;
+extern int GREG_ARB_buffer_storage;
+extern int GREG_ARB_get_program_binary;
+extern int GREG_ARB_instanced_arrays;
+extern int GREG_ARB_texture_compression_bptc;
 extern int GREG_ARB_texture_float;
+extern int GREG_ARB_texture_swizzle;
+extern int GREG_EXT_texture_compression_s3tc;
 extern int GREG_EXT_texture_filter_anisotropic;
+extern int GREG_EXT_texture_sRGB;
 extern int GREG_KHR_debug;
 
 
@@ -197,6 +213,10 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
 #define GL_MAP_FLUSH_EXPLICIT_BIT 0x0010
 #define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
 #define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
 #define GL_FALSE 0
 #define GL_NO_ERROR 0
@@ -801,6 +821,8 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_MINOR_VERSION 0x821C
 #define GL_NUM_EXTENSIONS 0x821D
 #define GL_CONTEXT_FLAGS 0x821E
+#define GL_BUFFER_IMMUTABLE_STORAGE 0x821F
+#define GL_BUFFER_STORAGE_FLAGS 0x8220
 #define GL_INDEX 0x8222
 #define GL_COMPRESSED_RED 0x8225
 #define GL_COMPRESSED_RG 0x8226
@@ -858,6 +880,7 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_DEBUG_TYPE_PERFORMANCE_KHR 0x8250
 #define GL_DEBUG_TYPE_OTHER 0x8251
 #define GL_DEBUG_TYPE_OTHER_KHR 0x8251
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
 #define GL_DEBUG_TYPE_MARKER 0x8268
 #define GL_DEBUG_TYPE_MARKER_KHR 0x8268
 #define GL_DEBUG_TYPE_PUSH_GROUP 0x8269
@@ -892,6 +915,10 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_UNSIGNED_INT_8_8_8_8_REV 0x8367
 #define GL_UNSIGNED_INT_2_10_10_10_REV 0x8368
 #define GL_MIRRORED_REPEAT 0x8370
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
 #define GL_FOG_COORDINATE_SOURCE 0x8450
 #define GL_FOG_COORD_SRC 0x8450
 #define GL_FOG_COORDINATE 0x8451
@@ -1034,8 +1061,11 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_COMPRESSED_TEXTURE_FORMATS 0x86A3
 #define GL_DOT3_RGB 0x86AE
 #define GL_DOT3_RGBA 0x86AF
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
 #define GL_BUFFER_SIZE 0x8764
 #define GL_BUFFER_USAGE 0x8765
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
 #define GL_STENCIL_BACK_FUNC 0x8800
 #define GL_STENCIL_BACK_FAIL 0x8801
 #define GL_STENCIL_BACK_PASS_DEPTH_FAIL 0x8802
@@ -1128,6 +1158,7 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_DEPTH24_STENCIL8 0x88F0
 #define GL_TEXTURE_STENCIL_SIZE 0x88F1
 #define GL_VERTEX_ATTRIB_ARRAY_INTEGER 0x88FD
+#define GL_VERTEX_ATTRIB_ARRAY_DIVISOR_ARB 0x88FE
 #define GL_MAX_ARRAY_TEXTURE_LAYERS 0x88FF
 #define GL_MIN_PROGRAM_TEXEL_OFFSET 0x8904
 #define GL_MAX_PROGRAM_TEXEL_OFFSET 0x8905
@@ -1262,6 +1293,10 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_COMPRESSED_SRGB_ALPHA 0x8C49
 #define GL_COMPRESSED_SLUMINANCE 0x8C4A
 #define GL_COMPRESSED_SLUMINANCE_ALPHA 0x8C4B
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT 0x8C4E
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
 #define GL_TRANSFORM_FEEDBACK_VARYING_MAX_LENGTH 0x8C76
 #define GL_TRANSFORM_FEEDBACK_BUFFER_MODE 0x8C7F
 #define GL_MAX_TRANSFORM_FEEDBACK_SEPARATE_COMPONENTS 0x8C80
@@ -1400,6 +1435,11 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_QUERY_NO_WAIT 0x8E14
 #define GL_QUERY_BY_REGION_WAIT 0x8E15
 #define GL_QUERY_BY_REGION_NO_WAIT 0x8E16
+#define GL_TEXTURE_SWIZZLE_R 0x8E42
+#define GL_TEXTURE_SWIZZLE_G 0x8E43
+#define GL_TEXTURE_SWIZZLE_B 0x8E44
+#define GL_TEXTURE_SWIZZLE_A 0x8E45
+#define GL_TEXTURE_SWIZZLE_RGBA 0x8E46
 #define GL_QUADS_FOLLOW_PROVOKING_VERTEX_CONVENTION 0x8E4C
 #define GL_FIRST_VERTEX_CONVENTION 0x8E4D
 #define GL_LAST_VERTEX_CONVENTION 0x8E4E
@@ -1408,6 +1448,10 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_SAMPLE_MASK 0x8E51
 #define GL_SAMPLE_MASK_VALUE 0x8E52
 #define GL_MAX_SAMPLE_MASK_WORDS 0x8E59
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#define GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT 0x8E8E
+#define GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT 0x8E8F
 #define GL_COPY_READ_BUFFER 0x8F36
 #define GL_COPY_WRITE_BUFFER 0x8F37
 #define GL_R8_SNORM 0x8F94
@@ -1471,6 +1515,12 @@ typedef void (GLAPIENTRY *GLDEBUGPROCKHR)(GLenum source,GLenum type,GLuint id,GL
 #define GL_DEBUG_SEVERITY_MEDIUM_KHR 0x9147
 #define GL_DEBUG_SEVERITY_LOW 0x9148
 #define GL_DEBUG_SEVERITY_LOW_KHR 0x9148
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#define GL_COMPRESSED_SRGB8_ETC2 0x9275
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#define GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9277
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#define GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC 0x9279
 #define GL_DEBUG_OUTPUT 0x92E0
 #define GL_DEBUG_OUTPUT_KHR 0x92E0
 
@@ -1503,6 +1553,7 @@ typedef void  (GLAPIENTRY *PFNGLBLENDFUNCPROC)(GLenum, GLenum);
 typedef void  (GLAPIENTRY *PFNGLBLENDFUNCSEPARATEPROC)(GLenum, GLenum, GLenum, GLenum);
 typedef void  (GLAPIENTRY *PFNGLBLITFRAMEBUFFERPROC)(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum);
 typedef void  (GLAPIENTRY *PFNGLBUFFERDATAPROC)(GLenum, GLsizeiptr, const void *, GLenum);
+typedef void  (GLAPIENTRY *PFNGLBUFFERSTORAGEPROC)(GLenum, GLsizeiptr, const void *, GLbitfield);
 typedef void  (GLAPIENTRY *PFNGLBUFFERSUBDATAPROC)(GLenum, GLintptr, GLsizeiptr, const void *);
 typedef void  (GLAPIENTRY *PFNGLCALLLISTPROC)(GLuint);
 typedef void  (GLAPIENTRY *PFNGLCALLLISTSPROC)(GLsizei, GLenum, const void *);
@@ -1708,6 +1759,7 @@ typedef void  (GLAPIENTRY *PFNGLGETPIXELMAPUSVPROC)(GLenum, GLushort *);
 typedef void  (GLAPIENTRY *PFNGLGETPOINTERVPROC)(GLenum, void **);
 typedef void  (GLAPIENTRY *PFNGLGETPOINTERVKHRPROC)(GLenum, void **);
 typedef void  (GLAPIENTRY *PFNGLGETPOLYGONSTIPPLEPROC)(GLubyte *);
+typedef void  (GLAPIENTRY *PFNGLGETPROGRAMBINARYPROC)(GLuint, GLsizei, GLsizei *, GLenum *, void *);
 typedef void  (GLAPIENTRY *PFNGLGETPROGRAMINFOLOGPROC)(GLuint, GLsizei, GLsizei *, GLchar *);
 typedef void  (GLAPIENTRY *PFNGLGETPROGRAMIVPROC)(GLuint, GLenum, GLint *);
 typedef void  (GLAPIENTRY *PFNGLGETQUERYOBJECTIVPROC)(GLuint, GLenum, GLint *);
@@ -1887,6 +1939,8 @@ typedef void  (GLAPIENTRY *PFNGLPOPMATRIXPROC)(void);
 typedef void  (GLAPIENTRY *PFNGLPOPNAMEPROC)(void);
 typedef void  (GLAPIENTRY *PFNGLPRIMITIVERESTARTINDEXPROC)(GLuint);
 typedef void  (GLAPIENTRY *PFNGLPRIORITIZETEXTURESPROC)(GLsizei, const GLuint *, const GLfloat *);
+typedef void  (GLAPIENTRY *PFNGLPROGRAMBINARYPROC)(GLuint, GLenum, const void *, GLsizei);
+typedef void  (GLAPIENTRY *PFNGLPROGRAMPARAMETERIPROC)(GLuint, GLenum, GLint);
 typedef void  (GLAPIENTRY *PFNGLPROVOKINGVERTEXPROC)(GLenum);
 typedef void  (GLAPIENTRY *PFNGLPUSHATTRIBPROC)(GLbitfield);
 typedef void  (GLAPIENTRY *PFNGLPUSHCLIENTATTRIBPROC)(GLbitfield);
@@ -2122,6 +2176,7 @@ typedef void  (GLAPIENTRY *PFNGLVERTEXATTRIB4SVPROC)(GLuint, const GLshort *);
 typedef void  (GLAPIENTRY *PFNGLVERTEXATTRIB4UBVPROC)(GLuint, const GLubyte *);
 typedef void  (GLAPIENTRY *PFNGLVERTEXATTRIB4UIVPROC)(GLuint, const GLuint *);
 typedef void  (GLAPIENTRY *PFNGLVERTEXATTRIB4USVPROC)(GLuint, const GLushort *);
+typedef void  (GLAPIENTRY *PFNGLVERTEXATTRIBDIVISORARBPROC)(GLuint, GLuint);
 typedef void  (GLAPIENTRY *PFNGLVERTEXATTRIBI1IPROC)(GLuint, GLint);
 typedef void  (GLAPIENTRY *PFNGLVERTEXATTRIBI1IVPROC)(GLuint, const GLint *);
 typedef void  (GLAPIENTRY *PFNGLVERTEXATTRIBI1UIPROC)(GLuint, GLuint);
@@ -2191,6 +2246,7 @@ extern PFNGLBLENDFUNCPROC greg_glBlendFunc;
 extern PFNGLBLENDFUNCSEPARATEPROC greg_glBlendFuncSeparate;
 extern PFNGLBLITFRAMEBUFFERPROC greg_glBlitFramebuffer;
 extern PFNGLBUFFERDATAPROC greg_glBufferData;
+extern PFNGLBUFFERSTORAGEPROC greg_glBufferStorage;
 extern PFNGLBUFFERSUBDATAPROC greg_glBufferSubData;
 extern PFNGLCALLLISTPROC greg_glCallList;
 extern PFNGLCALLLISTSPROC greg_glCallLists;
@@ -2396,6 +2452,7 @@ extern PFNGLGETPIXELMAPUSVPROC greg_glGetPixelMapusv;
 extern PFNGLGETPOINTERVPROC greg_glGetPointerv;
 extern PFNGLGETPOINTERVKHRPROC greg_glGetPointervKHR;
 extern PFNGLGETPOLYGONSTIPPLEPROC greg_glGetPolygonStipple;
+extern PFNGLGETPROGRAMBINARYPROC greg_glGetProgramBinary;
 extern PFNGLGETPROGRAMINFOLOGPROC greg_glGetProgramInfoLog;
 extern PFNGLGETPROGRAMIVPROC greg_glGetProgramiv;
 extern PFNGLGETQUERYOBJECTIVPROC greg_glGetQueryObjectiv;
@@ -2575,6 +2632,8 @@ extern PFNGLPOPMATRIXPROC greg_glPopMatrix;
 extern PFNGLPOPNAMEPROC greg_glPopName;
 extern PFNGLPRIMITIVERESTARTINDEXPROC greg_glPrimitiveRestartIndex;
 extern PFNGLPRIORITIZETEXTURESPROC greg_glPrioritizeTextures;
+extern PFNGLPROGRAMBINARYPROC greg_glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC greg_glProgramParameteri;
 extern PFNGLPROVOKINGVERTEXPROC greg_glProvokingVertex;
 extern PFNGLPUSHATTRIBPROC greg_glPushAttrib;
 extern PFNGLPUSHCLIENTATTRIBPROC greg_glPushClientAttrib;
@@ -2810,6 +2869,7 @@ extern PFNGLVERTEXATTRIB4SVPROC greg_glVertexAttrib4sv;
 extern PFNGLVERTEXATTRIB4UBVPROC greg_glVertexAttrib4ubv;
 extern PFNGLVERTEXATTRIB4UIVPROC greg_glVertexAttrib4uiv;
 extern PFNGLVERTEXATTRIB4USVPROC greg_glVertexAttrib4usv;
+extern PFNGLVERTEXATTRIBDIVISORARBPROC greg_glVertexAttribDivisorARB;
 extern PFNGLVERTEXATTRIBI1IPROC greg_glVertexAttribI1i;
 extern PFNGLVERTEXATTRIBI1IVPROC greg_glVertexAttribI1iv;
 extern PFNGLVERTEXATTRIBI1UIPROC greg_glVertexAttribI1ui;
@@ -2879,6 +2939,7 @@ extern PFNGLWINDOWPOS3SVPROC greg_glWindowPos3sv;
 #define glBlendFuncSeparate greg_glBlendFuncSeparate
 #define glBlitFramebuffer greg_glBlitFramebuffer
 #define glBufferData greg_glBufferData
+#define glBufferStorage greg_glBufferStorage
 #define glBufferSubData greg_glBufferSubData
 #define glCallList greg_glCallList
 #define glCallLists greg_glCallLists
@@ -3084,6 +3145,7 @@ extern PFNGLWINDOWPOS3SVPROC greg_glWindowPos3sv;
 #define glGetPointerv greg_glGetPointerv
 #define glGetPointervKHR greg_glGetPointervKHR
 #define glGetPolygonStipple greg_glGetPolygonStipple
+#define glGetProgramBinary greg_glGetProgramBinary
 #define glGetProgramInfoLog greg_glGetProgramInfoLog
 #define glGetProgramiv greg_glGetProgramiv
 #define glGetQueryObjectiv greg_glGetQueryObjectiv
@@ -3263,6 +3325,8 @@ extern PFNGLWINDOWPOS3SVPROC greg_glWindowPos3sv;
 #define glPopName greg_glPopName
 #define glPrimitiveRestartIndex greg_glPrimitiveRestartIndex
 #define glPrioritizeTextures greg_glPrioritizeTextures
+#define glProgramBinary greg_glProgramBinary
+#define glProgramParameteri greg_glProgramParameteri
 #define glProvokingVertex greg_glProvokingVertex
 #define glPushAttrib greg_glPushAttrib
 #define glPushClientAttrib greg_glPushClientAttrib
@@ -3498,6 +3562,7 @@ extern PFNGLWINDOWPOS3SVPROC greg_glWindowPos3sv;
 #define glVertexAttrib4ubv greg_glVertexAttrib4ubv
 #define glVertexAttrib4uiv greg_glVertexAttrib4uiv
 #define glVertexAttrib4usv greg_glVertexAttrib4usv
+#define glVertexAttribDivisorARB greg_glVertexAttribDivisorARB
 #define glVertexAttribI1i greg_glVertexAttribI1i
 #define glVertexAttribI1iv greg_glVertexAttribI1iv
 #define glVertexAttribI1ui greg_glVertexAttribI1ui
@@ -3609,8 +3674,16 @@ int GREG_VERSION_3_1;
 int GREG_VERSION_3_2;
 
 
+int GREG_ARB_ES3_compatibility;
+int GREG_ARB_buffer_storage;
+int GREG_ARB_get_program_binary;
+int GREG_ARB_instanced_arrays;
+int GREG_ARB_texture_compression_bptc;
 int GREG_ARB_texture_float;
+int GREG_ARB_texture_swizzle;
+int GREG_EXT_texture_compression_s3tc;
 int GREG_EXT_texture_filter_anisotropic;
+int GREG_EXT_texture_sRGB;
 int GREG_KHR_debug;
 
 
@@ -3641,6 +3714,7 @@ PFNGLBLENDFUNCPROC greg_glBlendFunc;
 PFNGLBLENDFUNCSEPARATEPROC greg_glBlendFuncSeparate;
 PFNGLBLITFRAMEBUFFERPROC greg_glBlitFramebuffer;
 PFNGLBUFFERDATAPROC greg_glBufferData;
+PFNGLBUFFERSTORAGEPROC greg_glBufferStorage;
 PFNGLBUFFERSUBDATAPROC greg_glBufferSubData;
 PFNGLCALLLISTPROC greg_glCallList;
 PFNGLCALLLISTSPROC greg_glCallLists;
@@ -3846,6 +3920,7 @@ PFNGLGETPIXELMAPUSVPROC greg_glGetPixelMapusv;
 PFNGLGETPOINTERVPROC greg_glGetPointerv;
 PFNGLGETPOINTERVKHRPROC greg_glGetPointervKHR;
 PFNGLGETPOLYGONSTIPPLEPROC greg_glGetPolygonStipple;
+PFNGLGETPROGRAMBINARYPROC greg_glGetProgramBinary;
 PFNGLGETPROGRAMINFOLOGPROC greg_glGetProgramInfoLog;
 PFNGLGETPROGRAMIVPROC greg_glGetProgramiv;
 PFNGLGETQUERYOBJECTIVPROC greg_glGetQueryObjectiv;
@@ -4025,6 +4100,8 @@ PFNGLPOPMATRIXPROC greg_glPopMatrix;
 PFNGLPOPNAMEPROC greg_glPopName;
 PFNGLPRIMITIVERESTARTINDEXPROC greg_glPrimitiveRestartIndex;
 PFNGLPRIORITIZETEXTURESPROC greg_glPrioritizeTextures;
+PFNGLPROGRAMBINARYPROC greg_glProgramBinary;
+PFNGLPROGRAMPARAMETERIPROC greg_glProgramParameteri;
 PFNGLPROVOKINGVERTEXPROC greg_glProvokingVertex;
 PFNGLPUSHATTRIBPROC greg_glPushAttrib;
 PFNGLPUSHCLIENTATTRIBPROC greg_glPushClientAttrib;
@@ -4260,6 +4337,7 @@ PFNGLVERTEXATTRIB4SVPROC greg_glVertexAttrib4sv;
 PFNGLVERTEXATTRIB4UBVPROC greg_glVertexAttrib4ubv;
 PFNGLVERTEXATTRIB4UIVPROC greg_glVertexAttrib4uiv;
 PFNGLVERTEXATTRIB4USVPROC greg_glVertexAttrib4usv;
+PFNGLVERTEXATTRIBDIVISORARBPROC greg_glVertexAttribDivisorARB;
 PFNGLVERTEXATTRIBI1IPROC greg_glVertexAttribI1i;
 PFNGLVERTEXATTRIBI1IVPROC greg_glVertexAttribI1iv;
 PFNGLVERTEXATTRIBI1UIPROC greg_glVertexAttribI1ui;
@@ -4520,6 +4598,7 @@ GREGDEF int gregInit(void)
   greg_glBlendFuncSeparate = (PFNGLBLENDFUNCSEPARATEPROC) gregGetProcAddress("glBlendFuncSeparate");
   greg_glBlitFramebuffer = (PFNGLBLITFRAMEBUFFERPROC) gregGetProcAddress("glBlitFramebuffer");
   greg_glBufferData = (PFNGLBUFFERDATAPROC) gregGetProcAddress("glBufferData");
+  greg_glBufferStorage = (PFNGLBUFFERSTORAGEPROC) gregGetProcAddress("glBufferStorage");
   greg_glBufferSubData = (PFNGLBUFFERSUBDATAPROC) gregGetProcAddress("glBufferSubData");
   greg_glCallList = (PFNGLCALLLISTPROC) gregGetProcAddress("glCallList");
   greg_glCallLists = (PFNGLCALLLISTSPROC) gregGetProcAddress("glCallLists");
@@ -4725,6 +4804,7 @@ GREGDEF int gregInit(void)
   greg_glGetPointerv = (PFNGLGETPOINTERVPROC) gregGetProcAddress("glGetPointerv");
   greg_glGetPointervKHR = (PFNGLGETPOINTERVKHRPROC) gregGetProcAddress("glGetPointervKHR");
   greg_glGetPolygonStipple = (PFNGLGETPOLYGONSTIPPLEPROC) gregGetProcAddress("glGetPolygonStipple");
+  greg_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC) gregGetProcAddress("glGetProgramBinary");
   greg_glGetProgramInfoLog = (PFNGLGETPROGRAMINFOLOGPROC) gregGetProcAddress("glGetProgramInfoLog");
   greg_glGetProgramiv = (PFNGLGETPROGRAMIVPROC) gregGetProcAddress("glGetProgramiv");
   greg_glGetQueryObjectiv = (PFNGLGETQUERYOBJECTIVPROC) gregGetProcAddress("glGetQueryObjectiv");
@@ -4904,6 +4984,8 @@ GREGDEF int gregInit(void)
   greg_glPopName = (PFNGLPOPNAMEPROC) gregGetProcAddress("glPopName");
   greg_glPrimitiveRestartIndex = (PFNGLPRIMITIVERESTARTINDEXPROC) gregGetProcAddress("glPrimitiveRestartIndex");
   greg_glPrioritizeTextures = (PFNGLPRIORITIZETEXTURESPROC) gregGetProcAddress("glPrioritizeTextures");
+  greg_glProgramBinary = (PFNGLPROGRAMBINARYPROC) gregGetProcAddress("glProgramBinary");
+  greg_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC) gregGetProcAddress("glProgramParameteri");
   greg_glProvokingVertex = (PFNGLPROVOKINGVERTEXPROC) gregGetProcAddress("glProvokingVertex");
   greg_glPushAttrib = (PFNGLPUSHATTRIBPROC) gregGetProcAddress("glPushAttrib");
   greg_glPushClientAttrib = (PFNGLPUSHCLIENTATTRIBPROC) gregGetProcAddress("glPushClientAttrib");
@@ -5139,6 +5221,7 @@ GREGDEF int gregInit(void)
   greg_glVertexAttrib4ubv = (PFNGLVERTEXATTRIB4UBVPROC) gregGetProcAddress("glVertexAttrib4ubv");
   greg_glVertexAttrib4uiv = (PFNGLVERTEXATTRIB4UIVPROC) gregGetProcAddress("glVertexAttrib4uiv");
   greg_glVertexAttrib4usv = (PFNGLVERTEXATTRIB4USVPROC) gregGetProcAddress("glVertexAttrib4usv");
+  greg_glVertexAttribDivisorARB = (PFNGLVERTEXATTRIBDIVISORARBPROC) gregGetProcAddress("glVertexAttribDivisorARB");
   greg_glVertexAttribI1i = (PFNGLVERTEXATTRIBI1IPROC) gregGetProcAddress("glVertexAttribI1i");
   greg_glVertexAttribI1iv = (PFNGLVERTEXATTRIBI1IVPROC) gregGetProcAddress("glVertexAttribI1iv");
   greg_glVertexAttribI1ui = (PFNGLVERTEXATTRIBI1UIPROC) gregGetProcAddress("glVertexAttribI1ui");
@@ -5201,8 +5284,16 @@ GREGDEF int gregInit(void)
   GREG_VERSION_3_2 = gregVersionSupported(3, 2);
 
 
+  GREG_ARB_ES3_compatibility = gregExtensionSupported("GL_ARB_ES3_compatibility");
+  GREG_ARB_buffer_storage = gregExtensionSupported("GL_ARB_buffer_storage");
+  GREG_ARB_get_program_binary = gregExtensionSupported("GL_ARB_get_program_binary");
+  GREG_ARB_instanced_arrays = gregExtensionSupported("GL_ARB_instanced_arrays");
+  GREG_ARB_texture_compression_bptc = gregExtensionSupported("GL_ARB_texture_compression_bptc");
   GREG_ARB_texture_float = gregExtensionSupported("GL_ARB_texture_float");
+  GREG_ARB_texture_swizzle = gregExtensionSupported("GL_ARB_texture_swizzle");
+  GREG_EXT_texture_compression_s3tc = gregExtensionSupported("GL_EXT_texture_compression_s3tc");
   GREG_EXT_texture_filter_anisotropic = gregExtensionSupported("GL_EXT_texture_filter_anisotropic");
+  GREG_EXT_texture_sRGB = gregExtensionSupported("GL_EXT_texture_sRGB");
   GREG_KHR_debug = gregExtensionSupported("GL_KHR_debug");
 
 
@@ -41,10 +41,66 @@ GLboolean getBoolean(GLenum token);
 GLint getInteger(GLenum token);
 GLfloat getFloat(GLenum token);
 
+/*! Allocates storage for a stream buffer bound to the specified target.
+ *  @return The persistent mapping of the buffer, or @c nullptr if the buffer
+ *  has to be mapped for each write.
+ */
+void* initStreamStorage(GLenum target, size_t size);
+/*! Writes to a fenced range of a stream buffer bound to the specified target.
+ */
+void writeStream(GLenum target,
+                 void* mapping,
+                 size_t offset,
+                 size_t size,
+                 const void* source);
+
+/*! @return The 64-bit FNV-1a hash of the specified string, continuing from
+ *  the specified hash.
+ */
+uint64 hashString(const std::string& string,
+                  uint64 hash = 14695981039346656037ull);
+
+/*! Shader text tokenized up to each of its include and version directives.
+ */
+class PreprocessedUnit
+{
+public:
+  enum DirectiveType
+  {
+    NO_DIRECTIVE,
+    INCLUDE_DIRECTIVE,
+    VERSION_DIRECTIVE
+  };
+  struct Segment
+  {
+    std::string text;
+    DirectiveType type;
+    std::string argument;
+    uint line;
+  };
+  std::vector<Segment> segments;
+};
+
+/*! Preprocessed units shared by all shaders of a context.  Files are looked
+ *  up by path, so each is only read once, and units by content hash, so
+ *  identical text is only tokenized once.
+ */
+class PreprocessorCache
+{
+public:
+  const PreprocessedUnit* findFile(const Path& path) const;
+  const PreprocessedUnit* findUnit(uint64 hash) const;
+  void addFile(const Path& path, const PreprocessedUnit& unit);
+  const PreprocessedUnit& addUnit(uint64 hash, PreprocessedUnit&& unit);
+private:
+  std::unordered_map<std::string, const PreprocessedUnit*> m_files;
+  std::unordered_map<uint64, std::unique_ptr<PreprocessedUnit>> m_units;
+};
+
 class Preprocessor
 {
 public:
-  Preprocessor(ResourceCache& cache);
+  Preprocessor(ResourceCache& cache, PreprocessorCache& units);
   void parse(const char* name);
   void parse(const char* name, const char* text);
   bool hasVersion() const;
@@ -53,6 +109,10 @@ public:
   const std::string& names() const { return m_list; }
   const std::vector<Path>& paths() const { return m_paths; }
 private:
+  PreprocessedUnit tokenize(const char* name, const char* text);
+  void emit(const char* name, const PreprocessedUnit& unit);
+  void addDirective(PreprocessedUnit::DirectiveType type,
+                    const std::string& argument);
   void addLine();
   void advance(size_t offset);
   void discard();
@@ -81,6 +141,8 @@ private:
   void setFirstOnLine(bool newState);
   class File;
   ResourceCache& m_cache;
+  PreprocessorCache& m_units;
+  PreprocessedUnit* m_unit;
   std::vector<File> m_files;
   std::vector<std::string> m_names;
   std::vector<Path> m_paths;
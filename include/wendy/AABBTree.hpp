@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+namespace wendy
+{
+
+class AABB;
+class Sphere;
+class Frustum;
+
+/*! @brief Dynamic bounding volume hierarchy.
+ *
+ *  This is an incrementally maintained binary tree of axis-aligned bounding
+ *  boxes, where each leaf is a proxy for an object owned by the user.  Leaf
+ *  boxes are enlarged slightly so that small movements don't require the
+ *  proxy to be reinserted, and the tree is kept balanced with rotations as
+ *  proxies are inserted and removed.
+ *
+ *  Queries are conservative, i.e. they return every proxy whose enlarged
+ *  bounds may intersect the query volume, and callers are expected to
+ *  perform any exact tests on the returned proxies.
+ */
+class AABBTree
+{
+public:
+  /*! Constructor.
+   */
+  AABBTree();
+  /*! Creates a proxy with the specified bounds.
+   *  @param[in] bounds The bounds of the object.
+   *  @param[in] data The user data to associate with the proxy.
+   *  @return The newly created proxy.
+   */
+  uint createProxy(const AABB& bounds, void* data);
+  /*! Destroys the specified proxy.
+   */
+  void destroyProxy(uint proxy);
+  /*! Updates the bounds of the specified proxy, reinserting it if the new
+   *  bounds are outside its enlarged bounds.
+   *  @return @c true if the proxy was reinserted, or @c false otherwise.
+   */
+  bool moveProxy(uint proxy, const AABB& bounds);
+  /*! @return The user data associated with the specified proxy.
+   */
+  void* proxyData(uint proxy) const { return m_nodes[proxy].data; }
+  /*! Collects the user data of all proxies that may intersect the specified
+   *  frustum.
+   */
+  void query(const Frustum& frustum, std::vector<void*>& results) const;
+  /*! Collects the user data of all proxies that may intersect the specified
+   *  sphere.
+   */
+  void query(const Sphere& sphere, std::vector<void*>& results) const;
+  /*! @return The height of the tree, or zero if it's empty.
+   */
+  uint height() const;
+  /*! @return The number of proxies in the tree.
+   */
+  uint proxyCount() const { return m_proxyCount; }
+private:
+  class Node
+  {
+  public:
+    bool isLeaf() const { return children[0] == NO_NODE; }
+    vec3 minimum;
+    vec3 maximum;
+    uint parent;
+    uint children[2];
+    int height;
+    void* data;
+  };
+  enum { NO_NODE = 0xffffffff };
+  uint allocateNode();
+  void freeNode(uint index);
+  void insertLeaf(uint leaf);
+  void removeLeaf(uint leaf);
+  uint balance(uint index);
+  void refit(uint index);
+  void setLeafBounds(uint leaf, const AABB& bounds);
+  std::vector<Node> m_nodes;
+  uint m_root;
+  uint m_free;
+  uint m_proxyCount;
+};
+
+} /*namespace wendy*/
+
@@ -39,7 +39,7 @@ class AudioContext;
 /*! @brief Audio sample data buffer.
  *  @ingroup audio
  */
-class AudioBuffer : public Resource, public RefObject
+class AudioBuffer : public AtomicRefObject, public Resource
 {
   friend class AudioSource;
 public:
@@ -68,6 +68,12 @@ public:
                                  AudioContext& context,
                                  const Sample& data);
   static Ref<AudioBuffer> read(AudioContext& context, const std::string& sampleName);
+  /*! Decodes the specified sample on a worker thread and creates a buffer
+   *  from it during a later call to ResourceCache::finishLoads.
+   *  @see ResourceCache::loadAsync
+   */
+  static AsyncResource<AudioBuffer> readAsync(AudioContext& context,
+                                              const std::string& sampleName);
 private:
   AudioBuffer(const ResourceInfo& info, AudioContext& context);
   AudioBuffer(const AudioBuffer&) = delete;
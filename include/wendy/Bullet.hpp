@@ -57,7 +57,7 @@ btTriangleMesh* convert(const Mesh& mesh);
 
 /*! @ingroup bullet
  */
-class BvhTriangleMeshShape : public Resource, public RefObject
+class BvhTriangleMeshShape : public AtomicRefObject, public Resource
 {
 public:
   btTriangleMesh& mesh() { return *m_mesh; }
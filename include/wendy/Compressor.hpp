@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+namespace wendy
+{
+
+/*! Creates a mipmapped copy of the specified image, filtering each level down
+ *  from the one above it with a box filter.
+ *  @param[in] image The image to use as the top level.  It must be an
+ *  uncompressed two-dimensional image with eight-bit channels.
+ *  @return The mipmapped image, or @c nullptr if an error occurred.
+ */
+Ref<Image> createMipmaps(const Image& image);
+
+/*! Compresses the specified image, including any mipmap levels, into the
+ *  specified block compressed pixel format.
+ *  @param[in] image The image to compress.  It must be an uncompressed
+ *  two-dimensional image with eight-bit channels and the same semantic as
+ *  @c format, except that RGBA images may be compressed to
+ *  PixelFormat::RGB_BC1 by discarding their alpha.
+ *  @param[in] format The desired pixel format, which must be one of
+ *  PixelFormat::RGB_BC1, PixelFormat::RGBA_BC3, PixelFormat::L_BC4 and
+ *  PixelFormat::LA_BC5.
+ *  @return The compressed image, or @c nullptr if an error occurred.
+ */
+Ref<Image> compressImage(const Image& image, const PixelFormat& format);
+
+/*! Decompresses the specified image, including any mipmap levels, into the
+ *  eight-bit pixel format with the same semantic.
+ *  @param[in] image The image to decompress.  Its pixel format must be one of
+ *  those supported by @ref compressImage.
+ *  @return The decompressed image, or @c nullptr if an error occurred.
+ */
+Ref<Image> decompressImage(const Image& image);
+
+/*! @return The peak signal-to-noise ratio, in decibels, between the specified
+ *  images across all their mipmap levels, infinity if they are identical, or
+ *  a negative value if they cannot be compared.
+ *
+ *  @remarks The images must have the same dimensions, number of mipmap levels
+ *  and uncompressed eight-bit pixel format.
+ */
+double computePSNR(const Image& a, const Image& b);
+
+} /*namespace wendy*/
+
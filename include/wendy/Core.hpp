@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -104,6 +105,7 @@ WENDY_CHECKFORMAT(1, std::string format(const char* format, ...));
 std::string vlformat(const char* format, va_list vl);
 
 class RefObject;
+class AtomicRefObject;
 
 /*! Log entry type enumeration.
   */
@@ -138,6 +140,32 @@ WENDY_CHECKFORMAT(1, void logWarning(const char* format, ...));
  */
 WENDY_CHECKFORMAT(1, void log(const char* format, ...));
 
+/*! Sets the least important log entry type to be written.  Messages of less
+ *  important types are discarded before being formatted.
+ *  @param[in] newLevel The desired log level.
+ */
+void setLogLevel(LogEntryType newLevel);
+
+/*! @return The least important log entry type that is written.
+ */
+LogEntryType logLevel();
+
+/*! @return @c true if log entries of the specified type are written,
+ *  otherwise @c false.
+ */
+bool isLogEnabled(LogEntryType type);
+
+/*! Blocks until all log entries written so far have been delivered to the log
+ *  consumers or to stderr.  Consumers are called on the calling thread.
+ */
+void flushLog();
+
+/*! Delivers the log entries queued for the log consumers so far, on the
+ *  calling thread.  Unlike flushLog, this does not wait for entries still
+ *  being processed.
+ */
+void deliverLog();
+
 /*! Displays the specified message and terminates the program.
  */
 WENDY_CHECKFORMAT(1, WENDY_NORETURN(void panic(const char* format, ...)));
@@ -164,15 +192,21 @@ private:
 class RefBase
 {
 protected:
-  static bool unreferenced(RefObject* object);
   static void increment(RefObject* object);
-  static void decrement(RefObject* object);
+  static bool decrement(RefObject* object);
+  static void increment(AtomicRefObject* object);
+  static bool tryIncrement(AtomicRefObject* object);
+  static bool decrement(AtomicRefObject* object);
 };
 
 /*! @brief Super class for reference counted object.
  *
  *  @remarks No, there are no visible knobs on this class. Use the Ref class to
  *  point to objects derived from RefObject to enable reference counting.
+ *
+ *  @remarks The reference count of this class is not thread-safe.  Objects
+ *  that are referenced from more than one thread should derive from
+ *  AtomicRefObject instead.
  */
 class RefObject
 {
@@ -180,41 +214,111 @@ class RefObject
 public:
   /*! Constructor.
    */
-  RefObject();
+  RefObject(): count(0) { }
   /*! Copy constructor.
    */
-  RefObject(const RefObject& source);
+  RefObject(const RefObject&): count(0) { }
   /*! Destructor.
    */
   virtual ~RefObject();
   /*! Assignment operator.
    */
-  RefObject& operator = (const RefObject& source);
+  RefObject& operator = (const RefObject&) { return *this; }
 private:
   uint count;
 };
 
+/*! @brief Super class for reference counted objects shared between threads.
+ *
+ *  Identical to RefObject except that the reference count is atomic, making it
+ *  safe for Ref objects on different threads to point to the same object.
+ */
+class AtomicRefObject
+{
+  friend class RefBase;
+public:
+  /*! Constructor.
+   */
+  AtomicRefObject(): count(0) { }
+  /*! Copy constructor.
+   */
+  AtomicRefObject(const AtomicRefObject&): count(0) { }
+  /*! Destructor.
+   */
+  virtual ~AtomicRefObject();
+  /*! Assignment operator.
+   */
+  AtomicRefObject& operator = (const AtomicRefObject&) { return *this; }
+private:
+  std::atomic<uint> count;
+};
+
+inline void RefBase::increment(RefObject* object)
+{
+  object->count++;
+}
+
+inline bool RefBase::decrement(RefObject* object)
+{
+  return --object->count == 0;
+}
+
+inline void RefBase::increment(AtomicRefObject* object)
+{
+  // Releases the construction of the object to threads that later find it
+  // through a registry with tryIncrement
+  object->count.fetch_add(1, std::memory_order_release);
+}
+
+inline bool RefBase::tryIncrement(AtomicRefObject* object)
+{
+  uint count = object->count.load(std::memory_order_relaxed);
+
+  do
+  {
+    if (!count)
+      return false;
+  }
+  while (!object->count.compare_exchange_weak(count, count + 1,
+                                               std::memory_order_acquire,
+                                               std::memory_order_relaxed));
+
+  return true;
+}
+
+inline bool RefBase::decrement(AtomicRefObject* object)
+{
+  if (object->count.fetch_sub(1, std::memory_order_release) != 1)
+    return false;
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return true;
+}
+
 /*! @brief Smart reference.
  *
- *  Pointer to objects that inherit from RefObject.
+ *  Pointer to objects that inherit from RefObject or AtomicRefObject.
  */
 template <typename T>
 class Ref : public RefBase
 {
+  template <typename U> friend class Ref;
 public:
   /*! Default constructor.
    */
   Ref(T* object = nullptr):
-    m_object(nullptr)
+    m_object(object)
   {
-    operator = (object);
+    if (m_object)
+      increment(m_object);
   }
   /*! Copy constructor.
    */
   Ref(const Ref<T>& source):
-    m_object(nullptr)
+    m_object(source.m_object)
   {
-    operator = (source);
+    if (m_object)
+      increment(m_object);
   }
   /*! Move constructor.
    */
@@ -223,11 +327,20 @@ public:
   {
     source.m_object = nullptr;
   }
+  /*! Converting move constructor.  Takes over the reference without touching
+   *  the reference count.
+   */
+  template <typename U>
+  Ref(Ref<U>&& source):
+    m_object(source.m_object)
+  {
+    source.m_object = nullptr;
+  }
   /*! Destructor
    */
   ~Ref()
   {
-    operator = (nullptr);
+    release(m_object);
   }
   /*! Cast operator.
    */
@@ -248,13 +361,7 @@ public:
     if (newObject)
       increment(newObject);
 
-    if (m_object)
-    {
-      decrement(m_object);
-      if (unreferenced(m_object))
-        delete static_cast<RefObject*>(m_object);
-    }
-
+    release(m_object);
     m_object = newObject;
     return *this;
   }
@@ -268,8 +375,13 @@ public:
    */
   Ref<T>& operator = (Ref<T>&& source)
   {
-    operator = (nullptr);
-    std::swap(m_object, source.m_object);
+    if (this != &source)
+    {
+      release(m_object);
+      m_object = source.m_object;
+      source.m_object = nullptr;
+    }
+
     return *this;
   }
   /*! @return The currently owned object.
@@ -278,7 +390,27 @@ public:
   {
     return m_object;
   }
+  /*! @return A reference to the specified object, or an empty reference if
+   *  its last reference has already been released.
+   *
+   *  @remarks This is for objects that may be found through a registry while
+   *  another thread releases them.  The caller must keep the object from
+   *  being freed until this returns.
+   */
+  static Ref<T> acquire(T* object)
+  {
+    Ref<T> result;
+    if (object && tryIncrement(object))
+      result.m_object = object;
+
+    return result;
+  }
 private:
+  static void release(T* object)
+  {
+    if (object && decrement(object))
+      delete object;
+  }
   T* m_object;
 };
 
@@ -286,6 +418,14 @@ private:
  *
  *  All instances of this class are added to an internal list of consumers and
  *  are notified of %log messages until destroyed.
+ *
+ *  @remarks Log entries are queued by the logging thread and held until
+ *  flushLog or deliverLog is called, so @c onLogEntry is normally called on
+ *  the threads calling those.  Window::update and RenderContext::finishFrame
+ *  call deliverLog once per frame.  Entries left undelivered for a second are
+ *  delivered on the logging thread instead.
+ *  Consumers may log, but must not flush the log or destroy consumers from
+ *  within @c onLogEntry.
  */
 class LogConsumer
 {
@@ -293,7 +433,8 @@ public:
   /*! Constructor.
    */
   LogConsumer();
-  /*! Destructor.
+  /*! Destructor.  Delivers all pending log entries to the remaining
+   *  consumers before returning.
    */
   virtual ~LogConsumer();
   /*! Called for each message generated by log, logWarning and logError.
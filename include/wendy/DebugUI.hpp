@@ -44,12 +44,19 @@ public:
   Interface(Window& window, Drawer& drawer);
   void update();
   void draw();
+  /*! Sets the path that Chrome traces captured through this interface are
+   *  written to.
+   */
+  void setTracePath(const Path& newPath) { tracePath = newPath; }
 private:
   enum Item
   {
     ITEM_FRAMERATE,
     ITEM_STATECHANGES,
     ITEM_OPERATIONS,
+    ITEM_FLUSHES,
+    ITEM_SKIPPEDUNIFORMS,
+    ITEM_SKIPPEDTEXTURES,
     ITEM_VERTICES,
     ITEM_POINTS,
     ITEM_LINES,
@@ -62,8 +69,11 @@ private:
   };
   void updateCountItem(Item item, const char* unit, size_t count);
   void updateCountSizeItem(Item item, const char* unit, size_t count, size_t size);
+  void onTraceButtonPushed(Button& button);
   Panel* root;
   Label* labels[ITEM_COUNT];
+  Button* traceButton;
+  Path tracePath;
 };
 
   } /*namespace debug*/
@@ -87,7 +87,7 @@ public:
 
 /*! @ingroup ui
  */
-class Theme : public Resource, public RefObject
+class Theme : public AtomicRefObject, public Resource
 {
   friend class Drawer;
   friend class ThemeReader;
@@ -118,12 +118,21 @@ private:
  *  @ingroup ui
  *
  *  This class provides drawing for widgets.
+ *
+ *  Drawing calls are accumulated into a batch, which is rendered when the
+ *  pass, texture or primitive type changes and at the end of drawing.  The
+ *  clip area is applied to the geometry as it is added, so changing it does
+ *  not break the batch.
  */
 class Drawer
 {
 public:
   void begin();
   void end();
+  /*! Renders any geometry batched so far.  Call this before rendering
+   *  other than through this drawer between begin and end.
+   */
+  void flush();
   /*! Pushes a clipping area onto the clip stack. The current
    *  clipping area then becomes the specified area as clipped by the
    *  previously current clipping area.
@@ -174,22 +183,24 @@ private:
   Drawer(RenderContext& context);
   bool init();
   void drawElement(const Rect& area, const Rect& mapping);
-  void setDrawingState(vec4 color, bool wireframe);
+  void setBatch(Pass& pass, Texture* texture, PrimitiveType type);
+  void addVertex(vec2 position, vec4 color);
+  void addQuad(const Rect& area, const Rect& mapping, vec4 color);
   RenderContext& m_context;
   Ref<Theme> m_theme;
-  Ref<VertexBuffer> m_vertexBuffer;
-  Ref<IndexBuffer> m_indexBuffer;
   Ref<SharedProgramState> m_state;
   Ref<Font> m_font;
   RectClipStackf m_clipAreaStack;
-  PrimitiveRange m_range;
   Pass m_drawPass;
   Pass m_blitPass;
   Pass m_elementPass;
-  UniformStateIndex m_elementPosIndex;
-  UniformStateIndex m_elementSizeIndex;
-  UniformStateIndex m_texPosIndex;
-  UniformStateIndex m_texSizeIndex;
+  Pass m_textPass;
+  Pass* m_batchPass;
+  Ref<Texture> m_batchTexture;
+  PrimitiveType m_batchType;
+  std::vector<Vertex4fc2ft2fv> m_vertices;
+  std::vector<uint32> m_indices;
+  std::vector<GlyphQuad> m_quads;
 };
 
 } /*namespace wendy*/
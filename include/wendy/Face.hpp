@@ -32,7 +32,7 @@ namespace wendy
 
 /*! @brief TrueType typeface.
  */
-class Face : public Resource, public RefObject
+class Face : public AtomicRefObject, public Resource
 {
 public:
   ~Face();
@@ -33,20 +33,60 @@
 #include <wendy/Image.hpp>
 #include <wendy/Face.hpp>
 
+#include <unordered_map>
+
 namespace wendy
 {
 
+/*! @brief Screen and texture space areas of a single realized glyph.
+ */
+class GlyphQuad
+{
+public:
+  /*! The area covered by the glyph, in pixels relative to the pen origin.
+   */
+  Rect area;
+  /*! The area of the glyph in the glyph texture page of its font, in texels.
+   */
+  Rect mapping;
+  /*! The index of the glyph texture page holding the glyph.
+   */
+  uint page;
+};
+
 /*! @brief %Font layout and rendering object.
  *
  *  This class provides layout and rendering of a single font.
+ *
+ *  Glyphs are rendered on demand and shelf-packed into fixed-size glyph
+ *  texture pages, which are updated in place.  When all pages are full, the
+ *  least recently used glyph slot large enough for the new glyph is reused.
+ *  Glyphs used during the current frame are never evicted.
  */
-class Font : public Resource, public RefObject
+class Font : public AtomicRefObject, public Resource
 {
 public:
   /*! Renders the specified text at the current pen position.
    *  @param text The text to render.
    */
   void drawText(vec2 pen, vec4 color, const char* text);
+  /*! Realizes the glyphs of the specified text at the specified pen
+   *  position, adding any missing glyphs to the glyph texture.
+   *  @param[in] pen The pen position to start at.
+   *  @param[in] text The text to realize.
+   *  @param[out] quads The areas of the visible glyphs of the text.
+   *
+   *  @remarks This allows text to be batched with other geometry.  Realize
+   *  the text before retrieving the glyph texture pages, as adding glyphs
+   *  may add pages.
+   */
+  void realizeText(vec2 pen, const char* text, std::vector<GlyphQuad>& quads);
+  /*! @return The rectangle texture of the specified glyph texture page.
+   */
+  Texture& texture(uint page) const;
+  /*! @return The number of glyph texture pages of this font.
+   */
+  uint pageCount() const { return uint(m_pages.size()); }
   /*! @return The ascender for this font.
    */
   float ascender() const { return m_ascender; }
@@ -84,27 +124,35 @@ public:
   static Ref<Font> read(RenderContext& context, const std::string& name);
 private:
   class Glyph;
+  class GlyphSlot;
+  class GlyphPage;
   Font(const ResourceInfo& info, RenderContext& context);
   Font(const Font&) = delete;
   bool init(Face& font, uint height);
   const Glyph* addGlyph(uint32 codepoint);
   const Glyph* findGlyph(uint32 codepoint);
-  bool addGlyphTextureRow();
+  uint allocateSlot(ivec2 size);
+  uint evictSlot(ivec2 size);
+  bool addGlyphPage();
   Font& operator = (const Font&) = delete;
   RenderContext& m_context;
   Ref<Face> m_face;
-  std::vector<Glyph> m_glyphs;
+  std::unordered_map<uint32, Glyph> m_glyphs;
+  std::vector<GlyphSlot> m_slots;
+  std::vector<GlyphPage> m_pages;
+  uint m_pageSize;
   float m_scale;
   float m_ascender;
   float m_descender;
   float m_leading;
   float m_width;
   float m_height;
-  ivec2 m_position;
-  Ref<Texture> m_texture;
   Pass m_pass;
   UniformStateIndex m_colorIndex;
+  UniformStateIndex m_glyphsIndex;
+  std::vector<GlyphQuad> m_quads;
   std::vector<Vertex2ft2fv> m_vertices;
+  std::vector<uint32> m_indices;
 };
 
 /*! @internal
@@ -112,19 +160,44 @@ private:
 class Font::Glyph
 {
 public:
-  bool operator < (const Glyph& other) const
-  {
-    return codepoint < other.codepoint;
-  }
-  bool operator == (uint32 desired) const
-  {
-    return codepoint == desired;
-  }
   vec2 offset;
   vec2 size;
   vec2 bearing;
   float advance;
   uint32 codepoint;
+  uint slot;
+  uint page;
+  uint lastUse;
+};
+
+/*! @internal
+ *  @brief Area of a glyph texture page holding a single glyph.
+ */
+class Font::GlyphSlot
+{
+public:
+  ivec2 position;
+  ivec2 size;
+  uint page;
+  uint32 codepoint;
+};
+
+/*! @internal
+ *  @brief Glyph texture page and its shelves.
+ */
+class Font::GlyphPage
+{
+public:
+  class Shelf
+  {
+  public:
+    int x;
+    int y;
+    int height;
+  };
+  Ref<Texture> texture;
+  std::vector<Shelf> shelves;
+  int top;
 };
 
 } /*namespace wendy*/
@@ -43,6 +43,52 @@ enum FrustumPlane
   FRUSTUM_FAR
 };
 
+/*! @brief Bounding spheres stored as a structure of arrays.
+ *
+ *  This is the input format for batch frustum culling.
+ */
+class SphereBatch
+{
+public:
+  /*! Removes all spheres from this batch.
+   */
+  void clear();
+  /*! Adds the specified sphere to this batch.
+   */
+  void add(const Sphere& sphere);
+  /*! @return The number of spheres in this batch.
+   */
+  size_t size() const { return radius.size(); }
+  std::vector<float> centerX;
+  std::vector<float> centerY;
+  std::vector<float> centerZ;
+  std::vector<float> radius;
+};
+
+/*! @brief Bounding boxes stored as a structure of arrays.
+ *
+ *  This is the input format for batch frustum culling.
+ */
+class AABBBatch
+{
+public:
+  /*! Removes all boxes from this batch.
+   */
+  void clear();
+  /*! Adds the specified bounding box to this batch.
+   */
+  void add(const AABB& box);
+  /*! @return The number of boxes in this batch.
+   */
+  size_t size() const { return sizeX.size(); }
+  std::vector<float> centerX;
+  std::vector<float> centerY;
+  std::vector<float> centerZ;
+  std::vector<float> sizeX;
+  std::vector<float> sizeY;
+  std::vector<float> sizeZ;
+};
+
 /*! @brief 3D view frustum.
  */
 class Frustum
@@ -79,6 +125,38 @@ public:
    *  @remarks Even partial intersection counts.
    */
   bool intersects(const AABB& box) const;
+  /*! Checks which of the specified spheres intersect this frustum.
+   *  @param[in] spheres The spheres to check.
+   *  @param[out] visible The resulting bit mask, where bit @c n of word
+   *  @c n/32 is set if sphere @c n intersects this frustum.
+   *
+   *  @remarks The results are identical to those of the single sphere
+   *  version, but several spheres are tested at once where SIMD instructions
+   *  are available.
+   */
+  void intersects(const SphereBatch& spheres, std::vector<uint32>& visible) const;
+  /*! Checks which of the specified bounding boxes intersect this frustum.
+   *  @param[in] boxes The bounding boxes to check.
+   *  @param[out] visible The resulting bit mask, where bit @c n of word
+   *  @c n/32 is set if box @c n intersects this frustum.
+   *
+   *  @remarks The results are identical to those of the single box version,
+   *  but several boxes are tested at once where SIMD instructions are
+   *  available.
+   */
+  void intersects(const AABBBatch& boxes, std::vector<uint32>& visible) const;
+  /*! Checks which of the specified volumes intersect this frustum, first
+   *  testing the spheres and then refining the result with the bounding boxes
+   *  of the volumes whose spheres intersect it.
+   *  @param[in] spheres The bounding spheres of the volumes.
+   *  @param[in] boxes The bounding boxes of the volumes.
+   *  @param[out] visible The resulting bit mask, where bit @c n of word
+   *  @c n/32 is set if both the sphere and box of volume @c n intersect this
+   *  frustum.
+   */
+  void intersects(const SphereBatch& spheres,
+                  const AABBBatch& boxes,
+                  std::vector<uint32>& visible) const;
   /*! Transforms the planes of this frustum by the specified transform.
    */
   void transformBy(const Transform3& transform);
@@ -25,7 +25,8 @@
 
 #pragma once
 
-#include <algorithm>
+#include <deque>
+#include <limits>
 
 namespace wendy
 {
@@ -37,44 +38,176 @@ enum IDBucket
   ID_BUCKET_UNUSED
 };
 
-/*! @brief Generic ID pool.
+/*! @brief Generational handle.
+ *
+ *  A handle is a slot index in a HandlePool together with the generation of
+ *  that slot when the handle was allocated.  Releasing a handle advances the
+ *  generation of its slot, so stale copies are detected instead of aliasing
+ *  whatever is allocated into the slot next.
  */
-template <typename T, uint margin = 100>
-class IDPool
+class Handle
 {
 public:
-  IDPool(T first = 0):
-    next(first)
+  Handle():
+    m_index(INVALID_INDEX),
+    m_generation(0)
   {
   }
-  T allocateID()
+  Handle(uint32 index, uint32 generation):
+    m_index(index),
+    m_generation(generation)
   {
-    if (released.size() > margin)
+  }
+  bool operator == (const Handle& other) const
+  {
+    return m_index == other.m_index && m_generation == other.m_generation;
+  }
+  bool operator != (const Handle& other) const
+  {
+    return !operator == (other);
+  }
+  /*! @return @c false if this is the null handle, otherwise @c true.
+   */
+  bool isNull() const { return m_index == INVALID_INDEX; }
+  uint32 index() const { return m_index; }
+  uint32 generation() const { return m_generation; }
+  static const uint32 INVALID_INDEX = 0xffffffff;
+private:
+  uint32 m_index;
+  uint32 m_generation;
+};
+
+/*! @brief Generational handle allocator.
+ *
+ *  Allocation, release and validation are all constant time.  Released slots
+ *  are reused in FIFO order, and only once more than @c margin of them are
+ *  free, to delay reuse of an index for as long as practical.  The live
+ *  handles are kept in a dense array for iteration.
+ */
+class HandlePool
+{
+public:
+  /*! Constructor.
+   *  @param[in] first The first index to allocate.  Indices below this are
+   *  reserved by the user and are never allocated.
+   *  @param[in] limit The index after the largest index to allocate.
+   *  @param[in] margin The number of released slots to keep before reusing
+   *  them.
+   */
+  HandlePool(uint32 first = 0,
+             uint32 limit = std::numeric_limits<uint32>::max(),
+             uint32 margin = 100):
+    m_first(first),
+    m_limit(limit),
+    m_margin(margin)
+  {
+  }
+  /*! Allocates a handle.
+   *  @return The allocated handle, or the null handle if all indices are in
+   *  use.
+   */
+  Handle allocate()
+  {
+    uint32 index;
+
+    if (m_released.size() > m_margin ||
+        (!m_released.empty() && m_first + m_slots.size() >= m_limit))
     {
-      const T id = released.back();
-      released.pop_back();
-      return id;
+      index = m_released.front();
+      m_released.pop_front();
     }
+    else if (m_first + m_slots.size() < m_limit)
+    {
+      index = m_first + uint32(m_slots.size());
+      m_slots.push_back(Slot{0, 0});
+    }
+    else
+      return Handle();
 
-    return next++;
+    Slot& slot = m_slots[index - m_first];
+    slot.dense = uint32(m_dense.size());
+
+    const Handle handle(index, slot.generation);
+    m_dense.push_back(handle);
+    return handle;
   }
-  void releaseID(T id)
+  /*! Releases the specified handle.  Releasing a stale or null handle is an
+   *  error and is ignored.
+   *  @return @c true if the handle was released, otherwise @c false.
+   */
+  bool release(Handle handle)
   {
-    released.insert(released.begin(), id);
+    if (!contains(handle))
+      return false;
+
+    Slot& slot = m_slots[handle.index() - m_first];
+
+    // Move the last live handle into the dense slot of the released one
+    const Handle last = m_dense.back();
+    m_dense[slot.dense] = last;
+    m_slots[last.index() - m_first].dense = slot.dense;
+    m_dense.pop_back();
+
+    slot.generation++;
+    m_released.push_back(handle.index());
+    return true;
   }
-  IDBucket bucketOf(T id)
+  /*! @return @c true if the specified handle is live, or @c false if it is
+   *  stale or null.
+   */
+  bool contains(Handle handle) const
   {
-    if (id >= next)
+    if (handle.index() < m_first || handle.index() - m_first >= m_slots.size())
+      return false;
+
+    const Slot& slot = m_slots[handle.index() - m_first];
+    if (slot.generation != handle.generation())
+      return false;
+
+    return slot.dense < m_dense.size() && m_dense[slot.dense] == handle;
+  }
+  /*! @return The live handle with the specified index, or the null handle if
+   *  that index is not in use.
+   */
+  Handle handleOf(uint32 index) const
+  {
+    if (index < m_first || index - m_first >= m_slots.size())
+      return Handle();
+
+    const Handle handle(index, m_slots[index - m_first].generation);
+    if (!contains(handle))
+      return Handle();
+
+    return handle;
+  }
+  IDBucket bucketOf(uint32 index) const
+  {
+    if (index < m_first || index - m_first >= m_slots.size())
       return ID_BUCKET_UNUSED;
 
-    if (std::find(released.begin(), released.end(), id) != released.end())
+    if (handleOf(index).isNull())
       return ID_BUCKET_RELEASED;
 
     return ID_BUCKET_ALLOCATED;
   }
+  /*! @return The number of live handles.
+   */
+  size_t size() const { return m_dense.size(); }
+  /*! @return The live handles, in no particular order.
+   */
+  const std::vector<Handle>& handles() const { return m_dense; }
 private:
-  std::vector<T> released;
-  T next;
+  struct Slot
+  {
+    uint32 generation;
+    uint32 dense;
+  };
+  std::vector<Slot> m_slots;
+  std::vector<Handle> m_dense;
+  std::deque<uint32> m_released;
+  uint32 m_first;
+  uint32 m_limit;
+  uint32 m_margin;
 };
 
 } /*namespace wendy*/
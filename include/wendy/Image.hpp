@@ -29,8 +29,12 @@ namespace wendy
 {
 
 /*! @brief Container for one- or two-dimensional pixel data.
+ *
+ *  Images may be block compressed and may include a chain of mipmap levels,
+ *  stored consecutively after the top level.  Such images can only be read
+ *  from and written to KTX files, and cannot be edited.
  */
-class Image : public Resource, public RefObject
+class Image : public AtomicRefObject, public Resource
 {
 public:
   /*! Sets this image to the specified area of the current image data.
@@ -47,6 +51,13 @@ public:
   /*! Flips this image along the y axis.
    */
   void flipVertical();
+  /*! Writes this image to the specified path, as a KTX file if the path has
+   *  the suffix @c ktx and otherwise as a PNG file.
+   *  @return @c true if successful, otherwise @c false.
+   *
+   *  @remarks Compressed and mipmapped images can only be written to KTX
+   *  files.
+   */
   bool write(const Path& path) const;
   /*! @return @c true if this image has power-of-two dimensions, otherwise @c false.
    */
@@ -69,6 +80,24 @@ public:
   /*! @return The base address of the pixel data for this image.
    */
   const void* pixels() const { return &m_data[0]; }
+  /*! @return The base address of the pixel data for the specified mipmap
+   *  level of this image.
+   */
+  void* pixels(uint level) { return &m_data[offset(level)]; }
+  /*! @return The base address of the pixel data for the specified mipmap
+   *  level of this image.
+   */
+  const void* pixels(uint level) const { return &m_data[offset(level)]; }
+  /*! @return The number of mipmap levels in this image.
+   */
+  uint levelCount() const { return m_levels; }
+  /*! @return @c true if the pixel data of this image is sRGB encoded,
+   *  otherwise @c false.
+   *
+   *  @remarks Only images read from KTX files with an sRGB internal format
+   *  are marked as sRGB.
+   */
+  bool isSRGB() const { return m_sRGB; }
   /*! Helper method to calculate the address of the specified pixel.
    *  @param[in] x The x coordinate of the desired pixel.
    *  @param[in] y The y coordinate of the desired pixel.
@@ -103,6 +132,8 @@ public:
    *  @param[in] pitch The pitch, in bytes, between consecutive scanlines, or
    *  zero if the scanlines are contiguous in memory. If @c data is @c nullptr,
    *  then this parameter is ignored.
+   *  @param[in] levels The number of mipmap levels in @c data.  If this is
+   *  greater than one, @c pitch must be zero.
    *  @return The newly created image object.
    *
    *  @remarks No, you cannot create an empty image object.
@@ -113,7 +144,11 @@ public:
                            uint height = 1,
                            uint depth = 1,
                            const void* pixels = nullptr,
-                           ptrdiff_t pitch = 0);
+                           ptrdiff_t pitch = 0,
+                           uint levels = 1);
+  /*! Reads the specified image from a PNG, JPEG or other file readable by
+   *  stb_image, or from a KTX file.
+   */
   static Ref<Image> read(ResourceCache& cache, const std::string& name);
 private:
   Image(const ResourceInfo& info);
@@ -123,11 +158,19 @@ private:
             uint height,
             uint depth,
             const char* pixels,
-            ptrdiff_t pitch);
+            ptrdiff_t pitch,
+            uint levels);
+  bool writeKTX(const Path& path) const;
+  static Ref<Image> readKTX(ResourceCache& cache,
+                            const std::string& name,
+                            const Path& path);
+  size_t offset(uint level) const;
   Image& operator = (const Image&) = delete;
   uint m_width;
   uint m_height;
   uint m_depth;
+  uint m_levels;
+  bool m_sRGB;
   PixelFormat m_format;
   std::vector<char> m_data;
 };
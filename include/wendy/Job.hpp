@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace wendy
+{
+
+class Profile;
+class JobSystem;
+
+/*! @brief Job function type.
+ */
+typedef std::function<void ()> JobFunction;
+
+/*! @brief Job completion counter.
+ *
+ *  A counter is incremented for every job submitted with it and decremented
+ *  as each of those jobs finishes.  Jobs may also be submitted to run after a
+ *  counter has reached zero.  A counter must outlive all jobs referencing it.
+ */
+class JobCounter
+{
+  friend class JobSystem;
+public:
+  /*! Constructor.
+   */
+  JobCounter();
+  /*! @return @c true if all jobs tracked by this counter have finished,
+   *  otherwise @c false.
+   */
+  bool isDone() const;
+  /*! @return The number of unfinished jobs tracked by this counter.
+   */
+  uint count() const;
+private:
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator = (const JobCounter&) = delete;
+  mutable std::mutex m_mutex;
+  uint m_count;
+  std::vector<JobFunction> m_waiting;
+};
+
+/*! @brief Work-stealing job scheduler.
+ *
+ *  Each worker thread owns a deque of jobs.  Jobs submitted from a worker go
+ *  to the back of its own deque and are run in LIFO order, while idle workers
+ *  steal from the front of other deques.  Jobs submitted from other threads
+ *  go to a shared queue.  Threads waiting for a counter help run jobs until
+ *  it reaches zero.
+ *
+ *  Each job is run inside a profile node with its name.  Worker threads
+ *  record into their own profiles, which are retrieved with
+ *  @ref collectProfiles.
+ */
+class JobSystem
+{
+public:
+  /*! Destructor.  Stops and joins all worker threads.  Jobs not yet started,
+   *  including those still waiting for a dependency, are discarded.
+   */
+  ~JobSystem();
+  /*! Submits a job.
+   *  @param[in] function The function to run.
+   *  @param[in] counter The counter to track the job with, or @c nullptr.
+   *  @param[in] name The name of the job, used for profiling.  Must be a
+   *  string literal or otherwise outlive the job system.
+   */
+  void submit(const JobFunction& function,
+              JobCounter* counter = nullptr,
+              const char* name = "Job");
+  /*! Submits a job that will not be started until the specified counter has
+   *  reached zero.
+   *  @param[in] dependency The counter to wait for.
+   *  @param[in] function The function to run.
+   *  @param[in] counter The counter to track the job with, or @c nullptr.
+   *  @param[in] name The name of the job, used for profiling.
+   */
+  void submitAfter(JobCounter& dependency,
+                   const JobFunction& function,
+                   JobCounter* counter = nullptr,
+                   const char* name = "Job");
+  /*! Runs pending jobs on the calling thread until the specified counter has
+   *  reached zero.
+   */
+  void wait(JobCounter& counter);
+  /*! Splits the specified range into chunks of at most @c grainSize items
+   *  and runs the function on each chunk in parallel, returning once all
+   *  chunks have finished.  The calling thread runs chunks as well.
+   *  @param[in] begin The first item of the range.
+   *  @param[in] end The item after the last item of the range.
+   *  @param[in] grainSize The maximum number of items per chunk.
+   *  @param[in] function The function to run, called with the beginning and
+   *  end of a chunk.
+   *  @param[in] name The name of the chunk jobs, used for profiling.
+   */
+  void parallelFor(uint begin,
+                   uint end,
+                   uint grainSize,
+                   const std::function<void (uint, uint)>& function,
+                   const char* name = "JobSystem::parallelFor");
+  /*! Calls the specified function with the profile of each worker thread,
+   *  then starts a new profile frame for that worker.  Workers busy running
+   *  a job are skipped rather than waited for, and their time is reported
+   *  with a later frame.
+   */
+  void collectProfiles(const std::function<void (uint, const Profile&)>& function);
+  /*! Enables or disables event recording for the profiles of all worker
+   *  threads.
+   *  @see Profile::setHistory
+   */
+  void setProfileHistory(uint frameCount, uint eventCapacity = 65536);
+  /*! @return The number of worker threads.
+   */
+  uint workerCount() const { return uint(m_workers.size()); }
+  /*! @return The index of the calling thread if it is a worker thread of
+   *  this job system, or @c workerCount() if it is not.
+   */
+  uint currentWorker() const;
+  /*! Creates a job system.
+   *  @param[in] workerCount The number of worker threads to start, or zero
+   *  to use one less than the number of hardware threads.
+   */
+  static std::unique_ptr<JobSystem> create(uint workerCount = 0);
+private:
+  struct Job;
+  struct Worker;
+  JobSystem();
+  JobSystem(const JobSystem&) = delete;
+  bool init(uint workerCount);
+  void schedule(Job* job);
+  Job* findJob(uint index);
+  void execute(Job* job);
+  void finish(JobCounter& counter);
+  void runWorker(uint index);
+  JobSystem& operator = (const JobSystem&) = delete;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::vector<std::thread> m_threads;
+  std::deque<Job*> m_injected;
+  std::mutex m_injectedMutex;
+  std::unordered_set<Job*> m_deferred;
+  std::mutex m_deferredMutex;
+  std::mutex m_sleepMutex;
+  std::condition_variable m_sleepCondition;
+  std::atomic<uint> m_queued;
+  bool m_stopping;
+};
+
+} /*namespace wendy*/
@@ -48,7 +48,7 @@ bool parsePass(RenderContext& context, Pass& pass, pugi::xml_node root);
 
 /*! @brief Multi-technique material descriptor.
  */
-class Material : public Resource, public RefObject
+class Material : public AtomicRefObject, public Resource
 {
 public:
   /*! @return The pass for the specified render phase.
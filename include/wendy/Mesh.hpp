@@ -56,7 +56,7 @@ public:
  *  This is an ideal mesh representation intended for ease of use
  *  during calculations.  It is not intended for real-time use.
  */
-class Mesh : public Resource, public RefObject
+class Mesh : public AtomicRefObject, public Resource
 {
 public:
   enum NormalType
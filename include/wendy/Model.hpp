@@ -111,6 +111,12 @@ public:
    *  @return The newly created model, or @c nullptr if an error occurred.
    */
   static Ref<Model> read(RenderContext& context, const std::string& name);
+  /*! Reads the specification and mesh of a model on a worker thread and
+   *  creates the model during a later frame of the specified context.
+   *  @see ResourceCache::loadAsync
+   */
+  static AsyncResource<Model> readAsync(RenderContext& context,
+                                        const std::string& name);
 private:
   Model(const ResourceInfo& info);
   Model(const Model&) = delete;
@@ -215,8 +215,8 @@ private:
   void* m_object;
   std::list<Peer> m_peers;
   HostObserver* m_observer;
-  IDPool<TargetID> m_clientIDs;
-  IDPool<NetworkObjectID> m_objectIDs;
+  HandlePool m_clientIDs;
+  HandlePool m_objectIDs;
   std::vector<NetworkObject*> m_objects;
   size_t m_allocated;
   uint8 m_buffer[65536];
@@ -260,6 +260,7 @@ protected:
                             EventID eventID);
 private:
   NetworkObjectID m_id;
+  Handle m_handle;
   Host& m_host;
 };
 
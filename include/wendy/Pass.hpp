@@ -26,6 +26,7 @@
 #pragma once
 
 #include <wendy/Core.hpp>
+#include <wendy/ID.hpp>
 
 #include <wendy/Texture.hpp>
 #include <wendy/RenderBuffer.hpp>
@@ -69,6 +70,9 @@ public:
   Pass(const Pass& source);
   ~Pass();
   /*! Applies this render state to the current context.
+   *
+   *  @remarks Uniform values and textures already current for the program
+   *  are not uploaded or bound again.
    */
   void apply() const;
   Pass& operator = (const Pass& source);
@@ -242,15 +246,20 @@ public:
    *  the current program.
    */
   void setProgram(Program* program);
-  PassID id() const { return m_id; }
+  /*! @return The ID of this pass, used to group render operations by
+   *  state.
+   */
+  PassID id() const { return PassID(m_handle.index()); }
+  Handle handle() const { return m_handle; }
 private:
   template <typename T>
   static UniformType uniformType();
   void* data(UniformStateIndex index, UniformType type);
   const void* data(UniformStateIndex index, UniformType type) const;
-  PassID m_id;
+  Handle m_handle;
   Ref<Program> m_program;
   std::vector<char> m_uniformState;
+  uint64 m_revision;
   RenderState m_state;
 };
 
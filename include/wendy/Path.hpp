@@ -102,6 +102,10 @@ public:
    *  @return @c true if successful, otherwise @c false.
    */
   std::vector<std::string> children() const;
+  /*! @return The names of all files in the directory with this path,
+   *  leaving out directories.
+   */
+  std::vector<std::string> files() const;
   /*! Returns the names of all files and directories in the directory with this
    *  path that match the specified regex.
    *  @param[in,out] children The resulting list of names.
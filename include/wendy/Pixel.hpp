@@ -31,6 +31,8 @@ namespace wendy
 /*! @brief %Pixel format descriptor.
  *
  *  All formats are at least byte aligned, although their channels may not be.
+ *  Compressed formats are stored as 4x4 pixel blocks, and their type names
+ *  the block compression scheme.
  */
 class PixelFormat
 {
@@ -56,7 +58,13 @@ public:
     UINT24,
     UINT32,
     FLOAT16,
-    FLOAT32
+    FLOAT32,
+    BC1,
+    BC3,
+    BC4,
+    BC5,
+    BC7,
+    ETC2
   };
   /*! Default constructor.
    *  @param[in] semantic The desired semantic of this pixel format.
@@ -78,12 +86,26 @@ public:
    *  format.
    */
   bool isValid() const { return m_semantic != NONE && m_type != DUMMY; }
-  /*! @return The size, in bytes, of a pixel in this pixel format.
+  /*! @return @c true if this pixel format is block compressed, or @c false
+   *  otherwise.
+   */
+  bool isCompressed() const { return m_type >= BC1; }
+  /*! @return The size, in bytes, of a pixel in this pixel format, or zero if
+   *  it is compressed.
    */
   size_t size() const { return channelSize() * channelCount(); }
-  /*! @return The size, in bytes, of a channel of a pixel in this pixel format.
+  /*! @return The size, in bytes, of an image of the specified dimensions in
+   *  this pixel format.
+   */
+  size_t size(uint width, uint height = 1, uint depth = 1) const;
+  /*! @return The size, in bytes, of a channel of a pixel in this pixel format,
+   *  or zero if it is compressed.
    */
   size_t channelSize() const;
+  /*! @return The size, in bytes, of a 4x4 block of pixels in this pixel
+   *  format, or zero if it is not compressed.
+   */
+  size_t blockSize() const;
   /*! @return The channel data type of this pixel format.
    */
   Type type() const { return m_type; }
@@ -116,6 +138,13 @@ public:
   static const PixelFormat DEPTH32;
   static const PixelFormat DEPTH16F;
   static const PixelFormat DEPTH32F;
+  static const PixelFormat RGB_BC1;
+  static const PixelFormat RGBA_BC3;
+  static const PixelFormat L_BC4;
+  static const PixelFormat LA_BC5;
+  static const PixelFormat RGBA_BC7;
+  static const PixelFormat RGB_ETC2;
+  static const PixelFormat RGBA_ETC2;
 private:
   Semantic m_semantic;
   Type m_type;
@@ -25,9 +25,16 @@
 
 #pragma once
 
+#include <chrono>
+#include <deque>
+#include <functional>
+
+#include <time.h>
+
 namespace wendy
 {
 
+class Path;
 class Profile;
 
 class ProfileNode
@@ -48,27 +55,171 @@ private:
   uint m_calls;
 };
 
+/*! @return The current time of the profiler clock, in nanoseconds.
+ */
+inline uint64 profileClock()
+{
+#if WENDY_SYSTEM_LINUX
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return uint64(ts.tv_sec) * 1000000000u + uint64(ts.tv_nsec);
+#else
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+#endif
+}
+
+/*! Profile event type enumeration.
+ */
+enum ProfileEventType
+{
+  /*! A profile node was entered.
+   */
+  PROFILE_EVENT_BEGIN,
+  /*! The most recently entered profile node was left.
+   */
+  PROFILE_EVENT_END,
+  /*! A profile zone was left, with its duration in the event.
+   */
+  PROFILE_EVENT_ZONE
+};
+
+/*! @brief Timestamped profile event.
+ *
+ *  The name is not copied, so names of recorded nodes must outlive the
+ *  history of the profile recording them.
+ */
+struct ProfileEvent
+{
+  const char* name;
+  Time time;
+  Time duration;
+  ProfileEventType type;
+};
+
+/*! @brief Accumulated statistics for a profile zone.
+ */
+struct ProfileZoneStats
+{
+  uint64 duration;
+  uint calls;
+};
+
 class Profile
 {
 public:
+  Profile(const std::string& name = "Main");
   void beginFrame();
   void endFrame();
   void beginNode(const char* name);
   void endNode();
+  /*! Enables or disables recording of timestamped events.  History is kept
+   *  for at most the specified number of frames and events, with the oldest
+   *  frames being discarded first.
+   *  @param[in] frameCount The number of frames to keep, or zero to disable
+   *  recording.
+   *  @param[in] eventCapacity The maximum number of events to keep.
+   */
+  void setHistory(uint frameCount, uint eventCapacity = 65536);
+  bool isRecording() const { return m_frameHistory > 0; }
+  uint historyFrameCount() const { return uint(m_frames.size()); }
+  /*! Calls the specified function with each recorded event, oldest first,
+   *  starting with the oldest frame fully kept in the history.
+   */
+  void visitHistory(const std::function<void (const ProfileEvent&)>& function) const;
+  const std::string& name() const { return m_name; }
+  void setName(const std::string& newName) { m_name = newName; }
   const ProfileNode& rootNode() const { return m_root; }
+  /*! Adds a call to the specified zone that started at the specified time
+   *  and ends now.
+   */
+  void endZone(uint zone, uint64 start)
+  {
+    const uint64 end = profileClock();
+
+    if (zone >= m_zones.size())
+      m_zones.resize(zone + 1, ProfileZoneStats{0, 0});
+
+    m_zones[zone].duration += end - start;
+    m_zones[zone].calls++;
+
+    if (m_frameHistory)
+      recordZone(zone, start, end);
+  }
+  /*! @return The statistics of this frame for each zone, indexed by zone ID.
+   *  Zones not yet entered with this profile may be missing.
+   */
+  const std::vector<ProfileZoneStats>& zones() const { return m_zones; }
   static Profile* currentNode() { return m_current; }
+  static void setCurrent(Profile* newProfile) { m_current = newProfile; }
+  /*! @return The ID of the zone with the specified name, creating it if it
+   *  does not yet exist.
+   */
+  static uint zoneID(const char* name);
+  /*! @return The name of the zone with the specified ID.
+   */
+  static const char* zoneName(uint zone);
+  /*! @return The number of zones created so far.
+   */
+  static uint zoneCount();
 private:
   Profile(const Profile&) = delete;
   void beginNode(ProfileNode& node);
+  void recordEvent(const char* name, ProfileEventType type);
+  void recordZone(uint zone, uint64 start, uint64 end);
   Profile& operator = (const Profile&) = delete;
   static void resetNode(ProfileNode& node);
   typedef std::vector<ProfileNode*> Stack;
+  std::string m_name;
   ProfileNode m_root;
   Stack m_stack;
   Timer m_timer;
-  static Profile* m_current;
+  std::vector<ProfileEvent> m_events;
+  uint64 m_eventCount;
+  std::deque<uint64> m_frames;
+  uint m_frameHistory;
+  std::vector<ProfileZoneStats> m_zones;
+  static thread_local Profile* m_current;
+};
+
+/*! @brief Chrome trace event file builder.
+ *
+ *  Collects the recorded history of one or more profiles, one per thread, and
+ *  writes it in the Chrome trace event JSON format, which can be opened in
+ *  chrome://tracing or the Perfetto UI.
+ *
+ *  Events of profiles added after the first are limited to the time span of
+ *  the history of the first profile.
+ */
+class ProfileTrace
+{
+public:
+  ProfileTrace();
+  /*! Copies the recorded history of the specified profile into this trace
+   *  as a new thread.
+   */
+  void addProfile(const Profile& profile);
+  /*! Writes this trace to the specified file.
+   *  @return @c true if successful, otherwise @c false.
+   */
+  bool write(const Path& path) const;
+  size_t eventCount() const { return m_events.size(); }
+private:
+  struct Event
+  {
+    const char* name;
+    Time start;
+    Time duration;
+    uint thread;
+  };
+  std::vector<std::string> m_threads;
+  std::vector<Event> m_events;
+  Time m_start;
+  Time m_end;
 };
 
+#if WENDY_ENABLE_PROFILER
+
 class ProfileNodeCall
 {
 public:
@@ -87,5 +238,52 @@ private:
   Profile* m_profile;
 };
 
+/*! @brief Scoped profile zone.
+ *
+ *  Unlike ProfileNodeCall, a zone is not part of the node tree.  It adds its
+ *  time to a flat per-profile array indexed by zone ID, which makes it cheap
+ *  enough for code called many times per frame.  Use @ref WENDY_PROFILE_ZONE
+ *  instead of creating these directly.
+ */
+class ProfileZone
+{
+public:
+  explicit ProfileZone(uint zone):
+    m_profile(Profile::currentNode()),
+    m_zone(zone)
+  {
+    if (m_profile)
+      m_start = profileClock();
+  }
+  ~ProfileZone()
+  {
+    if (m_profile)
+      m_profile->endZone(m_zone, m_start);
+  }
+private:
+  Profile* m_profile;
+  uint m_zone;
+  uint64 m_start;
+};
+
+/*! Profiles the rest of the enclosing scope as the specified zone.  The name
+ *  must be a string literal and is interned once per call site, on first use.
+ */
+#define WENDY_PROFILE_ZONE(name) \
+  static const uint wendyProfileZoneID = ::wendy::Profile::zoneID(name); \
+  ::wendy::ProfileZone wendyProfileZone(wendyProfileZoneID)
+
+#else /*WENDY_ENABLE_PROFILER*/
+
+class ProfileNodeCall
+{
+public:
+  ProfileNodeCall(const char*) { }
+};
+
+#define WENDY_PROFILE_ZONE(name)
+
+#endif /*WENDY_ENABLE_PROFILER*/
+
 } /*namespace wendy*/
 
@@ -45,8 +45,12 @@ enum ShaderType
 };
 
 /*! @brief %Shader.
+ *
+ *  @remarks Shaders are preprocessed when created but only compiled when
+ *  first linked into a program that is not found in the program binary
+ *  cache.
  */
-class Shader : public Resource, public RefObject
+class Shader : public AtomicRefObject, public Resource
 {
   friend class Program;
 public:
@@ -64,10 +68,14 @@ public:
                           const std::string& name);
 private:
   Shader(const ResourceInfo& info, RenderContext& context, ShaderType type);
-  bool init(const std::string& text);
+  bool init(const char* text);
+  bool compile();
   RenderContext& m_context;
   ShaderType m_type;
   uint m_shaderID;
+  std::string m_text;
+  std::string m_names;
+  uint m_objectInverses;
 };
 
 /*! @brief Program attribute type enumeration.
@@ -77,7 +85,8 @@ enum AttributeType
   ATTRIBUTE_FLOAT,
   ATTRIBUTE_VEC2,
   ATTRIBUTE_VEC3,
-  ATTRIBUTE_VEC4
+  ATTRIBUTE_VEC4,
+  ATTRIBUTE_MAT4
 };
 
 /*! @brief Program vertex attribute.
@@ -89,8 +98,17 @@ class Attribute
 public:
   /*! Binds this attribute to the specified stride and offset of the
    *  current vertex buffer.
+   *  @param[in] stride The stride, in bytes, of the vertex buffer.
+   *  @param[in] offset The offset, in bytes, of the attribute data.
+   *  @param[in] instanced @c true to advance once per instance, or @c false to
+   *  advance once per vertex.
    */
-  void bind(size_t stride, size_t offset);
+  void bind(size_t stride, size_t offset, bool instanced = false);
+  /*! Sets this attribute to a constant value for all vertices, detaching it
+   *  from the current vertex buffer until it is bound again.
+   *  @param[in] data The elements of the value.
+   */
+  void setValue(const float* data);
   /*! @return @c true if the name of this attribute matches the specified
    *  string, or @c false otherwise.
    */
@@ -110,6 +128,9 @@ public:
   /*! @return The number of elements in this attribute.
    */
   uint elementCount() const;
+  /*! @return The number of consecutive locations used by this attribute.
+   */
+  uint columnCount() const;
 private:
   AttributeType m_type;
   std::string m_name;
@@ -144,11 +165,13 @@ class Uniform
 public:
   /*! Copies a new value for this uniform from the specified address.
    *  @param[in] data The address of the value to use.
+   *  @return @c true if the value was uploaded, or @c false if it matched
+   *  the value last uploaded for this uniform.
    *
    *  @remarks It is the responsibility of the caller to ensure that the source
    *  data type matches.
    */
-  void copyFrom(const void* data);
+  bool copyFrom(const void* data);
   /*! @return @c true if the name of this uniform matches the specified string,
    *  or @c false otherwise.
    */
@@ -188,6 +211,8 @@ private:
   UniformType m_type;
   int m_location;
   int m_sharedID;
+  bool m_cached;
+  float m_value[16];
 };
 
 const char* stringCast(AttributeType type);
@@ -195,7 +220,7 @@ const char* stringCast(UniformType type);
 
 /*! @brief %Shader program.
  */
-class Program : public Resource, public RefObject
+class Program : public AtomicRefObject, public Resource
 {
   friend class Pass;
   friend class RenderContext;
@@ -223,10 +248,11 @@ private:
   Program(const ResourceInfo& info, RenderContext& context);
   Program(const Program&) = delete;
   bool init(Shader& vertexShader, Shader& fragmentShader);
+  bool link();
+  bool loadBinary(const Path& path, uint64 key);
+  void saveBinary(const Path& path, uint64 key);
   bool retrieveUniforms();
   bool retrieveAttributes();
-  void bind();
-  void unbind();
   Program& operator = (const Program&) = delete;
   bool isValid() const;
   std::string infoLog() const;
@@ -234,6 +260,9 @@ private:
   Ref<Shader> m_vertexShader;
   Ref<Shader> m_fragmentShader;
   uint m_programID;
+  bool m_sharedBlocks;
+  uint m_objectInverses;
+  uint64 m_passRevision;
   std::vector<Attribute> m_attributes;
   std::vector<Uniform> m_uniforms;
 };
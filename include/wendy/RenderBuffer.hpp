@@ -130,11 +130,16 @@ private:
   VertexBuffer(const VertexBuffer&) = delete;
   bool init(const VertexFormat& format, size_t count, BufferUsage usage);
   VertexBuffer& operator = (const VertexBuffer&) = delete;
+  static Ref<VertexBuffer> createStream(RenderContext& context,
+                                        size_t count,
+                                        const VertexFormat& format);
   RenderContext& m_context;
   VertexFormat m_format;
   uint m_bufferID;
   size_t m_count;
   BufferUsage m_usage;
+  bool m_stream;
+  void* m_mapping;
 };
 
 /*! @brief Index (or element) buffer.
@@ -191,11 +196,16 @@ private:
   IndexBuffer(const IndexBuffer&) = delete;
   bool init(size_t count, IndexType type, BufferUsage usage);
   IndexBuffer& operator = (const IndexBuffer&) = delete;
+  static Ref<IndexBuffer> createStream(RenderContext& context,
+                                       size_t count,
+                                       IndexType type);
   RenderContext& m_context;
   IndexType m_type;
   BufferUsage m_usage;
   uint m_bufferID;
   size_t m_count;
+  bool m_stream;
+  void* m_mapping;
 };
 
 /*! @brief Vertex buffer range.
@@ -333,6 +343,25 @@ public:
                  size_t start,
                  size_t count,
                  size_t base = 0);
+  /*! @return @c true if this primitive range refers to the same primitives
+   *  as the specified range, or @c false otherwise.
+   */
+  bool operator == (const PrimitiveRange& other) const
+  {
+    return m_type == other.m_type &&
+           m_vertexBuffer == other.m_vertexBuffer &&
+           m_indexBuffer == other.m_indexBuffer &&
+           m_start == other.m_start &&
+           m_count == other.m_count &&
+           m_base == other.m_base;
+  }
+  /*! @return @c true if this primitive range refers to different primitives
+   *  than the specified range, or @c false otherwise.
+   */
+  bool operator != (const PrimitiveRange& other) const
+  {
+    return !(*this == other);
+  }
   /*! @return @c true if this primitive range contains zero primitives,
    *  otherwise @c false.
    */
@@ -430,6 +459,8 @@ private:
   uint m_depthBits;
   uint m_stencilBits;
   uint m_samples;
+  uint m_width;
+  uint m_height;
 };
 
 /*! @brief %Framebuffer for rendering to images.
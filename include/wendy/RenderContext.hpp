@@ -33,15 +33,19 @@
 #include <wendy/Window.hpp>
 
 #include <deque>
+#include <unordered_map>
 
 namespace wendy
 {
 
 class AABB;
+class Image;
 class VertexBuffer;
 class IndexBuffer;
 class RenderContext;
 class PrimitiveRange;
+class Attribute;
+class PreprocessorCache;
 
 /*! @brief Polygon face enumeration.
  */
@@ -165,6 +169,11 @@ public:
   /*! Whether to create a debug context.
    */
   bool debug;
+  /*! The directory in which to cache linked program binaries, or an empty
+   *  path to always compile programs from source.  The directory is created
+   *  if it does not exist.
+   */
+  Path programCachePath;
 };
 
 /*! Render state.
@@ -240,6 +249,9 @@ public:
   /*! The number of available vertex attributes.
    */
   uint maxVertexAttributes;
+  /*! The required alignment, in bytes, of uniform buffer ranges.
+   */
+  uint uniformBufferOffsetAlignment;
 };
 
 /*! @brief %Render statistics.
@@ -253,6 +265,9 @@ public:
     Frame();
     uint operationCount;
     uint stateChangeCount;
+    uint flushCount;
+    uint skippedUniformCount;
+    uint skippedTextureCount;
     uint vertexCount;
     uint pointCount;
     uint lineCount;
@@ -262,7 +277,14 @@ public:
   RenderStats();
   void addFrame();
   void addStateChange();
-  void addPrimitives(PrimitiveType type, uint vertexCount);
+  /*! Records that a batch of immediate mode geometry was flushed.
+   */
+  void addFlush();
+  /*! Records uniform uploads and texture binds skipped because the program
+   *  or texture unit already had the desired value.
+   */
+  void addSkippedCalls(uint uniformCount, uint textureCount);
+  void addPrimitives(PrimitiveType type, uint vertexCount, uint instanceCount = 1);
   void addTexture(size_t size);
   void removeTexture(size_t size);
   void addVertexBuffer(size_t size);
@@ -297,6 +319,7 @@ private:
 
 class SharedProgramState : public RefObject
 {
+  friend class RenderContext;
 public:
   /*! Constructor.
    */
@@ -360,6 +383,15 @@ public:
   virtual void setViewportSize(float newWidth, float newHeight);
   virtual void setTime(float newTime);
 private:
+  const mat4& modelViewMatrix();
+  const mat4& viewProjMatrix();
+  const mat4& modelViewProjMatrix();
+  const mat4& invModelMatrix();
+  const mat4& invViewMatrix();
+  const mat4& invProjMatrix();
+  const mat4& invModelViewMatrix();
+  const mat4& invViewProjMatrix();
+  const mat4& invModelViewProjMatrix();
   bool m_dirtyModelView;
   bool m_dirtyViewProj;
   bool m_dirtyModelViewProj;
@@ -369,6 +401,8 @@ private:
   bool m_dirtyInvModelView;
   bool m_dirtyInvViewProj;
   bool m_dirtyInvModelViewProj;
+  uint m_frameRevision;
+  uint m_objectRevision;
   mat4 m_modelMatrix;
   mat4 m_viewMatrix;
   mat4 m_projectionMatrix;
@@ -395,6 +429,9 @@ private:
  */
 class RenderContext : public Trackable
 {
+  friend class VertexBuffer;
+  friend class IndexBuffer;
+  friend class Program;
 public:
   /*! Destructor.
    */
@@ -432,6 +469,16 @@ public:
    *  @pre A GLSL program must be set before calling this method.
    */
   void render(PrimitiveType type, uint start, uint count, uint base = 0);
+  /*! Renders one instance of the specified primitive range for each element
+   *  of the specified instance range, using the current GLSL program.
+   *  @param[in] range The primitive range to render.
+   *  @param[in] instances The per-instance data to use.  Program attributes
+   *  not found in the vertex format of the primitive range are sourced from
+   *  the instanced components of this range.
+   *  @pre A GLSL program must be set before calling this method.
+   *  @pre The context must support instancing.
+   */
+  void render(const PrimitiveRange& range, const VertexRange& instances);
   /*! Allocates a range of temporary vertices of the specified format.
    *  @param[in] count The number of vertices to allocate.
    *  @param[in] format The format of vertices to allocate.
@@ -439,8 +486,21 @@ public:
    *
    *  @remarks The allocated vertex range is only valid until the end of the
    *  current frame.
+   *
+   *  @remarks Temporary vertices are sub-allocated from a triple-buffered
+   *  streaming buffer per vertex format, so writing to the range is a plain
+   *  memory copy where persistent buffer mapping is supported.
    */
   VertexRange allocateVertices(uint count, const VertexFormat& format);
+  /*! Allocates a range of temporary indices of the specified type.
+   *  @param[in] count The number of indices to allocate.
+   *  @param[in] type The type of indices to allocate.
+   *  @return @c The newly allocated index range.
+   *
+   *  @remarks The allocated index range is only valid until the end of the
+   *  current frame.
+   */
+  IndexRange allocateIndices(uint count, IndexType type);
   /*! Reserves the specified uniform signature as shared.
    */
   void createSharedUniform(const char* name, UniformType type, int ID);
@@ -456,8 +516,22 @@ public:
    */
   void setSharedProgramState(SharedProgramState* newState);
   /*! @return GLSL declarations of all shared uniforms.
+   *
+   *  @remarks For GLSL 1.40 and later, the built-in shared uniforms are
+   *  declared as members of the @c wyFrame and @c wyObject std140 uniform
+   *  blocks, which are sourced from a ring-buffered uniform buffer.  Custom
+   *  shared uniforms are always declared as plain uniforms.
+   *
+   *  @remarks Vertex shaders also get the @c wyInstanceM attribute, which
+   *  holds the model matrix of the current instance.  Shaders using it
+   *  instead of @c wyM may be rendered instanced with InstanceTransform
+   *  data, and otherwise receive the current model matrix.
    */
   const char* sharedProgramStateDeclaration() const;
+  /*! @return @c true if this context supports instanced rendering with
+   *  per-instance attributes, or @c false otherwise.
+   */
+  bool isInstancingSupported() const;
   /*! @return The swap interval of this context.
    */
   int swapInterval() const;
@@ -512,11 +586,28 @@ public:
   /*! @note Unless you are Wendy, you probably don't need to call this.
    */
   void setTextureUnit(uint unit);
+  /*! @return The texture bound to the specified texture unit, or @c nullptr
+   *  if no texture is bound to it.
+   */
+  Texture* boundTexture(uint unit) const { return m_textureUnits[unit]; }
   bool isCullingInverted();
   void setCullingInversion(bool newState);
   const RenderState& renderState() const;
   void setRenderState(const RenderState& newState);
   bool debug() const { return m_debug; }
+  /*! @return The directory in which linked program binaries are cached, or
+   *  an empty path if program binaries are not cached.
+   */
+  const Path& programCachePath() const { return m_programCachePath; }
+  /*! @return The vendor, renderer and version strings of this context, which
+   *  identify the driver that created any cached program binaries.
+   */
+  const std::string& driverString() const { return m_driverString; }
+  /*! @return The preprocessed shader files and text shared by all shaders
+   *  created for this context.
+   *  @note Unless you are Wendy, you probably don't need to call this.
+   */
+  PreprocessorCache& preprocessorCache() const { return *m_preprocessorCache; }
   RenderStats* stats() const;
   void setStats(RenderStats* newStats);
   /*! @return The limits of this context.
@@ -525,9 +616,49 @@ public:
   /*! @return The resource cache used by this context.
    */
   ResourceCache& cache() const;
+  /*! @return The time, in seconds, spent each frame finishing asynchronous
+   *  resource loads.
+   */
+  Time loadBudget() const { return m_loadBudget; }
+  /*! Sets the time spent each frame finishing asynchronous resource loads.
+   *  @param[in] newBudget The desired time, in seconds.
+   */
+  void setLoadBudget(Time newBudget);
+  /*! @return The number of bytes of texel data streamed into textures each
+   *  frame.
+   */
+  size_t uploadBudget() const { return m_uploadBudget; }
+  /*! Sets the number of bytes of texel data streamed into textures each
+   *  frame.  At least one row of texels is streamed per frame while any
+   *  uploads are pending.
+   *  @param[in] newBudget The desired number of bytes.
+   */
+  void setUploadBudget(size_t newBudget);
+  /*! @return The number of textures still waiting for their texel data.
+   */
+  size_t pendingUploadCount() const { return m_uploads.size(); }
+  /*! Queues the pixels of the specified image to be streamed into the
+   *  specified texture, a number of rows at a time, over the following
+   *  frames.
+   *  @note Unless you are Wendy, you probably don't need to call this.
+   */
+  void queueUpload(Texture& texture, Image& image);
   /*! @return The window of this context.
+   *  @pre This context is not headless.
    */
   Window& window();
+  /*! @return @c true if this context has no window, or @c false otherwise.
+   */
+  bool isHeadless() const { return m_headless; }
+  /*! @return The number of frames finished by this context.
+   */
+  uint frameCount() const { return m_frame; }
+  /*! Waits for all rendering to complete and ends the current frame.
+   *
+   *  @remarks Headless contexts have no window to update, so this takes the
+   *  place of Window::update for them.
+   */
+  void finishFrame();
   /*! Creates the context object, using the specified settings.
    *  @param[in] cache The resource cache to use.
    *  @param[in] wndconfig The desired window configuration.
@@ -537,29 +668,145 @@ public:
   static std::unique_ptr<RenderContext> create(ResourceCache& cache,
                                                const WindowConfig& wc = WindowConfig(),
                                                const RenderConfig& rc = RenderConfig());
+  /*! Creates a context object without a window, using the specified settings.
+   *  @param[in] cache The resource cache to use.
+   *  @param[in] width The width of the default framebuffer.
+   *  @param[in] height The height of the default framebuffer.
+   *  @param[in] rc The desired context configuration.
+   *  @return The newly created context, or @c nullptr if an error occurred.
+   *
+   *  @remarks Headless contexts are only available if Wendy was built with
+   *  EGL support, and windowed contexts are not available in such builds.
+   *
+   *  @remarks The default framebuffer of a headless context may not be
+   *  renderable, so render into a TextureFramebuffer.
+   */
+  static std::unique_ptr<RenderContext> createHeadless(ResourceCache& cache,
+                                                       uint width,
+                                                       uint height,
+                                                       const RenderConfig& rc = RenderConfig());
 private:
   RenderContext(ResourceCache& cache);
   RenderContext(const RenderContext&) = delete;
   bool init(const WindowConfig& wc, const RenderConfig& rc);
+  bool init(uint width, uint height, const RenderConfig& rc);
+  bool initGL(const RenderConfig& rc, uint width, uint height);
+  /*! Uniform buffer binding points of the shared uniform blocks.
+   */
+  enum
+  {
+    SHARED_FRAME_BLOCK,
+    SHARED_OBJECT_BLOCK
+  };
+  /*! Identifies a cached vertex array.  The vertex formats are not part of
+   *  the key, as a buffer is created with its format and never changes it.
+   */
+  struct VertexArrayKey
+  {
+    bool operator == (const VertexArrayKey& other) const
+    {
+      return program == other.program &&
+             vertexBuffer == other.vertexBuffer &&
+             indexBuffer == other.indexBuffer &&
+             instanceBuffer == other.instanceBuffer;
+    }
+    Program* program;
+    VertexBuffer* vertexBuffer;
+    IndexBuffer* indexBuffer;
+    VertexBuffer* instanceBuffer;
+  };
+  struct VertexArrayKeyHash
+  {
+    size_t operator () (const VertexArrayKey& key) const;
+  };
+  /*! Vertex array object recording the attribute bindings of a program for
+   *  a set of buffers.
+   */
+  struct VertexArray
+  {
+    VertexArrayKey key;
+    uint arrayID;
+    Attribute* instanceTransform;
+    std::vector<std::pair<Attribute*, size_t>> instanceAttributes;
+  };
+  void draw(VertexBuffer* vertexBuffer,
+            IndexBuffer* indexBuffer,
+            PrimitiveType type,
+            uint start,
+            uint count,
+            uint base,
+            uint instanceCount);
+  const VertexArray* setVertexArray(VertexBuffer& vertexBuffer, IndexBuffer* indexBuffer);
+  bool initVertexArray(VertexArray& array,
+                       VertexBuffer& vertexBuffer,
+                       IndexBuffer* indexBuffer);
+  /*! Destroys all cached vertex arrays referencing the specified program or
+   *  buffer.
+   */
+  void removeVertexArrays(const void* object);
+  /*! Writes the parts of the shared uniform blocks that have changed since
+   *  they were last written and binds the written ranges.
+   */
+  void updateSharedBlocks();
   void applyState(const RenderState& newState);
   void forceState(const RenderState& newState);
   RenderContext& operator = (const RenderContext&) = delete;
   void onFrame();
-  struct Slot
+  enum { STREAM_SECTIONS = 3 };
+  /*! Ring buffer of temporary vertices or indices.  Each section written
+   *  during a frame is guarded by a fence at the end of that frame, which is
+   *  waited on before the section is reused.
+   */
+  struct Stream
   {
-    Ref<VertexBuffer> buffer;
-    uint available;
+    Ref<VertexBuffer> vertexBuffer;
+    Ref<IndexBuffer> indexBuffer;
+    size_t sectionSize;
+    size_t head;
+    uint section;
+    uint frames[STREAM_SECTIONS];
+    void* fences[STREAM_SECTIONS];
   };
+  Stream createStream(size_t sectionSize);
+  bool reserve(Stream& stream, size_t count);
+  void fenceStream(Stream& stream);
+  void destroyStream(Stream& stream);
+  /*! Pending copy of image rows into a texture.
+   */
+  struct Upload
+  {
+    Ref<Texture> texture;
+    Ref<Image> image;
+    uint row;
+  };
+  /*! Streams pending uploads through the staging buffer, within the upload
+   *  budget.
+   */
+  void processUploads();
   class SharedUniform;
   ResourceCache& m_cache;
   Window m_window;
   GLFWwindow* m_handle;
+  bool m_headless;
+  void* m_display;
+  void* m_surface;
+  void* m_context;
   bool m_debug;
+  Path m_programCachePath;
+  std::string m_driverString;
+  std::unique_ptr<PreprocessorCache> m_preprocessorCache;
   std::unique_ptr<RenderLimits> m_limits;
   int m_swapInterval;
+  Time m_loadBudget;
   Recti m_scissorArea;
   Recti m_viewportArea;
-  bool m_dirtyBinding;
+  std::unordered_map<VertexArrayKey, VertexArray, VertexArrayKeyHash> m_vertexArrays;
+  VertexArray* m_vertexArray;
+  uint m_sharedBufferID;
+  size_t m_sharedBufferOffset;
+  uint m_frameRevision;
+  uint m_objectRevision;
+  uint m_objectInverses;
   bool m_dirtyState;
   bool m_cullingInverted;
   std::vector<Ref<Texture>> m_textureUnits;
@@ -568,11 +815,21 @@ private:
   Ref<Program> m_program;
   Ref<VertexBuffer> m_vertexBuffer;
   Ref<IndexBuffer> m_indexBuffer;
+  Ref<VertexBuffer> m_instanceBuffer;
+  size_t m_instanceStart;
   Ref<Framebuffer> m_framebuffer;
   Ref<SharedProgramState> m_sharedProgramState;
   Ref<WindowFramebuffer> m_windowFramebuffer;
   std::vector<SharedUniform> m_uniforms;
-  std::vector<Slot> m_slots;
+  std::vector<Stream> m_vertexStreams;
+  std::vector<Stream> m_indexStreams;
+  std::vector<Stream> m_retiredStreams;
+  uint m_uploadBufferID;
+  void* m_uploadMapping;
+  Stream m_uploadStream;
+  std::deque<Upload> m_uploads;
+  size_t m_uploadBudget;
+  uint m_frame;
   std::string m_declaration;
   RenderStats* m_stats;
 };
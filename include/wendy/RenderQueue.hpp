@@ -95,8 +95,12 @@ private:
   vec3 m_color;
 };
 
-#pragma pack(push, 1)
-
+/*! @brief Render operation sort key.
+ *
+ *  From the least significant bit, the key holds 24 bits of depth, 16 bits of
+ *  pass ID and 8 bits of layer.  Only the lowest @c BITS bits are used, and
+ *  the index of the operation is kept outside of the key.
+ */
 class RenderOpKey
 {
 public:
@@ -105,25 +109,23 @@ public:
   RenderOpKey(): value(0) { }
   RenderOpKey(uint64 value): value(value) { }
   operator uint64 () const { return value; }
-  union
+  uint32 depth() const { return uint32(value & 0xffffff); }
+  uint16 state() const { return uint16(value >> 24); }
+  uint8 layer() const { return uint8(value >> 40); }
+  uint64 value;
+  static const uint BITS = 48;
+private:
+  RenderOpKey(uint8 layer, uint16 state, uint32 depth):
+    value(uint64(depth) | (uint64(state) << 24) | (uint64(layer) << 40))
   {
-    uint64 value;
-    struct
-    {
-      unsigned index : 16;
-      unsigned depth : 24;
-      unsigned state : 16;
-      unsigned layer : 8;
-    };
-  };
+  }
 };
 
-#pragma pack(pop)
-
 /*! @brief Render operation in the 3D pipeline.
  *
  *  This represents a single render operation, including render state, a
- *  primitive range and a local-to-world transformation.
+ *  primitive range and the index of its local-to-world transformation in the
+ *  transform pool of its render queue.
  *
  *  @remarks Note that this class does not include any references to a camera.
  *  The camera transformation is handled by the Camera class.
@@ -140,15 +142,17 @@ public:
   /*! The render technique to use.
    */
   const Pass* state;
-  /*! The local-to-world transformation.  Leave this set to identity if the
-   *  geometry already is in world space.
+  /*! The index of the local-to-world transformation in the transform pool of
+   *  the render queue.  Leave this set to zero, the identity transform, if
+   *  the geometry already is in world space.
    */
-  mat4 transform;
+  uint32 transform;
 };
 
 /*! @brief Render operation bucket.
  *
- *  @remarks Each queue can only contain 65536 render operations.
+ *  Operations are sorted by key with a stable LSD radix sort, so operations
+ *  with equal keys are rendered in the order they were added.
  */
 class RenderBucket
 {
@@ -162,15 +166,25 @@ public:
   /*! Destroys all render operations in this render queue.
    */
   void removeOperations();
-  /*! @return The render operations in this render queue.
+  /*! @return The render operations in this render queue, in the order they
+   *  were added.
    */
   const std::vector<RenderOp>& operations() const { return m_operations; }
-  /*! @return The sor keys in this render queue.
+  /*! @return The indices of the render operations in this render queue,
+   *  sorted by key.
    */
-  const std::vector<uint64>& keys() const;
+  const std::vector<uint32>& order() const;
 private:
+  struct Entry
+  {
+    uint64 key;
+    uint32 index;
+  };
+  void sortEntries() const;
   std::vector<RenderOp> m_operations;
-  mutable std::vector<uint64> m_keys;
+  mutable std::vector<Entry> m_entries;
+  mutable std::vector<Entry> m_scratch;
+  mutable std::vector<uint32> m_order;
   mutable bool m_sorted;
 };
 
@@ -184,6 +198,15 @@ class RenderQueue
 public:
   RenderQueue(RenderContext& context, RenderPhase phase = RENDER_DEFAULT);
   void addOperation(const RenderOp& operation, float depth, uint8 layer = 0);
+  /*! Adds a transform to the transform pool of this queue.  Adding the same
+   *  transform several times in a row only stores it once.
+   *  @return The index of the transform.
+   */
+  uint32 addTransform(const mat4& transform);
+  /*! @return The transform pool of this queue.  The first transform is always
+   *  the identity.
+   */
+  const std::vector<mat4>& transforms() const { return m_transforms; }
   void createOperations(const mat4& transform,
                         const PrimitiveRange& range,
                         const Material& material,
@@ -206,6 +229,7 @@ private:
   RenderPhase m_phase;
   RenderBucket m_opaqueBucket;
   RenderBucket m_blendedBucket;
+  std::vector<mat4> m_transforms;
   std::vector<LightData> m_lights;
   vec3 m_ambient;
 };
@@ -29,9 +29,15 @@ namespace wendy
 {
 
 class Camera;
+class Pass;
 class RenderQueue;
 
 /*! @brief %Renderer.
+ *
+ *  Consecutive operations sharing the same pass and primitive range are
+ *  rendered with a single instanced draw call if the program of the pass uses
+ *  the @c wyInstanceM attribute and the context supports instancing.  The
+ *  shared model matrix is the identity during instanced draw calls.
  */
 class Renderer : public RefObject
 {
@@ -54,9 +60,11 @@ public:
 private:
   Renderer(RenderContext& context);
   bool init();
-  void renderOperations(const RenderBucket& bucket);
+  void renderOperations(const RenderQueue& queue, const RenderBucket& bucket);
+  bool isInstanced(const Pass& pass) const;
   RenderContext& m_context;
   Ref<SharedProgramState> m_state;
+  std::vector<mat4> m_instances;
 };
 
 } /*namespace wendy*/
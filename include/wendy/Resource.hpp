@@ -25,6 +25,18 @@
 
 #pragma once
 
+#include <wendy/Time.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace wendy
 {
 
@@ -43,8 +55,15 @@ public:
 
 class Resource
 {
+  friend class ResourceCache;
 public:
-  Resource(const ResourceInfo& info);
+  /*! Constructor.
+   *  @param[in] info The name and cache of the resource.
+   *  @param[in] counter The reference count of the resource, if it is an
+   *  AtomicRefObject, which lets the cache hand out references to it from
+   *  any thread.
+   */
+  Resource(const ResourceInfo& info, AtomicRefObject* counter = nullptr);
   Resource(const Resource& source);
   virtual ~Resource();
   Resource& operator = (const Resource& source);
@@ -55,24 +74,141 @@ private:
   ResourceCache& m_cache;
   std::string m_name;
   Path m_path;
+  AtomicRefObject* m_counter;
+};
+
+/*! @brief Asynchronous load status enumeration.
+ */
+enum LoadStatus
+{
+  /*! The resource is still being loaded.
+   */
+  LOAD_PENDING,
+  /*! The resource has been loaded.
+   */
+  LOAD_READY,
+  /*! The resource could not be loaded.
+   */
+  LOAD_FAILED
+};
+
+/*! @brief Handle to an asynchronously loaded resource.
+ *
+ *  The status and resource of a handle only change during
+ *  ResourceCache::finishLoads, so they should only be used on the thread
+ *  calling it.
+ */
+template <typename T>
+class AsyncResource
+{
+  friend class ResourceCache;
+public:
+  /*! @return The status of this load.
+   */
+  LoadStatus status() const { return m_state ? m_state->status : LOAD_FAILED; }
+  /*! @return @c true if the resource is still being loaded, otherwise @c
+   *  false.
+   */
+  bool isPending() const { return status() == LOAD_PENDING; }
+  /*! @return @c true if the resource has been loaded, otherwise @c false.
+   */
+  bool isReady() const { return status() == LOAD_READY; }
+  /*! @return The loaded resource, or @c nullptr if it is not ready.
+   */
+  T* resource() const { return m_state ? (T*) m_state->resource : nullptr; }
+private:
+  struct State
+  {
+    State(): status(LOAD_PENDING) { }
+    LoadStatus status;
+    Ref<T> resource;
+  };
+  std::shared_ptr<State> m_state;
 };
 
+/*! @brief Named resource index and file locator.
+ *
+ *  Lookups by name are hashed and may be made from any thread.  Adding and
+ *  removing search paths must not happen concurrently with other calls.
+ *
+ *  Resources can also be loaded asynchronously.  Decoding runs on worker
+ *  threads owned by the cache, while any step touching a context runs on the
+ *  thread calling finishLoads, which RenderContext does once per frame.
+ */
 class ResourceCache
 {
   friend class Resource;
 public:
+  /*! @brief Scoped lock serializing the creation of a named resource.
+   *
+   *  Readers that may run on several threads hold one of these while they
+   *  look for and create a resource, so that only one thread creates it and
+   *  the others find the result.  Locking a name twice on the same thread
+   *  deadlocks.
+   */
+  class NameLock
+  {
+  public:
+    NameLock(ResourceCache& cache, const std::string& name);
+    ~NameLock();
+  private:
+    NameLock(const NameLock&) = delete;
+    NameLock& operator = (const NameLock&) = delete;
+    ResourceCache& m_cache;
+    std::string m_name;
+  };
+  /*! Constructor.
+   */
+  ResourceCache();
+  /*! Destructor.  Loads that have not yet finished are abandoned.
+   */
   ~ResourceCache();
   bool addSearchPath(const Path& path);
   void removeSearchPath(const Path& path);
+  /*! Discards the cached directory listings used by @c findFile, for when
+   *  files have been added to or removed from a search path since it was
+   *  first searched.
+   */
+  void clearFileCache();
+  /*! @return The resource with the specified name, or @c nullptr if no such
+   *  resource exists.
+   *
+   *  @remarks The returned pointer is not a reference, so another thread may
+   *  free the resource at any time.  Use @c find to get hold of a resource.
+   */
   Resource* findResource(const std::string& name) const;
+  /*! @return A reference to the resource with the specified name, or @c
+   *  nullptr if no such resource exists.
+   *
+   *  @remarks This may be called from any thread for resources that pass
+   *  their reference count to Resource.  Others may only be found on the
+   *  thread that releases them.
+   */
   template <typename T>
-  T* find(const std::string& name) const
+  Ref<T> find(const std::string& name) const
   {
-    Resource* cached = findResource(name);
-    if (!cached)
+    // Declared before the lock so that it is released after it, as dropping
+    // the last reference removes the resource from its shard
+    Ref<AtomicRefObject> pin;
+
+    Shard& shard = shardOf(name);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto entry = shard.resources.find(name);
+    if (entry == shard.resources.end())
       return nullptr;
 
-    T* cast = dynamic_cast<T*>(cached);
+    Resource* resource = entry->second;
+
+    if (resource->m_counter)
+    {
+      // Keep the resource from being destroyed before looking at its type
+      pin = Ref<AtomicRefObject>::acquire(resource->m_counter);
+      if (!pin)
+        return nullptr;
+    }
+
+    T* cast = dynamic_cast<T*>(resource);
     if (!cast)
     {
       logError("Resource \'%s\' exists as another type", name.c_str());
@@ -81,11 +217,161 @@ public:
 
     return cast;
   }
+  /*! @return The path of the first file with the specified name in the
+   *  search paths, or an empty path if no such file was found.
+   *
+   *  @remarks The files in each searched directory are listed once and
+   *  cached, so lookups do not touch the disk.  Files added or removed since
+   *  then are not noticed until @c clearFileCache is called.  Names are
+   *  compared without regard to case on Windows and Mac OS X.
+   */
   Path findFile(const std::string& name) const;
   const std::vector<Path>& searchPaths() const { return m_paths; }
+  /*! Reads the specified resource on a worker thread, using @c T::read.
+   *  @param[in] name The name of the resource to load.
+   *  @return A handle to the resource, which becomes ready during a later
+   *  call to finishLoads.
+   *
+   *  @remarks As @c T::read may then run on several threads at once, it must
+   *  hold a NameLock for the name of each resource it creates while looking
+   *  for and creating it.
+   */
+  template <typename T>
+  AsyncResource<T> loadAsync(const std::string& name)
+  {
+    std::function<bool (Ref<T>&)> decode = [this, name](Ref<T>& data)
+    {
+      data = T::read(*this, name);
+      return data != nullptr;
+    };
+
+    std::function<Ref<T> (Ref<T>&)> finish = [](Ref<T>& data)
+    {
+      return data;
+    };
+
+    return loadAsync<T, Ref<T>>(name, decode, finish);
+  }
+  /*! Loads the specified resource in two steps.
+   *  @param[in] name The name of the resource to load.
+   *  @param[in] decode The function reading the data for the resource, which
+   *  is called on a worker thread.
+   *  @param[in] finish The function creating the resource from its data,
+   *  which is called on the thread calling finishLoads.
+   *  @return A handle to the resource, which becomes ready during a later
+   *  call to finishLoads.
+   *
+   *  @remarks Loading a resource that is already being loaded returns a
+   *  handle to the existing load.
+   *
+   *  @remarks This must be called on the thread calling finishLoads.
+   */
+  template <typename T, typename D>
+  AsyncResource<T> loadAsync(const std::string& name,
+                             std::function<bool (D&)> decode,
+                             std::function<Ref<T> (D&)> finish)
+  {
+    typedef typename AsyncResource<T>::State State;
+
+    AsyncResource<T> handle;
+
+    auto pending = m_pending.find(name);
+    if (pending != m_pending.end())
+    {
+      if (*pending->second.type != typeid(T))
+      {
+        logError("Resource \'%s\' is being loaded as another type", name.c_str());
+        return handle;
+      }
+
+      handle.m_state = std::static_pointer_cast<State>(pending->second.state);
+      return handle;
+    }
+
+    handle.m_state = std::make_shared<State>();
+
+    if (Ref<T> cached = find<T>(name))
+    {
+      handle.m_state->resource = cached;
+      handle.m_state->status = LOAD_READY;
+      return handle;
+    }
+
+    std::shared_ptr<State> state = handle.m_state;
+    std::shared_ptr<D> data = std::make_shared<D>();
+
+    Pending entry;
+    entry.type = &typeid(T);
+    entry.state = state;
+    m_pending[name] = entry;
+
+    queueLoad([decode, data]()
+    {
+      return decode(*data);
+    },
+    [this, name, finish, data, state](bool success)
+    {
+      // A synchronous read of the same name may have registered the
+      // resource while this load was pending
+      if (findResource(name))
+        state->resource = find<T>(name);
+      else if (success)
+        state->resource = finish(*data);
+
+      state->status = state->resource ? LOAD_READY : LOAD_FAILED;
+      m_pending.erase(name);
+    });
+
+    return handle;
+  }
+  /*! Runs the final step of finished asynchronous loads, until the specified
+   *  time has been spent.  At least one load is finished per call, if any
+   *  are waiting.
+   *  @param[in] budget The time, in seconds, to spend.
+   */
+  void finishLoads(Time budget);
+  /*! @return The number of asynchronous loads that have not yet finished.
+   */
+  size_t pendingLoadCount() const { return m_pending.size(); }
 private:
+  struct Load
+  {
+    std::function<bool ()> decode;
+    std::function<void (bool)> finish;
+    bool success;
+  };
+  struct Pending
+  {
+    const std::type_info* type;
+    std::shared_ptr<void> state;
+  };
+  enum { SHARD_COUNT = 16 };
+  struct Shard
+  {
+    std::mutex mutex;
+    std::unordered_map<std::string, Resource*> resources;
+  };
+  typedef std::unordered_set<std::string> Listing;
+  bool addResource(Resource& resource);
+  void removeResource(Resource& resource);
+  Shard& shardOf(const std::string& name) const;
+  bool isListed(const std::string& directory, const std::string& key) const;
+  void queueLoad(std::function<bool ()> decode, std::function<void (bool)> finish);
+  void runWorker();
   std::vector<Path> m_paths;
-  std::vector<Resource*> m_resources;
+  mutable Shard m_shards[SHARD_COUNT];
+  mutable std::mutex m_fileMutex;
+  mutable std::unordered_map<std::string, Listing> m_listings;
+  std::vector<std::thread> m_workers;
+  std::deque<Load> m_loads;
+  std::deque<Load> m_finished;
+  std::mutex m_loadMutex;
+  std::condition_variable m_loadCondition;
+  bool m_stopping;
+  std::unordered_map<std::string, Pending> m_pending;
+  std::mutex m_nameMutex;
+  std::condition_variable m_nameCondition;
+  std::unordered_set<std::string> m_lockedNames;
 };
 
 } /*namespace wendy*/
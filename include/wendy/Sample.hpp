@@ -40,7 +40,7 @@ enum SampleFormat
 
 /*! @brief Audio sample.
  */
-class Sample : public Resource, public RefObject
+class Sample : public AtomicRefObject, public Resource
 {
 public:
   Sample(const ResourceInfo& info,
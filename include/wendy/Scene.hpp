@@ -99,6 +99,13 @@ public:
    *  child nodes.
    */
   const Sphere& totalBounds() const;
+  /*! @return The world space bounds of this node.
+   */
+  const Sphere& worldBounds() const;
+  /*! @return The world space union of the bounds of this node and all its
+   *  child nodes.
+   */
+  const Sphere& worldTotalBounds() const;
   Renderable* renderable() const { return m_renderable; }
   void setRenderable(Renderable* newRenderable);
   Camera* camera() const { return m_camera; }
@@ -112,12 +119,20 @@ protected:
    *  operations required to render this scene node should be put into the
    *  specified render queue.
    *  @param[in,out] queue The render queue for collecting operations.
-   */
-  void enqueue(RenderQueue& queue, const Camera& camera) const;
+   *  @param[in] planes The bit mask of camera frustum planes that the parent
+   *  of this node isn't entirely inside of.
+   *
+   *  @remarks Nodes whose bounds are outside the frustum are skipped along
+   *  with their children, and the planes a node is entirely inside of aren't
+   *  tested for its children.
+   */
+  void enqueue(RenderQueue& queue, const Camera& camera, uint planes) const;
 private:
   SceneNode(const SceneNode&) = delete;
   void invalidateBounds();
   void invalidateWorldTransform();
+  void invalidateProxy();
+  void updateWorldBounds() const;
   SceneNode& operator = (const SceneNode&) = delete;
   void setGraph(SceneGraph* newGraph);
   SceneNode* m_parent;
@@ -129,6 +144,12 @@ private:
   Sphere m_localBounds;
   mutable Sphere m_totalBounds;
   mutable bool m_dirtyBounds;
+  mutable Sphere m_worldBounds;
+  mutable Sphere m_worldTotalBounds;
+  mutable bool m_dirtyWorldBounds;
+  uint m_proxy;
+  uint m_serial;
+  bool m_dirtyProxy;
   Ref<Renderable> m_renderable;
   Ref<Camera> m_camera;
 };
@@ -138,11 +159,17 @@ private:
  *
  *  This class represents a single scene graph, and is a logical tree root node,
  *  although it doesn't have a transform or bounds.
+ *
+ *  The world space bounds of the root nodes are kept in a bounding volume
+ *  hierarchy, which is updated lazily for root nodes whose transform or
+ *  bounds have changed.  Queries and culling traverse the hierarchy but
+ *  return nodes in the order they were added as roots.
  */
 class SceneGraph
 {
   friend class SceneNode;
 public:
+  SceneGraph();
   ~SceneGraph();
   void update();
   void enqueue(RenderQueue& queue, const Camera& camera) const;
@@ -152,8 +179,18 @@ public:
   void destroyRootNodes();
   const std::vector<SceneNode*>& roots() const { return m_roots; }
 private:
+  void updateProxies() const;
+  void removeProxy(SceneNode& node);
+  void sortBySerial(std::vector<SceneNode*>& nodes, size_t start) const;
   std::vector<SceneNode*> m_roots;
   std::vector<SceneNode*> m_updated;
+  mutable std::vector<SceneNode*> m_dirtyProxies;
+  mutable AABBTree m_tree;
+  mutable std::vector<void*> m_candidates;
+  mutable SphereBatch m_candidateBounds;
+  mutable std::vector<uint32> m_candidateMask;
+  mutable std::vector<SceneNode*> m_visible;
+  uint m_nextSerial;
 };
 
 } /*namespace wendy*/
@@ -113,6 +113,10 @@ enum CubeFace
 };
 
 /*! @brief %Texture creation data.
+ *
+ *  The texels may include a chain of mipmap levels, stored consecutively
+ *  after the top level as in Image objects.  Texels marked as sRGB are
+ *  sampled as sRGB whether or not TF_SRGB is set.
  */
 class TextureData
 {
@@ -122,7 +126,8 @@ public:
               uint width,
               uint height = 1,
               uint depth = 1,
-              const void* texels = nullptr);
+              const void* texels = nullptr,
+              uint levels = 1);
   bool isPOT() const;
   uint dimensionCount() const;
   PixelFormat format;
@@ -130,6 +135,8 @@ public:
   uint height;
   uint depth;
   const void* texels;
+  uint levels;
+  bool sRGB;
 };
 
 /*! @brief %Texture creation parameters.
@@ -161,7 +168,7 @@ public:
 
 /*! @brief %Texture object.
  */
-class Texture : public Resource, public RefObject
+class Texture : public AtomicRefObject, public Resource
 {
   friend class RenderContext;
   friend class TextureFramebuffer;
@@ -202,6 +209,10 @@ public:
   /*! @return @c true if this texture is mipmapped, otherwise @c false.
    */
   bool hasMipmaps() const { return m_levels > 1; }
+  /*! @return @c true if the texel data of this texture is still being
+   *  streamed in by its context, or @c false otherwise.
+   */
+  bool isStreaming() const { return m_streaming; }
   /*! @return The type of this texture.
    */
   TextureType type() const { return m_params.type; }
@@ -257,6 +268,13 @@ public:
   static Ref<Texture> read(RenderContext& context,
                            const TextureParams& params,
                            const std::string& imageName);
+  /*! Reads the specified image on a worker thread and creates a texture from
+   *  it during a later frame of the specified context.
+   *  @see ResourceCache::loadAsync
+   */
+  static AsyncResource<Texture> readAsync(RenderContext& context,
+                                          const TextureParams& params,
+                                          const std::string& imageName);
 private:
   Texture(const ResourceInfo& info,
           RenderContext& context,
@@ -273,6 +291,7 @@ private:
   uint m_height;
   uint m_depth;
   uint m_levels;
+  bool m_streaming;
   PixelFormat m_format;
 };
 
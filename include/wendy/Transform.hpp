@@ -56,7 +56,7 @@ public:
   operator mat4 () const;
   vec3 operator * (vec3 vector) const
   {
-    return rotation * scale * vector + position;
+    return rotation * (scale * vector) + position;
   }
   Transform3 operator * (const Transform3& other) const;
   Transform3& operator *= (const Transform3& other);
@@ -31,7 +31,12 @@ namespace wendy
 /*! @brief Vertex format component descriptor.
  *
  *  This class describes a single logical component of a vertex format.
- *  A component may have multiple (up to four) members.
+ *  A component may have one to four members, or sixteen members for a
+ *  column-major 4x4 matrix.
+ *
+ *  Instanced components advance once per instance instead of once per vertex,
+ *  and are sourced from the instance buffer when rendering with
+ *  RenderContext::render(const PrimitiveRange&, const VertexRange&).
  */
 class VertexComponent
 {
@@ -39,18 +44,20 @@ class VertexComponent
 public:
   /*! Constructor.
    */
-  VertexComponent(const char* name, size_t count);
+  VertexComponent(const char* name, size_t count, bool instanced = false);
   /*! Equality operator.
    */
   bool operator == (const VertexComponent& other) const
   {
-    return m_name == other.m_name && m_count == other.m_count;
+    return m_name == other.m_name &&
+           m_count == other.m_count &&
+           m_instanced == other.m_instanced;
   }
   /*! Inequality operator.
    */
   bool operator != (const VertexComponent& other) const
   {
-    return m_name != other.m_name || m_count != other.m_count;
+    return !(*this == other);
   }
   /*! @return The size, in bytes, of this component.
    */
@@ -64,10 +71,15 @@ public:
   /*! @return The number of elements in this component.
    */
   size_t elementCount() const { return m_count; }
+  /*! @return @c true if this component advances once per instance, or @c
+   *  false if it advances once per vertex.
+   */
+  bool isInstanced() const { return m_instanced; }
 private:
   std::string m_name;
   size_t m_count;
   size_t m_offset;
+  bool m_instanced;
 };
 
 /*! @brief Vertex format descriptor.
@@ -87,9 +99,13 @@ public:
   /*! Constructor. Creates components according to the specified specification.
    *  @param specification The specification of the desired format.
    *  @remarks This will throw if the specification is syntactically malformed.
+   *
+   *  @remarks Each component is specified as its element count, the type @c f
+   *  and an optional @c i marking it as instanced, followed by a colon and
+   *  the name, for example @c 3f:vPosition or @c 16fi:wyInstanceM.
    */
   explicit VertexFormat(const char* specification);
-  bool createComponent(const char* name, size_t count);
+  bool createComponent(const char* name, size_t count, bool instanced = false);
   bool createComponents(const char* specification);
   void destroyComponents();
   const VertexComponent* findComponent(const char* name) const;
@@ -103,6 +119,18 @@ private:
 
 std::string stringCast(const VertexFormat& format);
 
+/*! @brief Predefined instance format.
+ *
+ *  This is the per-instance model matrix used by the instanced rendering path
+ *  of the renderer, as exposed to shaders by the @c wyInstanceM attribute.
+ */
+class InstanceTransform
+{
+public:
+  mat4 transform;
+  static const VertexFormat format;
+};
+
 /*! @brief Predefined vertex format.
  */
 class Vertex3fv
@@ -151,6 +179,17 @@ public:
   static const VertexFormat format;
 };
 
+/*! @brief Predefined vertex format.
+ */
+class Vertex4fc2ft2fv
+{
+public:
+  vec4 color;
+  vec2 texcoord;
+  vec2 position;
+  static const VertexFormat format;
+};
+
 /*! @brief Predefined vertex format.
  */
 class Vertex4fc2ft3fv
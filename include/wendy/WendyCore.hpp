@@ -32,12 +32,14 @@
 #include <wendy/Signal.hpp>
 #include <wendy/Time.hpp>
 #include <wendy/Profile.hpp>
+#include <wendy/Job.hpp>
 
 #include <wendy/Transform.hpp>
 
 #include <wendy/Rect.hpp>
 #include <wendy/Primitive.hpp>
 #include <wendy/Frustum.hpp>
+#include <wendy/AABBTree.hpp>
 #include <wendy/Camera.hpp>
 
 #include <wendy/Pixel.hpp>
@@ -1,10 +1,15 @@
 
 #version 150
 
+in vec4 vColor;
 in vec2 vPosition;
 
+out vec4 color;
+
 void main()
 {
+  color = vColor;
+
   gl_Position = wyP * vec4(vPosition, 0.0, 1.0);
 }
 
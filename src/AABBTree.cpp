@@ -0,0 +1,475 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Transform.hpp>
+#include <wendy/Primitive.hpp>
+#include <wendy/Frustum.hpp>
+#include <wendy/AABBTree.hpp>
+
+#include <glm/gtx/norm.hpp>
+#include <glm/gtx/component_wise.hpp>
+
+namespace wendy
+{
+
+namespace
+{
+
+/*! Fraction of its half size by which a leaf box is enlarged.
+ */
+const float LEAF_MARGIN = 0.1f;
+
+float surfaceArea(vec3 minimum, vec3 maximum)
+{
+  const vec3 size = maximum - minimum;
+  return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+} /*namespace*/
+
+AABBTree::AABBTree():
+  m_root(NO_NODE),
+  m_free(NO_NODE),
+  m_proxyCount(0)
+{
+}
+
+uint AABBTree::createProxy(const AABB& bounds, void* data)
+{
+  const uint leaf = allocateNode();
+  m_nodes[leaf].data = data;
+  setLeafBounds(leaf, bounds);
+  insertLeaf(leaf);
+
+  m_proxyCount++;
+  return leaf;
+}
+
+void AABBTree::destroyProxy(uint proxy)
+{
+  assert(proxy < m_nodes.size());
+  assert(m_nodes[proxy].isLeaf());
+
+  removeLeaf(proxy);
+  freeNode(proxy);
+
+  m_proxyCount--;
+}
+
+bool AABBTree::moveProxy(uint proxy, const AABB& bounds)
+{
+  assert(proxy < m_nodes.size());
+  assert(m_nodes[proxy].isLeaf());
+
+  vec3 minimum, maximum;
+  bounds.bounds(minimum, maximum);
+
+  const Node& node = m_nodes[proxy];
+  if (all(lessThanEqual(node.minimum, minimum)) &&
+      all(greaterThanEqual(node.maximum, maximum)))
+  {
+    return false;
+  }
+
+  removeLeaf(proxy);
+  setLeafBounds(proxy, bounds);
+  insertLeaf(proxy);
+  return true;
+}
+
+void AABBTree::query(const Frustum& frustum, std::vector<void*>& results) const
+{
+  if (m_root == NO_NODE)
+    return;
+
+  std::vector<uint> stack;
+  stack.reserve(64);
+  stack.push_back(m_root);
+
+  while (!stack.empty())
+  {
+    const Node& node = m_nodes[stack.back()];
+    stack.pop_back();
+
+    bool outside = false;
+
+    for (size_t i = 0;  i < 6;  i++)
+    {
+      const Plane& plane = frustum.planes[i];
+      const vec3 negative(plane.normal.x < 0.f ? node.maximum.x : node.minimum.x,
+                          plane.normal.y < 0.f ? node.maximum.y : node.minimum.y,
+                          plane.normal.z < 0.f ? node.maximum.z : node.minimum.z);
+
+      if (!plane.contains(negative))
+      {
+        outside = true;
+        break;
+      }
+    }
+
+    if (outside)
+      continue;
+
+    if (node.isLeaf())
+      results.push_back(node.data);
+    else
+    {
+      stack.push_back(node.children[0]);
+      stack.push_back(node.children[1]);
+    }
+  }
+}
+
+void AABBTree::query(const Sphere& sphere, std::vector<void*>& results) const
+{
+  if (m_root == NO_NODE)
+    return;
+
+  const float radiusSquared = sphere.radius * sphere.radius;
+
+  std::vector<uint> stack;
+  stack.reserve(64);
+  stack.push_back(m_root);
+
+  while (!stack.empty())
+  {
+    const Node& node = m_nodes[stack.back()];
+    stack.pop_back();
+
+    const vec3 closest = clamp(sphere.center, node.minimum, node.maximum);
+    if (length2(closest - sphere.center) > radiusSquared)
+      continue;
+
+    if (node.isLeaf())
+      results.push_back(node.data);
+    else
+    {
+      stack.push_back(node.children[0]);
+      stack.push_back(node.children[1]);
+    }
+  }
+}
+
+uint AABBTree::height() const
+{
+  if (m_root == NO_NODE)
+    return 0;
+
+  return uint(m_nodes[m_root].height) + 1;
+}
+
+uint AABBTree::allocateNode()
+{
+  uint index;
+
+  if (m_free == NO_NODE)
+  {
+    index = m_nodes.size();
+    m_nodes.push_back(Node());
+  }
+  else
+  {
+    index = m_free;
+    m_free = m_nodes[index].parent;
+  }
+
+  Node& node = m_nodes[index];
+  node.parent = NO_NODE;
+  node.children[0] = NO_NODE;
+  node.children[1] = NO_NODE;
+  node.height = 0;
+  node.data = nullptr;
+
+  return index;
+}
+
+void AABBTree::freeNode(uint index)
+{
+  m_nodes[index].parent = m_free;
+  m_nodes[index].height = -1;
+  m_free = index;
+}
+
+void AABBTree::insertLeaf(uint leaf)
+{
+  if (m_root == NO_NODE)
+  {
+    m_root = leaf;
+    m_nodes[leaf].parent = NO_NODE;
+    return;
+  }
+
+  const vec3 leafMinimum = m_nodes[leaf].minimum;
+  const vec3 leafMaximum = m_nodes[leaf].maximum;
+
+  // Descend towards the sibling with the lowest surface area cost
+  uint index = m_root;
+
+  while (!m_nodes[index].isLeaf())
+  {
+    const Node& node = m_nodes[index];
+
+    const float area = surfaceArea(node.minimum, node.maximum);
+    const float combinedArea = surfaceArea(min(node.minimum, leafMinimum),
+                                           max(node.maximum, leafMaximum));
+
+    // Cost of making a new parent for this node and the leaf
+    const float cost = 2.f * combinedArea;
+
+    // Minimum cost of pushing the leaf further down the tree
+    const float inheritedCost = 2.f * (combinedArea - area);
+
+    float childCosts[2];
+
+    for (size_t i = 0;  i < 2;  i++)
+    {
+      const Node& child = m_nodes[node.children[i]];
+      const float enlargedArea = surfaceArea(min(child.minimum, leafMinimum),
+                                             max(child.maximum, leafMaximum));
+
+      if (child.isLeaf())
+        childCosts[i] = enlargedArea + inheritedCost;
+      else
+      {
+        const float childArea = surfaceArea(child.minimum, child.maximum);
+        childCosts[i] = enlargedArea - childArea + inheritedCost;
+      }
+    }
+
+    if (cost < childCosts[0] && cost < childCosts[1])
+      break;
+
+    if (childCosts[0] < childCosts[1])
+      index = node.children[0];
+    else
+      index = node.children[1];
+  }
+
+  const uint sibling = index;
+  const uint oldParent = m_nodes[sibling].parent;
+  const uint newParent = allocateNode();
+
+  m_nodes[newParent].parent = oldParent;
+  m_nodes[newParent].minimum = min(m_nodes[sibling].minimum, leafMinimum);
+  m_nodes[newParent].maximum = max(m_nodes[sibling].maximum, leafMaximum);
+  m_nodes[newParent].height = m_nodes[sibling].height + 1;
+  m_nodes[newParent].children[0] = sibling;
+  m_nodes[newParent].children[1] = leaf;
+
+  if (oldParent == NO_NODE)
+    m_root = newParent;
+  else if (m_nodes[oldParent].children[0] == sibling)
+    m_nodes[oldParent].children[0] = newParent;
+  else
+    m_nodes[oldParent].children[1] = newParent;
+
+  m_nodes[sibling].parent = newParent;
+  m_nodes[leaf].parent = newParent;
+
+  refit(oldParent);
+}
+
+void AABBTree::removeLeaf(uint leaf)
+{
+  if (leaf == m_root)
+  {
+    m_root = NO_NODE;
+    return;
+  }
+
+  const uint parent = m_nodes[leaf].parent;
+  const uint grandParent = m_nodes[parent].parent;
+
+  uint sibling;
+  if (m_nodes[parent].children[0] == leaf)
+    sibling = m_nodes[parent].children[1];
+  else
+    sibling = m_nodes[parent].children[0];
+
+  m_nodes[sibling].parent = grandParent;
+  freeNode(parent);
+
+  if (grandParent == NO_NODE)
+  {
+    m_root = sibling;
+    return;
+  }
+
+  if (m_nodes[grandParent].children[0] == parent)
+    m_nodes[grandParent].children[0] = sibling;
+  else
+    m_nodes[grandParent].children[1] = sibling;
+
+  refit(grandParent);
+}
+
+uint AABBTree::balance(uint indexA)
+{
+  Node& A = m_nodes[indexA];
+  if (A.isLeaf() || A.height < 2)
+    return indexA;
+
+  const uint indexB = A.children[0];
+  const uint indexC = A.children[1];
+  Node& B = m_nodes[indexB];
+  Node& C = m_nodes[indexC];
+
+  const int imbalance = C.height - B.height;
+
+  if (imbalance > 1)
+  {
+    // Rotate C up, keeping the taller of its children
+    const uint indexF = C.children[0];
+    const uint indexG = C.children[1];
+    Node& F = m_nodes[indexF];
+    Node& G = m_nodes[indexG];
+
+    C.children[0] = indexA;
+    C.parent = A.parent;
+    A.parent = indexC;
+
+    if (C.parent == NO_NODE)
+      m_root = indexC;
+    else if (m_nodes[C.parent].children[0] == indexA)
+      m_nodes[C.parent].children[0] = indexC;
+    else
+      m_nodes[C.parent].children[1] = indexC;
+
+    if (F.height > G.height)
+    {
+      C.children[1] = indexF;
+      A.children[1] = indexG;
+      G.parent = indexA;
+      A.minimum = min(B.minimum, G.minimum);
+      A.maximum = max(B.maximum, G.maximum);
+      C.minimum = min(A.minimum, F.minimum);
+      C.maximum = max(A.maximum, F.maximum);
+      A.height = 1 + std::max(B.height, G.height);
+      C.height = 1 + std::max(A.height, F.height);
+    }
+    else
+    {
+      C.children[1] = indexG;
+      A.children[1] = indexF;
+      F.parent = indexA;
+      A.minimum = min(B.minimum, F.minimum);
+      A.maximum = max(B.maximum, F.maximum);
+      C.minimum = min(A.minimum, G.minimum);
+      C.maximum = max(A.maximum, G.maximum);
+      A.height = 1 + std::max(B.height, F.height);
+      C.height = 1 + std::max(A.height, G.height);
+    }
+
+    return indexC;
+  }
+
+  if (imbalance < -1)
+  {
+    // Rotate B up, keeping the taller of its children
+    const uint indexD = B.children[0];
+    const uint indexE = B.children[1];
+    Node& D = m_nodes[indexD];
+    Node& E = m_nodes[indexE];
+
+    B.children[0] = indexA;
+    B.parent = A.parent;
+    A.parent = indexB;
+
+    if (B.parent == NO_NODE)
+      m_root = indexB;
+    else if (m_nodes[B.parent].children[0] == indexA)
+      m_nodes[B.parent].children[0] = indexB;
+    else
+      m_nodes[B.parent].children[1] = indexB;
+
+    if (D.height > E.height)
+    {
+      B.children[1] = indexD;
+      A.children[0] = indexE;
+      E.parent = indexA;
+      A.minimum = min(C.minimum, E.minimum);
+      A.maximum = max(C.maximum, E.maximum);
+      B.minimum = min(A.minimum, D.minimum);
+      B.maximum = max(A.maximum, D.maximum);
+      A.height = 1 + std::max(C.height, E.height);
+      B.height = 1 + std::max(A.height, D.height);
+    }
+    else
+    {
+      B.children[1] = indexE;
+      A.children[0] = indexD;
+      D.parent = indexA;
+      A.minimum = min(C.minimum, D.minimum);
+      A.maximum = max(C.maximum, D.maximum);
+      B.minimum = min(A.minimum, E.minimum);
+      B.maximum = max(A.maximum, E.maximum);
+      A.height = 1 + std::max(C.height, D.height);
+      B.height = 1 + std::max(A.height, E.height);
+    }
+
+    return indexB;
+  }
+
+  return indexA;
+}
+
+void AABBTree::refit(uint index)
+{
+  while (index != NO_NODE)
+  {
+    index = balance(index);
+
+    Node& node = m_nodes[index];
+    const Node& first = m_nodes[node.children[0]];
+    const Node& second = m_nodes[node.children[1]];
+
+    node.minimum = min(first.minimum, second.minimum);
+    node.maximum = max(first.maximum, second.maximum);
+    node.height = 1 + std::max(first.height, second.height);
+
+    index = node.parent;
+  }
+}
+
+void AABBTree::setLeafBounds(uint leaf, const AABB& bounds)
+{
+  vec3 minimum, maximum;
+  bounds.bounds(minimum, maximum);
+
+  // The margin also covers rounding in the conservative tests, so include
+  // a term relative to the magnitude of the coordinates
+  const vec3 half = (maximum - minimum) / 2.f;
+  const float scale = compMax(max(abs(minimum), abs(maximum)));
+  const vec3 margin = half * LEAF_MARGIN + vec3(scale * 1e-5f + 1e-3f);
+
+  m_nodes[leaf].minimum = minimum - margin;
+  m_nodes[leaf].maximum = maximum + margin;
+}
+
+} /*namespace wendy*/
+
@@ -196,8 +196,37 @@ Ref<AudioBuffer> AudioBuffer::read(AudioContext& context, const std::string& sam
   return create(ResourceInfo(cache, name), context, *data);
 }
 
+AsyncResource<AudioBuffer> AudioBuffer::readAsync(AudioContext& context,
+                                                  const std::string& sampleName)
+{
+  ResourceCache& cache = context.cache();
+
+  std::string name;
+  name += "sample:";
+  name += sampleName;
+
+  std::function<bool (Ref<Sample>&)> decode = [&cache, name, sampleName](Ref<Sample>& data)
+  {
+    data = Sample::read(cache, sampleName);
+    if (!data)
+    {
+      logError("Failed to read sample for buffer %s", name.c_str());
+      return false;
+    }
+
+    return true;
+  };
+
+  std::function<Ref<AudioBuffer> (Ref<Sample>&)> finish = [&context, name](Ref<Sample>& data)
+  {
+    return create(ResourceInfo(context.cache(), name), context, *data);
+  };
+
+  return cache.loadAsync<AudioBuffer, Ref<Sample>>(name, decode, finish);
+}
+
 AudioBuffer::AudioBuffer(const ResourceInfo& info, AudioContext& context):
-  Resource(info),
+  Resource(info, this),
   m_context(context),
   m_bufferID(0),
   m_duration(0.0)
@@ -118,6 +118,10 @@ Ref<BvhTriangleMeshShape> BvhTriangleMeshShape::read(ResourceCache& cache,
   name += "source:";
   name += meshName;
 
+  // This may run on loader threads, so keep others from creating the same
+  // resource until this one is done
+  ResourceCache::NameLock lock(cache, name);
+
   if (Ref<BvhTriangleMeshShape> shape = cache.find<BvhTriangleMeshShape>(name))
     return shape;
 
@@ -132,7 +136,7 @@ Ref<BvhTriangleMeshShape> BvhTriangleMeshShape::read(ResourceCache& cache,
 }
 
 BvhTriangleMeshShape::BvhTriangleMeshShape(const ResourceInfo& info):
-  Resource(info)
+  Resource(info, this)
 {
 }
 
@@ -40,6 +40,9 @@ Canvas::Canvas(Layer& layer, Widget* parent):
 
 void Canvas::draw() const
 {
+  // Submit queued widget geometry so it ends up beneath the custom drawing
+  layer().drawer().flush();
+
   m_drawn(*this);
 
   Widget::draw();
@@ -0,0 +1,676 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Rect.hpp>
+#include <wendy/Path.hpp>
+#include <wendy/Pixel.hpp>
+#include <wendy/Resource.hpp>
+#include <wendy/Image.hpp>
+#include <wendy/Compressor.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace wendy
+{
+
+namespace
+{
+
+/*! Texels of a 4x4 block, expanded to four eight-bit channels.
+ */
+typedef uint8 Block[16][4];
+
+void fetchBlock(Block block,
+                const uint8* source,
+                uint width,
+                uint height,
+                uint channelCount,
+                uint x,
+                uint y)
+{
+  // Texels outside partial blocks at the edges repeat the last row or column
+  for (uint i = 0;  i < 16;  i++)
+  {
+    const uint sx = min(x + i % 4, width - 1);
+    const uint sy = min(y + i / 4, height - 1);
+    const uint8* texel = source + (sy * width + sx) * channelCount;
+
+    for (uint c = 0;  c < 4;  c++)
+      block[i][c] = (c < channelCount) ? texel[c] : 255;
+  }
+}
+
+void storeBlock(const Block block,
+                uint8* target,
+                uint width,
+                uint height,
+                uint channelCount,
+                uint x,
+                uint y)
+{
+  for (uint i = 0;  i < 16;  i++)
+  {
+    const uint tx = x + i % 4;
+    const uint ty = y + i / 4;
+
+    if (tx < width && ty < height)
+      std::memcpy(target + (ty * width + tx) * channelCount, block[i], channelCount);
+  }
+}
+
+uint16 packColor(const vec3& color)
+{
+  const vec3 scaled = clamp(color, 0.f, 255.f) * vec3(31.f, 63.f, 31.f) / 255.f;
+
+  return uint16((uint(scaled.r + 0.5f) << 11) |
+                (uint(scaled.g + 0.5f) << 5) |
+                uint(scaled.b + 0.5f));
+}
+
+vec3 unpackColor(uint16 color)
+{
+  const uint r = (color >> 11) & 31;
+  const uint g = (color >> 5) & 63;
+  const uint b = color & 31;
+
+  return vec3(float((r << 3) | (r >> 2)),
+              float((g << 2) | (g >> 4)),
+              float((b << 3) | (b >> 2)));
+}
+
+void colorPalette(vec3 palette[4], uint16 c0, uint16 c1, bool fourColors)
+{
+  palette[0] = unpackColor(c0);
+  palette[1] = unpackColor(c1);
+
+  if (fourColors)
+  {
+    palette[2] = floor((palette[0] * 2.f + palette[1]) / 3.f);
+    palette[3] = floor((palette[0] + palette[1] * 2.f) / 3.f);
+  }
+  else
+  {
+    palette[2] = floor((palette[0] + palette[1]) / 2.f);
+    palette[3] = vec3(0.f);
+  }
+}
+
+/*! Chooses the closest palette entry for each texel.
+ *  @return The total squared error of the chosen entries.
+ */
+float fitColorIndices(const vec3 texels[16],
+                      uint16 c0,
+                      uint16 c1,
+                      uint8 indices[16])
+{
+  vec3 palette[4];
+  colorPalette(palette, c0, c1, true);
+
+  float total = 0.f;
+
+  for (uint i = 0;  i < 16;  i++)
+  {
+    float best = std::numeric_limits<float>::max();
+
+    for (uint j = 0;  j < 4;  j++)
+    {
+      const vec3 delta = texels[i] - palette[j];
+      const float error = dot(delta, delta);
+      if (error < best)
+      {
+        best = error;
+        indices[i] = uint8(j);
+      }
+    }
+
+    total += best;
+  }
+
+  return total;
+}
+
+/*! Quantizes the specified endpoints, ordered for four-color mode, and fits
+ *  indices to them.
+ *  @return The total squared error of the block.
+ */
+float fitColorEndpoints(const vec3 texels[16],
+                        const vec3& e0,
+                        const vec3& e1,
+                        uint16& c0,
+                        uint16& c1,
+                        uint8 indices[16])
+{
+  c0 = packColor(e0);
+  c1 = packColor(e1);
+
+  if (c0 < c1)
+    std::swap(c0, c1);
+
+  if (c0 == c1)
+  {
+    std::memset(indices, 0, 16);
+
+    const vec3 color = unpackColor(c0);
+    float total = 0.f;
+
+    for (uint i = 0;  i < 16;  i++)
+    {
+      const vec3 delta = texels[i] - color;
+      total += dot(delta, delta);
+    }
+
+    return total;
+  }
+
+  return fitColorIndices(texels, c0, c1, indices);
+}
+
+void encodeColorBlock(const Block block, uint8* target)
+{
+  vec3 texels[16];
+  vec3 mean(0.f);
+
+  for (uint i = 0;  i < 16;  i++)
+  {
+    texels[i] = vec3(block[i][0], block[i][1], block[i][2]);
+    mean += texels[i];
+  }
+
+  mean /= 16.f;
+
+  // Find the principal axis of the texel colors by power iteration
+  mat3 covariance(0.f);
+
+  for (uint i = 0;  i < 16;  i++)
+  {
+    const vec3 delta = texels[i] - mean;
+    covariance += outerProduct(delta, delta);
+  }
+
+  vec3 axis(1.f);
+
+  for (uint i = 0;  i < 8;  i++)
+  {
+    axis = covariance * axis;
+
+    const float scale = max(max(std::fabs(axis.x), std::fabs(axis.y)), std::fabs(axis.z));
+    if (scale < 1e-6f)
+    {
+      axis = vec3(1.f);
+      break;
+    }
+
+    axis /= scale;
+  }
+
+  axis = normalize(axis);
+
+  float minimum = std::numeric_limits<float>::max();
+  float maximum = -std::numeric_limits<float>::max();
+
+  for (uint i = 0;  i < 16;  i++)
+  {
+    const float t = dot(texels[i] - mean, axis);
+    minimum = min(minimum, t);
+    maximum = max(maximum, t);
+  }
+
+  uint16 c0, c1;
+  uint8 indices[16];
+
+  float error = fitColorEndpoints(texels,
+                                  mean + axis * maximum,
+                                  mean + axis * minimum,
+                                  c0, c1, indices);
+
+  // Refine the endpoints by least squares fitting to the chosen indices
+  for (uint iteration = 0;  iteration < 2 && c0 != c1;  iteration++)
+  {
+    const float weights[] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    vec3 ax(0.f), bx(0.f);
+
+    for (uint i = 0;  i < 16;  i++)
+    {
+      const float b = weights[indices[i]];
+      const float a = 1.f - b;
+
+      aa += a * a;
+      ab += a * b;
+      bb += b * b;
+      ax += texels[i] * a;
+      bx += texels[i] * b;
+    }
+
+    const float determinant = aa * bb - ab * ab;
+    if (std::fabs(determinant) < 1e-6f)
+      break;
+
+    const vec3 e0 = (ax * bb - bx * ab) / determinant;
+    const vec3 e1 = (bx * aa - ax * ab) / determinant;
+
+    uint16 r0, r1;
+    uint8 refined[16];
+
+    const float refinedError = fitColorEndpoints(texels, e0, e1, r0, r1, refined);
+    if (refinedError >= error)
+      break;
+
+    error = refinedError;
+    c0 = r0;
+    c1 = r1;
+    std::memcpy(indices, refined, sizeof(indices));
+  }
+
+  uint32 bits = 0;
+
+  for (uint i = 0;  i < 16;  i++)
+    bits |= uint32(indices[i]) << (i * 2);
+
+  target[0] = uint8(c0);
+  target[1] = uint8(c0 >> 8);
+  target[2] = uint8(c1);
+  target[3] = uint8(c1 >> 8);
+  target[4] = uint8(bits);
+  target[5] = uint8(bits >> 8);
+  target[6] = uint8(bits >> 16);
+  target[7] = uint8(bits >> 24);
+}
+
+void decodeColorBlock(Block block, const uint8* source, bool fourColors)
+{
+  const uint16 c0 = uint16(source[0] | (source[1] << 8));
+  const uint16 c1 = uint16(source[2] | (source[3] << 8));
+
+  vec3 palette[4];
+  colorPalette(palette, c0, c1, fourColors || c0 > c1);
+
+  const uint32 bits = source[4] |
+                      (source[5] << 8) |
+                      (source[6] << 16) |
+                      (uint32(source[7]) << 24);
+
+  for (uint i = 0;  i < 16;  i++)
+  {
+    const vec3& color = palette[(bits >> (i * 2)) & 3];
+
+    block[i][0] = uint8(color.r);
+    block[i][1] = uint8(color.g);
+    block[i][2] = uint8(color.b);
+  }
+}
+
+void channelPalette(uint8 palette[8], uint8 a0, uint8 a1)
+{
+  palette[0] = a0;
+  palette[1] = a1;
+
+  if (a0 > a1)
+  {
+    for (uint i = 2;  i < 8;  i++)
+      palette[i] = uint8(((8 - i) * a0 + (i - 1) * a1) / 7);
+  }
+  else
+  {
+    for (uint i = 2;  i < 6;  i++)
+      palette[i] = uint8(((6 - i) * a0 + (i - 1) * a1) / 5);
+
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+void encodeChannelBlock(const Block block, uint channel, uint8* target)
+{
+  uint8 a0 = 0, a1 = 255;
+
+  for (uint i = 0;  i < 16;  i++)
+  {
+    a0 = max(a0, block[i][channel]);
+    a1 = min(a1, block[i][channel]);
+  }
+
+  uint8 palette[8];
+  channelPalette(palette, a0, a1);
+
+  uint64 bits = 0;
+
+  for (uint i = 0;  i < 16;  i++)
+  {
+    uint best = 0;
+    int bestError = 256;
+
+    for (uint j = 0;  j < 8;  j++)
+    {
+      const int error = std::abs(int(block[i][channel]) - int(palette[j]));
+      if (error < bestError)
+      {
+        bestError = error;
+        best = j;
+      }
+    }
+
+    bits |= uint64(best) << (i * 3);
+  }
+
+  target[0] = a0;
+  target[1] = a1;
+
+  for (uint i = 0;  i < 6;  i++)
+    target[2 + i] = uint8(bits >> (i * 8));
+}
+
+void decodeChannelBlock(Block block, uint channel, const uint8* source)
+{
+  uint8 palette[8];
+  channelPalette(palette, source[0], source[1]);
+
+  uint64 bits = 0;
+
+  for (uint i = 0;  i < 6;  i++)
+    bits |= uint64(source[2 + i]) << (i * 8);
+
+  for (uint i = 0;  i < 16;  i++)
+    block[i][channel] = palette[(bits >> (i * 3)) & 7];
+}
+
+/*! @return The uncompressed pixel format a compressed format decompresses to,
+ *  or an invalid format if it is not supported.
+ */
+PixelFormat decompressedFormat(const PixelFormat& format)
+{
+  if (format == PixelFormat::RGB_BC1)
+    return PixelFormat::RGB8;
+  if (format == PixelFormat::RGBA_BC3)
+    return PixelFormat::RGBA8;
+  if (format == PixelFormat::L_BC4)
+    return PixelFormat::L8;
+  if (format == PixelFormat::LA_BC5)
+    return PixelFormat::LA8;
+
+  return PixelFormat();
+}
+
+} /*namespace*/
+
+Ref<Image> createMipmaps(const Image& image)
+{
+  const PixelFormat& format = image.format();
+
+  if (format.isCompressed() ||
+      format.type() != PixelFormat::UINT8 ||
+      image.dimensionCount() > 2)
+  {
+    logError("Cannot create mipmaps for image of pixel format %s",
+             stringCast(format).c_str());
+    return nullptr;
+  }
+
+  const uint channelCount = format.channelCount();
+  const uint width = image.width();
+  const uint height = image.height();
+
+  uint levels = 1;
+  while ((max(width, height) >> levels) > 0)
+    levels++;
+
+  std::vector<uint8> data((const uint8*) image.pixels(),
+                          (const uint8*) image.pixels() + format.size(width, height));
+
+  size_t sourceOffset = 0;
+
+  for (uint level = 1;  level < levels;  level++)
+  {
+    const uint sourceWidth = max(width >> (level - 1), 1u);
+    const uint sourceHeight = max(height >> (level - 1), 1u);
+    const uint targetWidth = max(width >> level, 1u);
+    const uint targetHeight = max(height >> level, 1u);
+
+    const size_t targetOffset = data.size();
+    data.resize(targetOffset + format.size(targetWidth, targetHeight));
+
+    const uint8* source = data.data() + sourceOffset;
+    uint8* target = data.data() + targetOffset;
+
+    for (uint y = 0;  y < targetHeight;  y++)
+    {
+      const uint y0 = min(y * 2, sourceHeight - 1);
+      const uint y1 = min(y * 2 + 1, sourceHeight - 1);
+
+      for (uint x = 0;  x < targetWidth;  x++)
+      {
+        const uint x0 = min(x * 2, sourceWidth - 1);
+        const uint x1 = min(x * 2 + 1, sourceWidth - 1);
+
+        for (uint c = 0;  c < channelCount;  c++)
+        {
+          const uint sum = source[(y0 * sourceWidth + x0) * channelCount + c] +
+                           source[(y0 * sourceWidth + x1) * channelCount + c] +
+                           source[(y1 * sourceWidth + x0) * channelCount + c] +
+                           source[(y1 * sourceWidth + x1) * channelCount + c];
+
+          *target++ = uint8((sum + 2) / 4);
+        }
+      }
+    }
+
+    sourceOffset = targetOffset;
+  }
+
+  return Image::create(ResourceInfo(image.cache()),
+                       format,
+                       width, height, 1,
+                       data.data(), 0,
+                       levels);
+}
+
+Ref<Image> compressImage(const Image& image, const PixelFormat& format)
+{
+  const PixelFormat& source = image.format();
+
+  bool compatible = false;
+
+  if (!source.isCompressed() &&
+      source.type() == PixelFormat::UINT8 &&
+      image.dimensionCount() <= 2)
+  {
+    if (format == PixelFormat::RGB_BC1)
+    {
+      compatible = source.semantic() == PixelFormat::RGB ||
+                   source.semantic() == PixelFormat::RGBA;
+    }
+    else if (format == PixelFormat::RGBA_BC3 ||
+             format == PixelFormat::L_BC4 ||
+             format == PixelFormat::LA_BC5)
+    {
+      compatible = source.semantic() == format.semantic();
+    }
+  }
+
+  if (!compatible)
+  {
+    logError("Cannot compress image of pixel format %s to %s",
+             stringCast(source).c_str(),
+             stringCast(format).c_str());
+    return nullptr;
+  }
+
+  Ref<Image> result = Image::create(ResourceInfo(image.cache()),
+                                    format,
+                                    image.width(), image.height(), 1,
+                                    nullptr, 0,
+                                    image.levelCount());
+  if (!result)
+    return nullptr;
+
+  const uint channelCount = source.channelCount();
+
+  for (uint level = 0;  level < image.levelCount();  level++)
+  {
+    const uint width = max(image.width() >> level, 1u);
+    const uint height = max(image.height() >> level, 1u);
+    const uint8* texels = (const uint8*) image.pixels(level);
+    uint8* target = (uint8*) result->pixels(level);
+
+    for (uint y = 0;  y < height;  y += 4)
+    {
+      for (uint x = 0;  x < width;  x += 4)
+      {
+        Block block;
+        fetchBlock(block, texels, width, height, channelCount, x, y);
+
+        if (format == PixelFormat::RGB_BC1)
+          encodeColorBlock(block, target);
+        else if (format == PixelFormat::RGBA_BC3)
+        {
+          encodeChannelBlock(block, 3, target);
+          encodeColorBlock(block, target + 8);
+        }
+        else if (format == PixelFormat::L_BC4)
+          encodeChannelBlock(block, 0, target);
+        else
+        {
+          encodeChannelBlock(block, 0, target);
+          encodeChannelBlock(block, 1, target + 8);
+        }
+
+        target += format.blockSize();
+      }
+    }
+  }
+
+  return result;
+}
+
+Ref<Image> decompressImage(const Image& image)
+{
+  const PixelFormat& source = image.format();
+  const PixelFormat format = decompressedFormat(source);
+
+  if (!format.isValid())
+  {
+    logError("Cannot decompress image of pixel format %s",
+             stringCast(source).c_str());
+    return nullptr;
+  }
+
+  Ref<Image> result = Image::create(ResourceInfo(image.cache()),
+                                    format,
+                                    image.width(), image.height(), 1,
+                                    nullptr, 0,
+                                    image.levelCount());
+  if (!result)
+    return nullptr;
+
+  const uint channelCount = format.channelCount();
+
+  for (uint level = 0;  level < image.levelCount();  level++)
+  {
+    const uint width = max(image.width() >> level, 1u);
+    const uint height = max(image.height() >> level, 1u);
+    const uint8* blocks = (const uint8*) image.pixels(level);
+    uint8* target = (uint8*) result->pixels(level);
+
+    for (uint y = 0;  y < height;  y += 4)
+    {
+      for (uint x = 0;  x < width;  x += 4)
+      {
+        Block block;
+
+        if (source == PixelFormat::RGB_BC1)
+          decodeColorBlock(block, blocks, false);
+        else if (source == PixelFormat::RGBA_BC3)
+        {
+          decodeChannelBlock(block, 3, blocks);
+          decodeColorBlock(block, blocks + 8, true);
+        }
+        else if (source == PixelFormat::L_BC4)
+          decodeChannelBlock(block, 0, blocks);
+        else
+        {
+          decodeChannelBlock(block, 0, blocks);
+          decodeChannelBlock(block, 1, blocks + 8);
+        }
+
+        storeBlock(block, target, width, height, channelCount, x, y);
+        blocks += source.blockSize();
+      }
+    }
+  }
+
+  return result;
+}
+
+double computePSNR(const Image& a, const Image& b)
+{
+  const PixelFormat& format = a.format();
+
+  if (format != b.format() ||
+      format.isCompressed() ||
+      format.type() != PixelFormat::UINT8 ||
+      a.width() != b.width() ||
+      a.height() != b.height() ||
+      a.depth() != b.depth() ||
+      a.levelCount() != b.levelCount())
+  {
+    logError("Cannot compare images of different formats or dimensions");
+    return -1.0;
+  }
+
+  double error = 0.0;
+  size_t count = 0;
+
+  for (uint level = 0;  level < a.levelCount();  level++)
+  {
+    const size_t size = format.size(max(a.width() >> level, 1u),
+                                    max(a.height() >> level, 1u),
+                                    max(a.depth() >> level, 1u));
+
+    const uint8* x = (const uint8*) a.pixels(level);
+    const uint8* y = (const uint8*) b.pixels(level);
+
+    for (size_t i = 0;  i < size;  i++)
+    {
+      const double delta = double(x[i]) - double(y[i]);
+      error += delta * delta;
+    }
+
+    count += size;
+  }
+
+  if (error == 0.0)
+    return std::numeric_limits<double>::infinity();
+
+  return 10.0 * std::log10(255.0 * 255.0 * count / error);
+}
+
+} /*namespace wendy*/
+
@@ -28,9 +28,14 @@
 #include <wendy/Core.hpp>
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <exception>
+#include <mutex>
 #include <sstream>
 #include <iostream>
+#include <thread>
+#include <unordered_map>
 
 #include <cstdlib>
 #include <cstring>
@@ -42,7 +47,433 @@ namespace wendy
 namespace
 {
 
-std::vector<LogConsumer*> consumers;
+const size_t LOG_SLOT_COUNT = 512;
+const size_t LOG_SLOT_SIZE = 512;
+
+// Number of messages from the same format string delivered per second before
+// the rest are suppressed and summarized
+const uint LOG_RATE_LIMIT = 8;
+
+// Number of entries held for consumers, and how long the oldest of them may
+// wait, before the writer thread delivers them itself
+const size_t LOG_ENTRY_LIMIT = 1024;
+const std::chrono::seconds LOG_DELIVERY_DELAY(1);
+
+struct LogSlot
+{
+  std::atomic<size_t> sequence;
+  LogEntryType type;
+  const char* format;
+  std::string overflow;
+  char text[LOG_SLOT_SIZE];
+};
+
+struct LogRecord
+{
+  LogRecord(): count(0) { }
+  uint count;
+  LogEntryType type;
+  std::string text;
+};
+
+struct LogEntry
+{
+  LogEntryType type;
+  std::string text;
+};
+
+/* Bounded multiple-producer single-consumer queue of log entries, drained by
+ * a background thread.  Producers format directly into their reserved slot,
+ * so queueing an entry neither allocates nor takes a lock unless the message
+ * is too long for a slot.
+ *
+ * The background thread writes entries to stderr if there are no consumers,
+ * and otherwise queues them for delivery, so consumers are normally called on
+ * the threads calling flushLog or deliverLog.  If no thread does so in time,
+ * as with a program that has no window, the background thread delivers the
+ * entries itself instead of letting them pile up.
+ */
+class Logger
+{
+public:
+  Logger();
+  ~Logger();
+  void write(LogEntryType type, const char* format, va_list vl);
+  void flush();
+  void deliver();
+  void deliverEntries();
+  void deliverStale();
+  void addConsumer(LogConsumer* consumer);
+  void removeConsumer(LogConsumer* consumer);
+  static Logger* instance();
+private:
+  bool readSlot(LogSlot*& slot);
+  void dispatch(LogEntryType type, const std::string& text);
+  void dispatchSuppressed(const LogRecord& record);
+  void dispatchSuppressed();
+  void run();
+  LogSlot m_slots[LOG_SLOT_COUNT];
+  std::atomic<size_t> m_head;
+  size_t m_tail;
+  std::atomic<size_t> m_written;
+  std::atomic<bool> m_sleeping;
+  bool m_stopping;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeCondition;
+  std::condition_variable m_flushCondition;
+  std::mutex m_consumerMutex;
+  std::vector<LogConsumer*> m_consumers;
+  std::atomic<size_t> m_consumerCount;
+  std::mutex m_entryMutex;
+  std::vector<LogEntry> m_entries;
+  std::chrono::steady_clock::time_point m_entriesQueued;
+  std::unordered_map<const char*, LogRecord> m_formatRecords;
+  std::unordered_map<std::string, LogRecord> m_textRecords;
+  std::chrono::steady_clock::time_point m_windowStart;
+  std::thread m_thread;
+};
+
+std::atomic<int> level(INFO_LOG_ENTRY);
+std::atomic<bool> loggerDestroyed(false);
+
+const char* logPrefix(LogEntryType type)
+{
+  switch (type)
+  {
+    case ERROR_LOG_ENTRY:
+      return "Error: ";
+    case WARNING_LOG_ENTRY:
+      return "Warning: ";
+    default:
+      return "";
+  }
+}
+
+Logger::Logger():
+  m_head(0),
+  m_tail(0),
+  m_written(0),
+  m_sleeping(false),
+  m_stopping(false),
+  m_consumerCount(0),
+  m_windowStart(std::chrono::steady_clock::now())
+{
+  for (size_t i = 0;  i < LOG_SLOT_COUNT;  i++)
+    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+
+  m_thread = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+
+  m_wakeCondition.notify_one();
+  m_thread.join();
+
+  // Consumers are expected to be gone by now, so their entries go to stderr
+  for (const LogEntry& e : m_entries)
+    std::cerr << logPrefix(e.type) << e.text << '\n';
+
+  std::cerr.flush();
+
+  loggerDestroyed = true;
+}
+
+void Logger::write(LogEntryType type, const char* format, va_list vl)
+{
+  const bool writer = std::this_thread::get_id() == m_thread.get_id();
+
+  size_t position = m_head.load(std::memory_order_relaxed);
+  LogSlot* slot;
+
+  for (;;)
+  {
+    slot = m_slots + (position % LOG_SLOT_COUNT);
+
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const ptrdiff_t difference = ptrdiff_t(sequence - position);
+
+    if (difference == 0)
+    {
+      if (m_head.compare_exchange_weak(position, position + 1,
+                                       std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      // The queue is full, so wait for the writer thread to catch up, unless
+      // this is the writer thread logging from inside a consumer
+      if (writer)
+        return;
+
+      m_wakeCondition.notify_one();
+      std::this_thread::yield();
+      position = m_head.load(std::memory_order_relaxed);
+    }
+    else
+      position = m_head.load(std::memory_order_relaxed);
+  }
+
+  va_list copy;
+  va_copy(copy, vl);
+
+  slot->type = type;
+
+  // Messages are rate limited by format string, which is only compared by
+  // address as it may be gone by the time the entry is processed.  A format
+  // made of a lone conversion says nothing about the message, so those are
+  // rate limited by their text instead
+  if (std::strcmp(format, "%s") == 0)
+    slot->format = nullptr;
+  else
+    slot->format = format;
+
+  const int length = vsnprintf(slot->text, sizeof(slot->text), format, vl);
+  if (length < 0)
+    slot->text[sizeof(slot->text) - 1] = '\0';
+  else if (size_t(length) >= sizeof(slot->text))
+    slot->overflow = vlformat(format, copy);
+
+  va_end(copy);
+
+  slot->sequence.store(position + 1, std::memory_order_release);
+
+  if (m_sleeping.load(std::memory_order_relaxed))
+    m_wakeCondition.notify_one();
+}
+
+void Logger::flush()
+{
+  if (std::this_thread::get_id() == m_thread.get_id())
+    return;
+
+  const size_t target = m_head.load();
+
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wakeCondition.notify_one();
+    m_flushCondition.wait(lock, [this, target]() { return m_written >= target; });
+  }
+
+  deliver();
+}
+
+void Logger::deliver()
+{
+  // Consumers may log, which must not wait on the background thread while it
+  // waits on this one, so the entry lock is not held while delivering
+  std::lock_guard<std::mutex> lock(m_consumerMutex);
+  deliverEntries();
+}
+
+void Logger::deliverEntries()
+{
+  std::vector<LogEntry> entries;
+
+  {
+    std::lock_guard<std::mutex> entryLock(m_entryMutex);
+    entries.swap(m_entries);
+  }
+
+  for (const LogEntry& e : entries)
+  {
+    if (m_consumers.empty())
+      std::cerr << logPrefix(e.type) << e.text << '\n';
+    else
+    {
+      for (LogConsumer* c : m_consumers)
+        c->onLogEntry(e.type, e.text.c_str());
+    }
+  }
+
+  if (m_consumers.empty() && !entries.empty())
+    std::cerr.flush();
+}
+
+void Logger::deliverStale()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_entryMutex);
+
+    if (m_entries.empty())
+      return;
+
+    if (m_entries.size() < LOG_ENTRY_LIMIT &&
+        std::chrono::steady_clock::now() - m_entriesQueued < LOG_DELIVERY_DELAY)
+    {
+      return;
+    }
+  }
+
+  // Another thread holding the consumers is already delivering, and may be
+  // waiting on this one, so this must not block
+  std::unique_lock<std::mutex> lock(m_consumerMutex, std::try_to_lock);
+  if (lock.owns_lock())
+    deliverEntries();
+}
+
+void Logger::addConsumer(LogConsumer* consumer)
+{
+  std::lock_guard<std::mutex> lock(m_consumerMutex);
+  m_consumers.push_back(consumer);
+  m_consumerCount.store(m_consumers.size(), std::memory_order_release);
+}
+
+void Logger::removeConsumer(LogConsumer* consumer)
+{
+  // The derived part of the consumer is already destroyed, so it must be
+  // removed before anything more is delivered
+  {
+    std::lock_guard<std::mutex> lock(m_consumerMutex);
+    m_consumers.erase(std::find(m_consumers.begin(), m_consumers.end(), consumer));
+    m_consumerCount.store(m_consumers.size(), std::memory_order_release);
+  }
+
+  flush();
+}
+
+Logger* Logger::instance()
+{
+  if (loggerDestroyed)
+    return nullptr;
+
+  static Logger logger;
+  return &logger;
+}
+
+bool Logger::readSlot(LogSlot*& slot)
+{
+  slot = m_slots + (m_tail % LOG_SLOT_COUNT);
+  return slot->sequence.load(std::memory_order_acquire) == m_tail + 1;
+}
+
+void Logger::dispatch(LogEntryType type, const std::string& text)
+{
+  if (!m_consumerCount.load(std::memory_order_acquire))
+  {
+    std::cerr << logPrefix(type) << text << '\n';
+    return;
+  }
+
+  LogEntry entry;
+  entry.type = type;
+  entry.text = text;
+
+  std::lock_guard<std::mutex> lock(m_entryMutex);
+
+  if (m_entries.empty())
+    m_entriesQueued = std::chrono::steady_clock::now();
+
+  m_entries.push_back(std::move(entry));
+}
+
+void Logger::dispatchSuppressed(const LogRecord& record)
+{
+  // Errors are always delivered, so none of them were suppressed
+  if (record.type == ERROR_LOG_ENTRY)
+    return;
+
+  if (record.count > LOG_RATE_LIMIT)
+  {
+    const std::string message = format("%u similar messages suppressed, last: %s",
+                                       record.count - LOG_RATE_LIMIT,
+                                       record.text.c_str());
+    dispatch(record.type, message);
+  }
+}
+
+void Logger::dispatchSuppressed()
+{
+  for (const auto& r : m_formatRecords)
+    dispatchSuppressed(r.second);
+
+  for (const auto& r : m_textRecords)
+    dispatchSuppressed(r.second);
+
+  m_formatRecords.clear();
+  m_textRecords.clear();
+}
+
+void Logger::run()
+{
+  for (;;)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - m_windowStart >= std::chrono::seconds(1))
+    {
+      dispatchSuppressed();
+      m_windowStart = now;
+    }
+
+    LogSlot* slot;
+    bool delivered = false;
+
+    while (readSlot(slot))
+    {
+      std::string text;
+      if (slot->overflow.empty())
+        text = slot->text;
+      else
+        text.swap(slot->overflow);
+
+      const LogEntryType type = slot->type;
+      const char* format = slot->format;
+
+      slot->sequence.store(m_tail + LOG_SLOT_COUNT, std::memory_order_release);
+      m_tail++;
+
+      // Errors are never suppressed
+      LogRecord& record = format ? m_formatRecords[format] : m_textRecords[text];
+      record.type = type;
+      if (++record.count <= LOG_RATE_LIMIT || type == ERROR_LOG_ENTRY)
+        dispatch(type, text);
+      else
+        record.text = text;
+
+      delivered = true;
+    }
+
+    if (delivered)
+      std::cerr.flush();
+
+    deliverStale();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_written = m_tail;
+    m_flushCondition.notify_all();
+
+    if (m_stopping)
+    {
+      if (readSlot(slot))
+        continue;
+
+      lock.unlock();
+      dispatchSuppressed();
+      std::cerr.flush();
+      break;
+    }
+
+    m_sleeping = true;
+    if (!readSlot(slot))
+      m_wakeCondition.wait_for(lock, std::chrono::milliseconds(50));
+    m_sleeping = false;
+  }
+}
+
+void writeLog(LogEntryType type, const char* format, va_list vl)
+{
+  if (Logger* logger = Logger::instance())
+    logger->write(type, format, vl);
+  else
+    std::cerr << logPrefix(type) << vlformat(format, vl) << std::endl;
+}
 
 } /*namespace*/
 
@@ -203,119 +634,109 @@ std::string vlformat(const char* format, va_list vl)
 
 void logError(const char* format, ...)
 {
+  if (!isLogEnabled(ERROR_LOG_ENTRY))
+    return;
+
   va_list vl;
 
   va_start(vl, format);
-  std::string message = vlformat(format, vl);
+  writeLog(ERROR_LOG_ENTRY, format, vl);
   va_end(vl);
-
-  if (consumers.empty())
-    std::cerr << "Error: " << message << std::endl;
-  else
-  {
-    for (LogConsumer* c : consumers)
-      c->onLogEntry(ERROR_LOG_ENTRY, message.c_str());
-  }
 }
 
 void logWarning(const char* format, ...)
 {
+  if (!isLogEnabled(WARNING_LOG_ENTRY))
+    return;
+
   va_list vl;
 
   va_start(vl, format);
-  std::string message = vlformat(format, vl);
+  writeLog(WARNING_LOG_ENTRY, format, vl);
   va_end(vl);
-
-  if (consumers.empty())
-    std::cerr << "Warning: " << message << std::endl;
-  else
-  {
-    for (LogConsumer* c : consumers)
-      c->onLogEntry(WARNING_LOG_ENTRY, message.c_str());
-  }
 }
 
 void log(const char* format, ...)
 {
+  if (!isLogEnabled(INFO_LOG_ENTRY))
+    return;
+
   va_list vl;
 
   va_start(vl, format);
-  std::string message = vlformat(format, vl);
+  writeLog(INFO_LOG_ENTRY, format, vl);
   va_end(vl);
-
-  if (consumers.empty())
-    std::cerr << message << std::endl;
-  else
-  {
-    for (LogConsumer* c : consumers)
-      c->onLogEntry(INFO_LOG_ENTRY, message.c_str());
-  }
 }
 
-void panic(const char* format, ...)
+void setLogLevel(LogEntryType newLevel)
 {
-  va_list vl;
-
-  va_start(vl, format);
-  std::string message = vlformat(format, vl);
-  va_end(vl);
-
-  std::cerr << message << std::endl;
-  std::terminate();
+  level.store(newLevel, std::memory_order_relaxed);
 }
 
-Exception::Exception(const char* message):
-  message(message)
+LogEntryType logLevel()
 {
+  return LogEntryType(level.load(std::memory_order_relaxed));
 }
 
-const char* Exception::what() const throw()
+bool isLogEnabled(LogEntryType type)
 {
-  return message;
+  return type <= level.load(std::memory_order_relaxed);
 }
 
-bool RefBase::unreferenced(RefObject* object)
+void flushLog()
 {
-  return object->count == 0;
+  if (Logger* logger = Logger::instance())
+    logger->flush();
 }
 
-void RefBase::increment(RefObject* object)
+void deliverLog()
 {
-  object->count++;
+  if (Logger* logger = Logger::instance())
+    logger->deliver();
 }
 
-void RefBase::decrement(RefObject* object)
+void panic(const char* format, ...)
 {
-  object->count--;
+  va_list vl;
+
+  va_start(vl, format);
+  std::string message = vlformat(format, vl);
+  va_end(vl);
+
+  flushLog();
+
+  std::cerr << message << std::endl;
+  std::terminate();
 }
 
-RefObject::RefObject():
-  count(0)
+Exception::Exception(const char* message):
+  message(message)
 {
 }
 
-RefObject::RefObject(const RefObject& source):
-  count(0)
+const char* Exception::what() const throw()
 {
+  return message;
 }
 
 RefObject::~RefObject()
 {
 }
 
-RefObject& RefObject::operator = (const RefObject& source)
+AtomicRefObject::~AtomicRefObject()
 {
-  return *this;
 }
 
 LogConsumer::LogConsumer()
 {
-  consumers.push_back(this);
+  if (Logger* logger = Logger::instance())
+    logger->addConsumer(this);
 }
 
 LogConsumer::~LogConsumer()
 {
-  consumers.erase(std::find(consumers.begin(), consumers.end(), this));
+  if (Logger* logger = Logger::instance())
+    logger->removeConsumer(this);
 }
 
 } /*namespace wendy*/
@@ -25,9 +25,14 @@
 
 #include <wendy/Config.hpp>
 
+#include <wendy/Core.hpp>
+#include <wendy/Time.hpp>
+#include <wendy/Profile.hpp>
+
 #include <wendy/Drawer.hpp>
 #include <wendy/Layer.hpp>
 #include <wendy/Widget.hpp>
+#include <wendy/Button.hpp>
 #include <wendy/Label.hpp>
 #include <wendy/Layout.hpp>
 
@@ -41,6 +46,9 @@ namespace wendy
 namespace
 {
 
+// Number of frames kept when recording a trace from the interface
+const uint TRACE_FRAME_COUNT = 600;
+
 uint reduce(size_t value)
 {
   while (value >= 1024)
@@ -81,10 +89,12 @@ void Panel::draw() const
 
 Interface::Interface(Window& window, Drawer& drawer):
   Layer(drawer),
-  root(nullptr)
+  root(nullptr),
+  traceButton(nullptr),
+  tracePath("trace.json")
 {
   root = new Panel(*this);
-  root->setArea(Rect(0.f, 0.f, 150.f, 220.f));
+  root->setArea(Rect(0.f, 0.f, 150.f, 250.f));
 
   Layout* layout = new Layout(*this, root, VERTICAL, COVER_PARENT);
   layout->setBorderSize(2.f);
@@ -94,6 +104,9 @@ Interface::Interface(Window& window, Drawer& drawer):
     labels[i] = new Label(*this, layout);
     labels[i]->setTextAlignment(RIGHT_ALIGNED);
   }
+
+  traceButton = new PushButton(*this, layout, "Record trace");
+  traceButton->pushed().connect(*this, &Interface::onTraceButtonPushed);
 }
 
 void Interface::update()
@@ -107,6 +120,9 @@ void Interface::update()
     updateCountItem(ITEM_FRAMERATE, "fps", (size_t) (stats->frameRate() + 0.5f));
     updateCountItem(ITEM_STATECHANGES, "states / f", frame.stateChangeCount);
     updateCountItem(ITEM_OPERATIONS, "operations / f", frame.operationCount);
+    updateCountItem(ITEM_FLUSHES, "flushes / f", frame.flushCount);
+    updateCountItem(ITEM_SKIPPEDUNIFORMS, "skipped uniforms / f", frame.skippedUniformCount);
+    updateCountItem(ITEM_SKIPPEDTEXTURES, "skipped textures / f", frame.skippedTextureCount);
     updateCountItem(ITEM_VERTICES, "vertices / f", frame.vertexCount);
     updateCountItem(ITEM_POINTS, "points / f", frame.pointCount);
     updateCountItem(ITEM_LINES, "lines / f", frame.lineCount);
@@ -165,6 +181,36 @@ void Interface::updateCountSizeItem(Item item,
                                suffix(size)));
 }
 
+void Interface::onTraceButtonPushed(Button& button)
+{
+  Profile* profile = Profile::currentNode();
+  if (!profile)
+  {
+    logWarning("No profile to record a trace from");
+    return;
+  }
+
+  if (!profile->isRecording())
+  {
+    profile->setHistory(TRACE_FRAME_COUNT);
+    button.setText("Save trace");
+    return;
+  }
+
+  ProfileTrace trace;
+  trace.addProfile(*profile);
+
+  if (trace.write(tracePath))
+  {
+    log("Wrote trace of %u frames to %s",
+        profile->historyFrameCount(),
+        tracePath.name().c_str());
+  }
+
+  profile->setHistory(0);
+  button.setText("Record trace");
+}
+
   } /*namespace debug*/
 } /*namespace wendy*/
 
@@ -40,22 +40,43 @@ namespace
 
 Bimap<std::string, WidgetState> widgetStateMap;
 
-class ElementVertex
+// Clips the specified line segment against the specified rectangle
+bool clipLine(vec2& start, vec2& end, const Rect& clip)
 {
-public:
-  inline void set(vec2 newSizeScale, vec2 newOffsetScale, vec2 newTexScale)
+  float minX, minY, maxX, maxY;
+  clip.bounds(minX, minY, maxX, maxY);
+
+  const vec2 delta = end - start;
+  const float p[4] = { -delta.x, delta.x, -delta.y, delta.y };
+  const float q[4] = { start.x - minX, maxX - start.x, start.y - minY, maxY - start.y };
+
+  float t0 = 0.f, t1 = 1.f;
+
+  for (int i = 0;  i < 4;  i++)
   {
-    sizeScale = newSizeScale;
-    offsetScale = newOffsetScale;
-    texScale = newTexScale;
+    if (p[i] == 0.f)
+    {
+      if (q[i] < 0.f)
+        return false;
+    }
+    else
+    {
+      const float t = q[i] / p[i];
+
+      if (p[i] < 0.f)
+        t0 = max(t0, t);
+      else
+        t1 = min(t1, t);
+    }
   }
-  vec2 sizeScale;
-  vec2 offsetScale;
-  vec2 texScale;
-  static VertexFormat format;
-};
 
-VertexFormat ElementVertex::format("2f:vSizeScale 2f:vOffsetScale 2f:vTexScale");
+  if (t0 > t1)
+    return false;
+
+  end = start + delta * t1;
+  start = start + delta * t0;
+  return true;
+}
 
 const uint THEME_XML_VERSION = 3;
 
@@ -74,7 +95,7 @@ void Alignment::set(HorzAlignment newHorizontal, VertAlignment newVertical)
 }
 
 Theme::Theme(const ResourceInfo& info):
-  Resource(info)
+  Resource(info, this)
 {
 }
 
@@ -88,7 +109,7 @@ Ref<Theme> Theme::read(RenderContext& context, const std::string& name)
     widgetStateMap["selected"] = STATE_SELECTED;
   }
 
-  if (Theme* cached = context.cache().find<Theme>(name))
+  if (Ref<Theme> cached = context.cache().find<Theme>(name))
     return cached;
 
   const Path path = context.cache().findFile(name);
@@ -211,9 +232,63 @@ void Drawer::begin()
 
 void Drawer::end()
 {
+  flush();
   m_context.setSharedProgramState(nullptr);
 }
 
+void Drawer::flush()
+{
+  if (m_vertices.empty())
+    return;
+
+  VertexRange vertices = m_context.allocateVertices(m_vertices.size(),
+                                                    Vertex4fc2ft2fv::format);
+  if (vertices.isEmpty())
+  {
+    logError("Failed to allocate vertices for UI drawing");
+    m_vertices.clear();
+    m_indices.clear();
+    return;
+  }
+
+  vertices.copyFrom(m_vertices.data());
+
+  if (m_batchTexture)
+  {
+    // Setting the texture bumps the revision of the pass, which makes its
+    // next apply upload every uniform again
+    const UniformStateIndex index = m_batchPass->uniformStateIndex("image");
+    if (m_batchPass->uniformTexture(index) != m_batchTexture)
+      m_batchPass->setUniformTexture(index, m_batchTexture);
+  }
+
+  m_batchPass->apply();
+
+  if (m_indices.empty())
+    m_context.render(PrimitiveRange(m_batchType, vertices));
+  else
+  {
+    IndexRange indices = m_context.allocateIndices(m_indices.size(), INDEX_UINT32);
+    if (indices.indexBuffer())
+    {
+      indices.copyFrom(m_indices.data());
+
+      m_context.render(PrimitiveRange(m_batchType,
+                                      *vertices.vertexBuffer(),
+                                      indices,
+                                      vertices.start()));
+    }
+    else
+      logError("Failed to allocate indices for UI drawing");
+  }
+
+  if (RenderStats* stats = m_context.stats())
+    stats->addFlush();
+
+  m_vertices.clear();
+  m_indices.clear();
+}
+
 bool Drawer::pushClipArea(const Rect& area)
 {
   return m_clipAreaStack.push(area);
@@ -226,31 +301,21 @@ void Drawer::popClipArea()
 
 void Drawer::drawPoint(vec2 point, vec4 color)
 {
-  Vertex2fv vertex;
-  vertex.position = point;
-
-  VertexRange range = m_context.allocateVertices(1, Vertex2fv::format);
-  if (range.isEmpty())
+  if (!m_clipAreaStack.isEmpty() && !m_clipAreaStack.total().contains(point))
     return;
 
-  range.copyFrom(&vertex);
-  setDrawingState(color, true);
-  m_context.render(PrimitiveRange(POINT_LIST, range));
+  setBatch(m_drawPass, nullptr, POINT_LIST);
+  addVertex(point, color);
 }
 
 void Drawer::drawLine(vec2 start, vec2 end, vec4 color)
 {
-  Vertex2fv vertices[2];
-  vertices[0].position = start;
-  vertices[1].position = end;
-
-  VertexRange range = m_context.allocateVertices(2, Vertex2fv::format);
-  if (range.isEmpty())
+  if (!m_clipAreaStack.isEmpty() && !clipLine(start, end, m_clipAreaStack.total()))
     return;
 
-  range.copyFrom(vertices);
-  setDrawingState(color, true);
-  m_context.render(PrimitiveRange(LINE_LIST, range));
+  setBatch(m_drawPass, nullptr, LINE_LIST);
+  addVertex(start, color);
+  addVertex(end, color);
 }
 
 void Drawer::drawRect(const Rect& rect, vec4 color)
@@ -261,78 +326,28 @@ void Drawer::drawRect(const Rect& rect, vec4 color)
   if (maxX - minX < 1.f || maxY - minY < 1.f)
     return;
 
-  Vertex2fv vertices[4];
-  vertices[0].position = vec2(minX, minY);
-  vertices[1].position = vec2(maxX, minY);
-  vertices[2].position = vec2(maxX, maxY);
-  vertices[3].position = vec2(minX, maxY);
-
-  VertexRange range = m_context.allocateVertices(4, Vertex2fv::format);
-  if (range.isEmpty())
-    return;
-
-  range.copyFrom(vertices);
-  setDrawingState(color, true);
-  m_context.render(PrimitiveRange(LINE_LOOP, range));
+  drawLine(vec2(minX, minY), vec2(maxX, minY), color);
+  drawLine(vec2(maxX, minY), vec2(maxX, maxY), color);
+  drawLine(vec2(maxX, maxY), vec2(minX, maxY), color);
+  drawLine(vec2(minX, maxY), vec2(minX, minY), color);
 }
 
 void Drawer::fillRect(const Rect& rect, vec4 color)
 {
-  float minX, minY, maxX, maxY;
-  rect.bounds(minX, minY, maxX, maxY);
-
-  if (maxX - minX < 1.f || maxY - minY < 1.f)
-    return;
-
-  Vertex2fv vertices[4];
-  vertices[0].position = vec2(minX, minY);
-  vertices[1].position = vec2(maxX, minY);
-  vertices[2].position = vec2(maxX, maxY);
-  vertices[3].position = vec2(minX, maxY);
-
-  VertexRange range = m_context.allocateVertices(4, Vertex2fv::format);
-  if (range.isEmpty())
+  if (rect.size.x < 1.f || rect.size.y < 1.f)
     return;
 
-  range.copyFrom(vertices);
-  setDrawingState(color, false);
-  m_context.render(PrimitiveRange(TRIANGLE_FAN, range));
+  setBatch(m_drawPass, nullptr, TRIANGLE_LIST);
+  addQuad(rect, Rect(), color);
 }
 
 void Drawer::blitTexture(const Rect& area, Texture& texture, vec4 color)
 {
-  float minX, minY, maxX, maxY;
-  area.bounds(minX, minY, maxX, maxY);
-
-  if (maxX - minX < 1.f || maxY - minY < 1.f)
-    return;
-
-  Vertex2ft2fv vertices[4];
-  vertices[0].texcoord = vec2(0.f, 0.f);
-  vertices[0].position = vec2(minX, minY);
-  vertices[1].texcoord = vec2(1.f, 0.f);
-  vertices[1].position = vec2(maxX, minY);
-  vertices[2].texcoord = vec2(1.f, 1.f);
-  vertices[2].position = vec2(maxX, maxY);
-  vertices[3].texcoord = vec2(0.f, 1.f);
-  vertices[3].position = vec2(minX, maxY);
-
-  VertexRange range = m_context.allocateVertices(4, Vertex2ft2fv::format);
-  if (range.isEmpty())
+  if (area.size.x < 1.f || area.size.y < 1.f)
     return;
 
-  range.copyFrom(vertices);
-
-  if (color.a < 1.f || texture.format().semantic() == PixelFormat::RGBA)
-    m_blitPass.setBlendFactors(BLEND_SRC_ALPHA, BLEND_ONE_MINUS_SRC_ALPHA);
-  else
-    m_blitPass.setBlendFactors(BLEND_ONE, BLEND_ZERO);
-
-  m_blitPass.setUniformState("color", color);
-  m_blitPass.setUniformTexture("image", &texture);
-  m_blitPass.apply();
-
-  m_context.render(PrimitiveRange(TRIANGLE_FAN, range));
+  setBatch(m_blitPass, &texture, TRIANGLE_LIST);
+  addQuad(area, Rect(0.f, 0.f, 1.f, 1.f), color);
 }
 
 void Drawer::drawText(const Rect& area,
@@ -375,7 +390,13 @@ void Drawer::drawText(const Rect& area,
       panic("Invalid vertical alignment");
   }
 
-  m_font->drawText(pen, vec4(color, 1.f), text);
+  m_font->realizeText(pen, text, m_quads);
+
+  for (const GlyphQuad& quad : m_quads)
+  {
+    setBatch(m_textPass, &(m_font->texture(quad.page)), TRIANGLE_LIST);
+    addQuad(quad.area, quad.mapping, vec4(color, 1.f));
+  }
 }
 
 void Drawer::drawText(const Rect& area,
@@ -462,7 +483,9 @@ std::unique_ptr<Drawer> Drawer::create(RenderContext& context)
 }
 
 Drawer::Drawer(RenderContext& context):
-  m_context(context)
+  m_context(context),
+  m_batchPass(nullptr),
+  m_batchType(TRIANGLE_LIST)
 {
 }
 
@@ -470,79 +493,6 @@ bool Drawer::init()
 {
   m_state = new SharedProgramState();
 
-  // Set up element geometry
-  {
-    m_vertexBuffer = VertexBuffer::create(m_context, 16, ElementVertex::format, USAGE_STATIC);
-    if (!m_vertexBuffer)
-      return false;
-
-    ElementVertex vertices[16];
-
-    // These are scaling factors used when rendering UI widget elements
-    //
-    // There are three kinds:
-    //  * The size scale, which when multiplied by the screen space size
-    //    of the element places vertices in the closest corner
-    //  * The offset scale, which when multiplied by the texture space size of
-    //    the element pulls the vertices defining its inner edges towards the
-    //    center of the element
-    //  * The texture coordinate scale, which when multiplied by the texture
-    //    space size of the element becomes the relative texture coordinate
-    //    of that vertex
-    //
-    // This allows rendering of UI elements by changing only four uniforms: the
-    // position and size of the element in screen and texture space.
-
-    vertices[0x0].set(vec2(0.f, 0.f), vec2(  0.f,   0.f), vec2( 0.f,  0.f));
-    vertices[0x1].set(vec2(0.f, 0.f), vec2( 0.5f,   0.f), vec2(0.5f,  0.f));
-    vertices[0x2].set(vec2(1.f, 0.f), vec2(-0.5f,   0.f), vec2(0.5f,  0.f));
-    vertices[0x3].set(vec2(1.f, 0.f), vec2(  0.f,   0.f), vec2( 1.f,  0.f));
-
-    vertices[0x4].set(vec2(0.f, 0.f), vec2(  0.f,  0.5f), vec2( 0.f, 0.5f));
-    vertices[0x5].set(vec2(0.f, 0.f), vec2( 0.5f,  0.5f), vec2(0.5f, 0.5f));
-    vertices[0x6].set(vec2(1.f, 0.f), vec2(-0.5f,  0.5f), vec2(0.5f, 0.5f));
-    vertices[0x7].set(vec2(1.f, 0.f), vec2(  0.f,  0.5f), vec2( 1.f, 0.5f));
-
-    vertices[0x8].set(vec2(0.f, 1.f), vec2(  0.f, -0.5f), vec2( 0.f, 0.5f));
-    vertices[0x9].set(vec2(0.f, 1.f), vec2( 0.5f, -0.5f), vec2(0.5f, 0.5f));
-    vertices[0xa].set(vec2(1.f, 1.f), vec2(-0.5f, -0.5f), vec2(0.5f, 0.5f));
-    vertices[0xb].set(vec2(1.f, 1.f), vec2(  0.f, -0.5f), vec2( 1.f, 0.5f));
-
-    vertices[0xc].set(vec2(0.f, 1.f), vec2(  0.f,   0.f), vec2( 0.f,  1.f));
-    vertices[0xd].set(vec2(0.f, 1.f), vec2( 0.5f,   0.f), vec2(0.5f,  1.f));
-    vertices[0xe].set(vec2(1.f, 1.f), vec2(-0.5f,   0.f), vec2(0.5f,  1.f));
-    vertices[0xf].set(vec2(1.f, 1.f), vec2(  0.f,   0.f), vec2( 1.f,  1.f));
-
-    m_vertexBuffer->copyFrom(vertices, 16);
-
-    m_indexBuffer = IndexBuffer::create(m_context, 54, INDEX_UINT8, USAGE_STATIC);
-    if (!m_indexBuffer)
-      return false;
-
-    uint8 indices[54];
-    size_t index = 0;
-
-    // This is a perfectly normal indexed triangle list using the vertices above
-
-    for (int y = 0;  y < 3;  y++)
-    {
-      for (int x = 0;  x < 3;  x++)
-      {
-        indices[index++] = x + y * 4;
-        indices[index++] = (x + 1) + (y + 1) * 4;
-        indices[index++] = x + (y + 1) * 4;
-
-        indices[index++] = x + y * 4;
-        indices[index++] = (x + 1) + y * 4;
-        indices[index++] = (x + 1) + (y + 1) * 4;
-      }
-    }
-
-    m_indexBuffer->copyFrom(indices, 54);
-
-    m_range = PrimitiveRange(TRIANGLE_LIST, *m_vertexBuffer, *m_indexBuffer);
-  }
-
   // Load default theme
   {
     const std::string themeName("wendy/UIDefault.theme");
@@ -569,12 +519,8 @@ bool Drawer::init()
     }
 
     ProgramInterface interface;
-    interface.addUniform("elementPos", UNIFORM_VEC2);
-    interface.addUniform("elementSize", UNIFORM_VEC2);
-    interface.addUniform("texPos", UNIFORM_VEC2);
-    interface.addUniform("texSize", UNIFORM_VEC2);
     interface.addUniform("image", UNIFORM_SAMPLER_RECT);
-    interface.addAttributes(ElementVertex::format);
+    interface.addAttributes(Vertex4fc2ft2fv::format);
 
     if (!interface.matches(*program, true))
     {
@@ -589,11 +535,6 @@ bool Drawer::init()
     m_elementPass.setUniformTexture("image", m_theme->m_texture);
     m_elementPass.setBlendFactors(BLEND_SRC_ALPHA, BLEND_ONE_MINUS_SRC_ALPHA);
     m_elementPass.setMultisampling(false);
-
-    m_elementPosIndex = m_elementPass.uniformStateIndex("elementPos");
-    m_elementSizeIndex = m_elementPass.uniformStateIndex("elementSize");
-    m_texPosIndex = m_elementPass.uniformStateIndex("texPos");
-    m_texSizeIndex = m_elementPass.uniformStateIndex("texSize");
   }
 
   // Set up solid pass
@@ -608,8 +549,7 @@ bool Drawer::init()
     }
 
     ProgramInterface interface;
-    interface.addUniform("color", UNIFORM_VEC4);
-    interface.addAttributes(Vertex2fv::format);
+    interface.addAttributes(Vertex4fc2ft2fv::format);
 
     if (!interface.matches(*program, true))
     {
@@ -622,6 +562,7 @@ bool Drawer::init()
     m_drawPass.setCullFace(FACE_NONE);
     m_drawPass.setDepthTesting(false);
     m_drawPass.setDepthWriting(false);
+    m_drawPass.setBlendFactors(BLEND_SRC_ALPHA, BLEND_ONE_MINUS_SRC_ALPHA);
     m_drawPass.setMultisampling(false);
   }
 
@@ -638,8 +579,7 @@ bool Drawer::init()
 
     ProgramInterface interface;
     interface.addUniform("image", UNIFORM_SAMPLER_2D);
-    interface.addUniform("color", UNIFORM_VEC4);
-    interface.addAttributes(Vertex2ft2fv::format);
+    interface.addAttributes(Vertex4fc2ft2fv::format);
 
     if (!interface.matches(*program, true))
     {
@@ -652,34 +592,151 @@ bool Drawer::init()
     m_blitPass.setCullFace(FACE_NONE);
     m_blitPass.setDepthTesting(false);
     m_blitPass.setDepthWriting(false);
+    m_blitPass.setBlendFactors(BLEND_SRC_ALPHA, BLEND_ONE_MINUS_SRC_ALPHA);
     m_blitPass.setMultisampling(false);
   }
 
+  // Set up text pass
+  {
+    Ref<Program> program = Program::read(m_context,
+                                         "wendy/UIDrawMapped.vs",
+                                         "wendy/UIDrawText.fs");
+    if (!program)
+    {
+      logError("Failed to load UI text shader program");
+      return false;
+    }
+
+    ProgramInterface interface;
+    interface.addUniform("image", UNIFORM_SAMPLER_RECT);
+    interface.addAttributes(Vertex4fc2ft2fv::format);
+
+    if (!interface.matches(*program, true))
+    {
+      logError("UI text shader program %s does not conform to the required interface",
+               program->name().c_str());
+      return false;
+    }
+
+    m_textPass.setProgram(program);
+    m_textPass.setCullFace(FACE_NONE);
+    m_textPass.setDepthTesting(false);
+    m_textPass.setDepthWriting(false);
+    m_textPass.setBlendFactors(BLEND_SRC_ALPHA, BLEND_ONE_MINUS_SRC_ALPHA);
+    m_textPass.setMultisampling(false);
+  }
+
   return true;
 }
 
 void Drawer::drawElement(const Rect& area, const Rect& mapping)
 {
-  m_elementPass.setUniformState(m_elementPosIndex, area.position);
-  m_elementPass.setUniformState(m_elementSizeIndex, area.size);
-  m_elementPass.setUniformState(m_texPosIndex, mapping.position);
-  m_elementPass.setUniformState(m_texSizeIndex, mapping.size);
-  m_elementPass.apply();
+  setBatch(m_elementPass, m_theme->m_texture, TRIANGLE_LIST);
 
-  m_context.render(m_range);
+  // Elements are split into nine cells, where the corners keep their size in
+  // texels and the edges and center are stretched to fill the area
+
+  const vec2 corner = mapping.size / 2.f;
+
+  const vec2 positions[4] =
+  {
+    area.position,
+    area.position + corner,
+    area.position + area.size - corner,
+    area.position + area.size
+  };
+
+  const vec2 texcoords[4] =
+  {
+    mapping.position,
+    mapping.position + corner,
+    mapping.position + corner,
+    mapping.position + mapping.size
+  };
+
+  for (int y = 0;  y < 3;  y++)
+  {
+    for (int x = 0;  x < 3;  x++)
+    {
+      const vec2 minArea(positions[x].x, positions[y].y);
+      const vec2 maxArea(positions[x + 1].x, positions[y + 1].y);
+      const vec2 minMapping(texcoords[x].x, texcoords[y].y);
+      const vec2 maxMapping(texcoords[x + 1].x, texcoords[y + 1].y);
+
+      addQuad(Rect(minArea, maxArea - minArea),
+              Rect(minMapping, maxMapping - minMapping),
+              vec4(1.f));
+    }
+  }
 }
 
-void Drawer::setDrawingState(vec4 color, bool wireframe)
+void Drawer::setBatch(Pass& pass, Texture* texture, PrimitiveType type)
 {
-  m_drawPass.setUniformState("color", color);
+  if (&pass == m_batchPass && texture == m_batchTexture && type == m_batchType)
+    return;
 
-  if (color.a == 1.f)
-    m_drawPass.setBlendFactors(BLEND_ONE, BLEND_ZERO);
-  else
-    m_drawPass.setBlendFactors(BLEND_SRC_ALPHA, BLEND_ONE_MINUS_SRC_ALPHA);
+  flush();
+
+  m_batchPass = &pass;
+  m_batchTexture = texture;
+  m_batchType = type;
+}
+
+void Drawer::addVertex(vec2 position, vec4 color)
+{
+  m_vertices.push_back(Vertex4fc2ft2fv());
+
+  Vertex4fc2ft2fv& vertex = m_vertices.back();
+  vertex.color = color;
+  vertex.texcoord = vec2(0.f);
+  vertex.position = position;
+}
+
+void Drawer::addQuad(const Rect& area, const Rect& mapping, vec4 color)
+{
+  if (area.size.x <= 0.f || area.size.y <= 0.f)
+    return;
+
+  Rect a = area;
+  Rect m = mapping;
+
+  if (!m_clipAreaStack.isEmpty())
+  {
+    if (!a.clipBy(m_clipAreaStack.total()))
+      return;
+
+    if (a != area)
+    {
+      const vec2 scale = mapping.size / area.size;
+      m.position = mapping.position + (a.position - area.position) * scale;
+      m.size = a.size * scale;
+    }
+  }
+
+  if (a.size.x <= 0.f || a.size.y <= 0.f)
+    return;
 
-  m_drawPass.setWireframe(wireframe);
-  m_drawPass.apply();
+  const uint32 base = m_vertices.size();
+  m_vertices.resize(base + 4);
+
+  Vertex4fc2ft2fv* vertices = &m_vertices[base];
+  vertices[0].color = color;
+  vertices[0].texcoord = m.position;
+  vertices[0].position = a.position;
+  vertices[1].color = color;
+  vertices[1].texcoord = m.position + vec2(m.size.x, 0.f);
+  vertices[1].position = a.position + vec2(a.size.x, 0.f);
+  vertices[2].color = color;
+  vertices[2].texcoord = m.position + m.size;
+  vertices[2].position = a.position + a.size;
+  vertices[3].color = color;
+  vertices[3].texcoord = m.position + vec2(0.f, m.size.y);
+  vertices[3].position = a.position + vec2(0.f, a.size.y);
+
+  const uint32 indices[] = { 0, 1, 2, 2, 3, 0 };
+
+  for (uint32 index : indices)
+    m_indices.push_back(base + index);
 }
 
 } /*namespace wendy*/
@@ -161,7 +161,11 @@ Ref<Face> Face::create(const ResourceInfo& info, const char* data, size_t size)
 
 Ref<Face> Face::read(ResourceCache& cache, const std::string& name)
 {
-  if (Face* cached = cache.find<Face>(name))
+  // This may run on loader threads, so keep others from creating the same
+  // resource until this one is done
+  ResourceCache::NameLock lock(cache, name);
+
+  if (Ref<Face> cached = cache.find<Face>(name))
     return cached;
 
   const Path path = cache.findFile(name);
@@ -190,7 +194,7 @@ Ref<Face> Face::read(ResourceCache& cache, const std::string& name)
 }
 
 Face::Face(const ResourceInfo& info):
-  Resource(info),
+  Resource(info, this),
   m_info(nullptr)
 {
 }
@@ -45,57 +45,67 @@ namespace
 
 const uint FONT_XML_VERSION = 2;
 
+const uint GLYPH_PAGE_SIZE = 512;
+const uint MAX_GLYPH_PAGES = 4;
+
+const uint NO_SLOT = 0xffffffff;
+const uint32 NO_CODEPOINT = 0xffffffff;
+
 } /*namespace*/
 
 void Font::drawText(vec2 pen, vec4 color, const char* text)
 {
-  uint vertexCount = 0;
+  realizeText(pen, text, m_quads);
+  if (m_quads.empty())
+    return;
 
-  // Realize vertices for glyphs
+  const uint vertexCount = m_quads.size() * 4;
+  const uint indexCount = m_quads.size() * 6;
+
+  m_vertices.resize(vertexCount);
+
+  for (size_t i = 0;  i < m_quads.size();  i++)
   {
-    const size_t length = std::strlen(text);
-    m_vertices.resize(length * 6);
+    const Rect& pa = m_quads[i].area;
+    const Rect& ta = m_quads[i].mapping;
+    Vertex2ft2fv* vertices = &m_vertices[i * 4];
+
+    vertices[0].texcoord = ta.position;
+    vertices[0].position = pa.position;
+    vertices[1].texcoord = ta.position + vec2(ta.size.x, 0.f);
+    vertices[1].position = pa.position + vec2(pa.size.x, 0.f);
+    vertices[2].texcoord = ta.position + ta.size;
+    vertices[2].position = pa.position + pa.size;
+    vertices[3].texcoord = ta.position + vec2(0.f, ta.size.y);
+    vertices[3].position = pa.position + vec2(0.f, pa.size.y);
+  }
 
-    for (const char* c = text;  *c != '\0'; )
+  // Group the indices by glyph texture page so each page is drawn once
+  uint pageIndexCounts[MAX_GLYPH_PAGES] = {};
+
+  m_indices.clear();
+  m_indices.reserve(indexCount);
+
+  for (uint page = 0;  page < m_pages.size();  page++)
+  {
+    for (size_t i = 0;  i < m_quads.size();  i++)
     {
-      const uint32 codepoint = utf8::next<const char*>(c, text + length);
-      const Glyph* glyph = findGlyph(codepoint);
-      if (!glyph)
-      {
-        glyph = findGlyph(0xfffd);
-        if (!glyph)
-          continue;
-      }
+      if (m_quads[i].page != page)
+        continue;
 
-      pen = round(pen);
+      const uint32 base = i * 4;
 
-      if (all(greaterThan(glyph->size, vec2(0.f))))
-      {
-        const Rect pa(pen + glyph->bearing - vec2(0.5f), glyph->size);
-        const Rect ta(glyph->offset + vec2(0.5f), glyph->size);
-
-        m_vertices[vertexCount + 0].texcoord = ta.position;
-        m_vertices[vertexCount + 0].position = pa.position;
-        m_vertices[vertexCount + 1].texcoord = ta.position + vec2(ta.size.x, 0.f);
-        m_vertices[vertexCount + 1].position = pa.position + vec2(pa.size.x, 0.f);
-        m_vertices[vertexCount + 2].texcoord = ta.position + ta.size;
-        m_vertices[vertexCount + 2].position = pa.position + pa.size;
-
-        m_vertices[vertexCount + 3] = m_vertices[vertexCount + 2];
-        m_vertices[vertexCount + 4].texcoord = ta.position + vec2(0.f, ta.size.y);
-        m_vertices[vertexCount + 4].position = pa.position + vec2(0.f, pa.size.y);
-        m_vertices[vertexCount + 5] = m_vertices[vertexCount + 0];
-
-        vertexCount += 6;
-      }
+      m_indices.push_back(base + 0);
+      m_indices.push_back(base + 1);
+      m_indices.push_back(base + 2);
+      m_indices.push_back(base + 2);
+      m_indices.push_back(base + 3);
+      m_indices.push_back(base + 0);
 
-      pen += vec2(glyph->advance, 0.f);
+      pageIndexCounts[page] += 6;
     }
   }
 
-  if (!vertexCount)
-    return;
-
   VertexRange range = m_context.allocateVertices(vertexCount,
                                                  Vertex2ft2fv::format);
   if (range.isEmpty())
@@ -104,12 +114,74 @@ void Font::drawText(vec2 pen, vec4 color, const char* text)
     return;
   }
 
+  IndexRange indices = m_context.allocateIndices(indexCount, INDEX_UINT32);
+  if (!indices.indexBuffer())
+  {
+    logError("Failed to allocate indices for text drawing");
+    return;
+  }
+
   range.copyFrom(m_vertices.data());
+  indices.copyFrom(m_indices.data());
 
   m_pass.setUniformState(m_colorIndex, color);
-  m_pass.apply();
 
-  m_context.render(PrimitiveRange(TRIANGLE_LIST, range));
+  size_t start = indices.start();
+
+  for (uint page = 0;  page < m_pages.size();  page++)
+  {
+    if (!pageIndexCounts[page])
+      continue;
+
+    m_pass.setUniformTexture(m_glyphsIndex, m_pages[page].texture);
+    m_pass.apply();
+
+    m_context.render(PrimitiveRange(TRIANGLE_LIST,
+                                    *range.vertexBuffer(),
+                                    IndexRange(*indices.indexBuffer(),
+                                               start,
+                                               pageIndexCounts[page]),
+                                    range.start()));
+
+    start += pageIndexCounts[page];
+  }
+}
+
+void Font::realizeText(vec2 pen, const char* text, std::vector<GlyphQuad>& quads)
+{
+  quads.clear();
+
+  const size_t length = std::strlen(text);
+
+  for (const char* c = text;  *c != '\0'; )
+  {
+    const uint32 codepoint = utf8::next<const char*>(c, text + length);
+    const Glyph* glyph = findGlyph(codepoint);
+    if (!glyph)
+    {
+      glyph = findGlyph(0xfffd);
+      if (!glyph)
+        continue;
+    }
+
+    pen = round(pen);
+
+    if (all(greaterThan(glyph->size, vec2(0.f))))
+    {
+      GlyphQuad quad;
+      quad.area = Rect(pen + glyph->bearing - vec2(0.5f), glyph->size);
+      quad.mapping = Rect(glyph->offset + vec2(0.5f), glyph->size);
+      quad.page = glyph->page;
+      quads.push_back(quad);
+    }
+
+    pen += vec2(glyph->advance, 0.f);
+  }
+}
+
+Texture& Font::texture(uint page) const
+{
+  return *m_pages[page].texture;
 }
 
 Rect Font::boundsOf(const char* text)
@@ -191,7 +263,7 @@ Ref<Font> Font::create(const ResourceInfo& info,
 
 Ref<Font> Font::read(RenderContext& context, const std::string& name)
 {
-  if (Font* cached = context.cache().find<Font>(name))
+  if (Ref<Font> cached = context.cache().find<Font>(name))
     return cached;
 
   const Path path = context.cache().findFile(name);
@@ -237,7 +309,7 @@ Ref<Font> Font::read(RenderContext& context, const std::string& name)
 }
 
 Font::Font(const ResourceInfo& info, RenderContext& context):
-  Resource(info),
+  Resource(info, this),
   m_context(context)
 {
 }
@@ -256,8 +328,10 @@ bool Font::init(Face& face, uint height)
   m_ascender  = ceil(face.ascender(m_scale));
   m_descender = ceil(face.descender(m_scale));
 
-  if (uint(m_width) + 1 > m_context.limits().maxTextureSize ||
-      uint(m_height) + 1 > m_context.limits().maxTextureSize)
+  m_pageSize = max(GLYPH_PAGE_SIZE, (uint(m_height) + 1) * 8);
+  m_pageSize = min(m_pageSize, m_context.limits().maxTextureSize);
+
+  if (uint(m_width) + 2 > m_pageSize || uint(m_height) + 2 > m_pageSize)
   {
     logError("Font %s is too large for texture size limits", name().c_str());
     return false;
@@ -295,13 +369,13 @@ bool Font::init(Face& face, uint height)
     m_pass.setUniformState("color", vec4(1.f));
 
     m_colorIndex = m_pass.uniformStateIndex("color");
+    m_glyphsIndex = m_pass.uniformStateIndex("glyphs");
   }
 
-  m_position = ivec2(1);
-
-  if (!addGlyphTextureRow())
+  if (!addGlyphPage())
     return false;
 
+  m_pass.setUniformTexture(m_glyphsIndex, m_pages.front().texture);
   return true;
 }
 
@@ -311,86 +385,178 @@ const Font::Glyph* Font::addGlyph(uint32 codepoint)
   if (!index)
     return nullptr;
 
-  m_glyphs.push_back(Glyph());
-  Glyph& glyph = m_glyphs.back();
-
+  Glyph glyph;
   glyph.codepoint = codepoint;
   glyph.advance = ceil(m_face->advance(index, m_scale));
   glyph.bearing = ceil(m_face->bearing(index, m_scale));
+  glyph.slot = NO_SLOT;
+  glyph.page = 0;
+  glyph.lastUse = m_context.frameCount();
 
-  if (Ref<Image> image = m_face->glyph(index, m_scale))
+  Ref<Image> image = m_face->glyph(index, m_scale);
+  if (image && image->width() && image->height())
   {
-    if (m_position.x + image->width() + 1 > m_texture->width())
-    {
-      m_position.x = 1;
-      m_position.y += int(m_height) + 1;
+    const ivec2 size(image->width(), image->height());
 
-      if (m_position.y + image->height() + 1 > m_texture->height())
-      {
-        if (!addGlyphTextureRow())
-          return nullptr;
-      }
+    glyph.slot = allocateSlot(size);
+    if (glyph.slot == NO_SLOT)
+    {
+      logError("Glyph texture for font %s is full", name().c_str());
+      return nullptr;
     }
 
-    if (!m_texture->copyFrom(0, *image, m_position.x, m_position.y))
+    GlyphSlot& slot = m_slots[glyph.slot];
+    Texture& texture = *m_pages[slot.page].texture;
+
+    if (!texture.copyFrom(0, *image, slot.position.x, slot.position.y))
     {
       logError("Failed to copy glyph image data for font %s",
                 name().c_str());
       return nullptr;
     }
 
-    glyph.offset = vec2(m_position);
-    glyph.size = vec2(image->width(), image->height());
+    slot.codepoint = codepoint;
 
-    m_position.x += image->width() + 1;
+    glyph.offset = vec2(slot.position);
+    glyph.size = vec2(size);
+    glyph.page = slot.page;
   }
 
-  return &glyph;
+  return &(m_glyphs.insert(std::make_pair(codepoint, glyph)).first->second);
 }
 
 const Font::Glyph* Font::findGlyph(uint32 codepoint)
 {
-  auto glyph = std::find(m_glyphs.begin(), m_glyphs.end(), codepoint);
-  if (glyph == m_glyphs.end())
+  auto entry = m_glyphs.find(codepoint);
+  if (entry == m_glyphs.end())
     return addGlyph(codepoint);
 
-  return &(*glyph);
+  entry->second.lastUse = m_context.frameCount();
+  return &(entry->second);
 }
 
-bool Font::addGlyphTextureRow()
+uint Font::allocateSlot(ivec2 size)
 {
-  Ref<Image> glyphs;
-  uint textureWidth = m_context.limits().maxTextureSize;
-  uint textureHeight = 0;
+  // Keep a single texel between glyphs to avoid bleeding
+  const ivec2 padded = size + ivec2(1);
+  const int limit = int(m_pageSize);
+
+  if (padded.x + 1 > limit || padded.y + 1 > limit)
+    return NO_SLOT;
 
-  if (m_texture)
+  // Find the lowest shelf with room for the glyph
+  GlyphPage::Shelf* target = nullptr;
+  uint targetPage = 0;
+
+  for (uint i = 0;  i < m_pages.size();  i++)
   {
-    textureHeight = m_texture->height();
-    glyphs = m_texture->data(0);
+    for (GlyphPage::Shelf& shelf : m_pages[i].shelves)
+    {
+      if (shelf.height < padded.y || shelf.x + padded.x > limit)
+        continue;
+
+      if (!target || shelf.height < target->height)
+      {
+        target = &shelf;
+        targetPage = i;
+      }
+    }
   }
 
-  textureHeight += uint(m_height) + 1;
+  if (!target)
+  {
+    // Open a new shelf on the first page with room for it
+    targetPage = m_pages.size();
+
+    for (uint i = 0;  i < m_pages.size();  i++)
+    {
+      if (m_pages[i].top + padded.y <= limit)
+      {
+        targetPage = i;
+        break;
+      }
+    }
+
+    if (targetPage == m_pages.size())
+    {
+      if (m_pages.size() == MAX_GLYPH_PAGES)
+        return evictSlot(size);
 
-  if (textureHeight > m_context.limits().maxTextureSize)
+      if (!addGlyphPage())
+        return NO_SLOT;
+    }
+
+    GlyphPage& page = m_pages[targetPage];
+
+    const GlyphPage::Shelf shelf = { 1, page.top, padded.y };
+    page.shelves.push_back(shelf);
+    page.top += padded.y;
+
+    target = &page.shelves.back();
+  }
+
+  GlyphSlot slot;
+  slot.position = ivec2(target->x, target->y);
+  slot.size = size;
+  slot.page = targetPage;
+  slot.codepoint = NO_CODEPOINT;
+
+  target->x += padded.x;
+
+  m_slots.push_back(slot);
+  return m_slots.size() - 1;
+}
+
+uint Font::evictSlot(ivec2 size)
+{
+  // This only happens once all pages are full, so a linear search for the
+  // least recently used glyph is acceptable
+  const uint frame = m_context.frameCount();
+  uint oldestSlot = NO_SLOT;
+  uint oldestUse = frame;
+
+  for (uint i = 0;  i < m_slots.size();  i++)
   {
-    logError("Glyph texture for font %s is full", name().c_str());
-    return false;
+    const GlyphSlot& slot = m_slots[i];
+    if (any(lessThan(slot.size, size)))
+      continue;
+
+    auto entry = m_glyphs.find(slot.codepoint);
+    if (entry == m_glyphs.end())
+      return i;
+
+    // Glyphs used during this frame may still be referenced by pending draws
+    if (entry->second.lastUse < oldestUse)
+    {
+      oldestSlot = i;
+      oldestUse = entry->second.lastUse;
+    }
   }
 
-  const TextureData data(PixelFormat::L8, textureWidth, textureHeight);
+  if (oldestSlot != NO_SLOT)
+  {
+    m_glyphs.erase(m_slots[oldestSlot].codepoint);
+    m_slots[oldestSlot].codepoint = NO_CODEPOINT;
+  }
+
+  return oldestSlot;
+}
+
+bool Font::addGlyphPage()
+{
+  const TextureData data(PixelFormat::L8, m_pageSize, m_pageSize);
   const TextureParams params(TEXTURE_RECT, TF_NONE, FILTER_NEAREST, ADDRESS_CLAMP);
 
-  m_texture = Texture::create(cache(), m_context, params, data);
-  if (!m_texture)
+  Ref<Texture> texture = Texture::create(cache(), m_context, params, data);
+  if (!texture)
   {
     logError("Failed to create glyph texture for font %s", name().c_str());
     return false;
   }
 
-  if (glyphs)
-    m_texture->copyFrom(0, *glyphs);
-
-  m_pass.setUniformTexture("glyphs", m_texture);
+  m_pages.push_back(GlyphPage());
+  m_pages.back().texture = texture;
+  m_pages.back().top = 1;
   return true;
 }
 
@@ -32,9 +32,254 @@
 
 #include <glm/gtc/constants.hpp>
 
+#if defined(__AVX__)
+  #include <immintrin.h>
+  #define WENDY_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define WENDY_CULL_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  // ARMv7 NEON flushes denormals to zero, so only AArch64 matches the scalar
+  // results exactly
+  #include <arm_neon.h>
+  #define WENDY_CULL_NEON 1
+#endif
+
 namespace wendy
 {
 
+namespace
+{
+
+#if WENDY_CULL_AVX
+
+const size_t LANES = 8;
+typedef __m256 Lanes;
+
+inline Lanes load(const float* values) { return _mm256_loadu_ps(values); }
+inline Lanes splat(float value) { return _mm256_set1_ps(value); }
+inline Lanes add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+inline Lanes either(Lanes a, Lanes b) { return _mm256_or_ps(a, b); }
+inline Lanes none() { return _mm256_setzero_ps(); }
+inline Lanes absolute(Lanes a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+inline Lanes greater(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline Lanes notLess(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_NLT_UQ); }
+inline uint32 clearBits(Lanes a) { return ~uint32(_mm256_movemask_ps(a)) & 0xff; }
+
+#elif WENDY_CULL_SSE
+
+const size_t LANES = 4;
+typedef __m128 Lanes;
+
+inline Lanes load(const float* values) { return _mm_loadu_ps(values); }
+inline Lanes splat(float value) { return _mm_set1_ps(value); }
+inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes either(Lanes a, Lanes b) { return _mm_or_ps(a, b); }
+inline Lanes none() { return _mm_setzero_ps(); }
+inline Lanes absolute(Lanes a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+inline Lanes greater(Lanes a, Lanes b) { return _mm_cmpgt_ps(a, b); }
+inline Lanes notLess(Lanes a, Lanes b) { return _mm_cmpnlt_ps(a, b); }
+inline uint32 clearBits(Lanes a) { return ~uint32(_mm_movemask_ps(a)) & 0xf; }
+
+#elif WENDY_CULL_NEON
+
+const size_t LANES = 4;
+typedef uint32x4_t Lanes;
+
+inline Lanes load(const float* values) { return vreinterpretq_u32_f32(vld1q_f32(values)); }
+inline Lanes splat(float value) { return vreinterpretq_u32_f32(vdupq_n_f32(value)); }
+inline float32x4_t f(Lanes a) { return vreinterpretq_f32_u32(a); }
+inline Lanes add(Lanes a, Lanes b) { return vreinterpretq_u32_f32(vaddq_f32(f(a), f(b))); }
+inline Lanes sub(Lanes a, Lanes b) { return vreinterpretq_u32_f32(vsubq_f32(f(a), f(b))); }
+inline Lanes mul(Lanes a, Lanes b) { return vreinterpretq_u32_f32(vmulq_f32(f(a), f(b))); }
+inline Lanes either(Lanes a, Lanes b) { return vorrq_u32(a, b); }
+inline Lanes none() { return vdupq_n_u32(0); }
+inline Lanes absolute(Lanes a) { return vreinterpretq_u32_f32(vabsq_f32(f(a))); }
+inline Lanes greater(Lanes a, Lanes b) { return vcgtq_f32(f(a), f(b)); }
+inline Lanes notLess(Lanes a, Lanes b) { return vmvnq_u32(vcltq_f32(f(a), f(b))); }
+
+inline uint32 clearBits(Lanes a)
+{
+  const uint32x4_t weights = { 1, 2, 4, 8 };
+  return ~vaddvq_u32(vandq_u32(a, weights)) & 0xf;
+}
+
+#endif
+
+/*! Sets the bits of the spheres in the range [start,end) that intersect the
+ *  specified planes.  The start of the range must be a multiple of 32.
+ */
+void cullSpheres(const Plane* planes,
+                 const SphereBatch& spheres,
+                 size_t start,
+                 size_t end,
+                 uint32* visible)
+{
+  size_t i = start;
+
+#if WENDY_CULL_AVX || WENDY_CULL_SSE || WENDY_CULL_NEON
+  for (;  i + LANES <= end;  i += LANES)
+  {
+    const Lanes x = load(&spheres.centerX[i]);
+    const Lanes y = load(&spheres.centerY[i]);
+    const Lanes z = load(&spheres.centerZ[i]);
+    const Lanes r = load(&spheres.radius[i]);
+
+    Lanes outside = none();
+
+    for (size_t j = 0;  j < 6;  j++)
+    {
+      const vec3 normal = planes[j].normal;
+
+      // Same order of operations as the scalar path, for identical results
+      const Lanes d = add(add(mul(x, splat(normal.x)), mul(y, splat(normal.y))),
+                          mul(z, splat(normal.z)));
+
+      outside = either(outside, greater(sub(d, r), splat(planes[j].distance)));
+    }
+
+    visible[i / 32] |= clearBits(outside) << (i % 32);
+  }
+#endif
+
+  for (;  i < end;  i++)
+  {
+    const Sphere sphere(vec3(spheres.centerX[i],
+                             spheres.centerY[i],
+                             spheres.centerZ[i]),
+                        spheres.radius[i]);
+
+    bool inside = true;
+
+    for (size_t j = 0;  j < 6;  j++)
+    {
+      if (dot(planes[j].normal, sphere.center) - sphere.radius > planes[j].distance)
+      {
+        inside = false;
+        break;
+      }
+    }
+
+    if (inside)
+      visible[i / 32] |= 1u << (i % 32);
+  }
+}
+
+/*! Sets the bits of the boxes in the range [start,end) that intersect the
+ *  specified planes.  The start of the range must be a multiple of 32.
+ */
+void cullBoxes(const Plane* planes,
+               const AABBBatch& boxes,
+               size_t start,
+               size_t end,
+               uint32* visible)
+{
+  size_t i = start;
+
+#if WENDY_CULL_AVX || WENDY_CULL_SSE || WENDY_CULL_NEON
+  for (;  i + LANES <= end;  i += LANES)
+  {
+    const Lanes cx = load(&boxes.centerX[i]);
+    const Lanes cy = load(&boxes.centerY[i]);
+    const Lanes cz = load(&boxes.centerZ[i]);
+    const Lanes hx = absolute(mul(load(&boxes.sizeX[i]), splat(0.5f)));
+    const Lanes hy = absolute(mul(load(&boxes.sizeY[i]), splat(0.5f)));
+    const Lanes hz = absolute(mul(load(&boxes.sizeZ[i]), splat(0.5f)));
+
+    const Lanes minimum[3] = { sub(cx, hx), sub(cy, hy), sub(cz, hz) };
+    const Lanes maximum[3] = { add(cx, hx), add(cy, hy), add(cz, hz) };
+
+    Lanes outside = none();
+
+    for (size_t j = 0;  j < 6;  j++)
+    {
+      const vec3 normal = planes[j].normal;
+
+      const Lanes x = normal.x < 0.f ? maximum[0] : minimum[0];
+      const Lanes y = normal.y < 0.f ? maximum[1] : minimum[1];
+      const Lanes z = normal.z < 0.f ? maximum[2] : minimum[2];
+
+      // Same order of operations as the scalar path, for identical results
+      const Lanes d = add(add(mul(x, splat(normal.x)), mul(y, splat(normal.y))),
+                          mul(z, splat(normal.z)));
+
+      outside = either(outside, notLess(d, splat(planes[j].distance)));
+    }
+
+    visible[i / 32] |= clearBits(outside) << (i % 32);
+  }
+#endif
+
+  for (;  i < end;  i++)
+  {
+    const AABB box(vec3(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]),
+                   vec3(boxes.sizeX[i], boxes.sizeY[i], boxes.sizeZ[i]));
+
+    vec3 minimum, maximum;
+    box.bounds(minimum, maximum);
+
+    bool inside = true;
+
+    for (size_t j = 0;  j < 6;  j++)
+    {
+      const vec3 negative(planes[j].normal.x < 0.f ? maximum.x : minimum.x,
+                          planes[j].normal.y < 0.f ? maximum.y : minimum.y,
+                          planes[j].normal.z < 0.f ? maximum.z : minimum.z);
+
+      if (!planes[j].contains(negative))
+      {
+        inside = false;
+        break;
+      }
+    }
+
+    if (inside)
+      visible[i / 32] |= 1u << (i % 32);
+  }
+}
+
+} /*namespace*/
+
+void SphereBatch::clear()
+{
+  centerX.clear();
+  centerY.clear();
+  centerZ.clear();
+  radius.clear();
+}
+
+void SphereBatch::add(const Sphere& sphere)
+{
+  centerX.push_back(sphere.center.x);
+  centerY.push_back(sphere.center.y);
+  centerZ.push_back(sphere.center.z);
+  radius.push_back(sphere.radius);
+}
+
+void AABBBatch::clear()
+{
+  centerX.clear();
+  centerY.clear();
+  centerZ.clear();
+  sizeX.clear();
+  sizeY.clear();
+  sizeZ.clear();
+}
+
+void AABBBatch::add(const AABB& box)
+{
+  centerX.push_back(box.center.x);
+  centerY.push_back(box.center.y);
+  centerZ.push_back(box.center.z);
+  sizeX.push_back(box.size.x);
+  sizeY.push_back(box.size.y);
+  sizeZ.push_back(box.size.z);
+}
+
 Frustum::Frustum(float FOV, float aspectRatio, float nearZ, float farZ)
 {
   setPerspective(FOV, aspectRatio, nearZ, farZ);
@@ -109,6 +354,42 @@ bool Frustum::intersects(const AABB& box) const
   return true;
 }
 
+void Frustum::intersects(const SphereBatch& spheres, std::vector<uint32>& visible) const
+{
+  visible.assign((spheres.size() + 31) / 32, 0);
+  cullSpheres(planes, spheres, 0, spheres.size(), visible.data());
+}
+
+void Frustum::intersects(const AABBBatch& boxes, std::vector<uint32>& visible) const
+{
+  visible.assign((boxes.size() + 31) / 32, 0);
+  cullBoxes(planes, boxes, 0, boxes.size(), visible.data());
+}
+
+void Frustum::intersects(const SphereBatch& spheres,
+                         const AABBBatch& boxes,
+                         std::vector<uint32>& visible) const
+{
+  assert(spheres.size() == boxes.size());
+
+  intersects(spheres, visible);
+
+  for (size_t i = 0;  i < visible.size();  i++)
+  {
+    const uint32 passed = visible[i];
+    if (!passed)
+      continue;
+
+    // Only refine groups of 32 where some spheres passed
+    const size_t start = i * 32;
+    const size_t end = std::min(start + 32, boxes.size());
+
+    visible[i] = 0;
+    cullBoxes(planes, boxes, start, end, visible.data());
+    visible[i] &= passed;
+  }
+}
+
 void Frustum::transformBy(const Transform3& transform)
 {
   for (size_t i = 0;  i < 6;  i++)
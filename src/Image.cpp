@@ -66,10 +66,129 @@ PixelFormat convertToPixelFormat(int format)
   }
 }
 
+const uint8 KTX_IDENTIFIER[] =
+{
+  0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n'
+};
+
+const uint32 KTX_ENDIANNESS = 0x04030201;
+
+// No GL implementation supports textures larger than this, so larger
+// dimensions in a KTX header mean the file is corrupt
+const uint32 KTX_MAX_SIZE = 16384;
+
+// OpenGL enumerants used in KTX headers
+enum
+{
+  KTX_UNSIGNED_BYTE = 0x1401
+};
+
+struct KTXHeader
+{
+  uint8 identifier[12];
+  uint32 endianness;
+  uint32 glType;
+  uint32 glTypeSize;
+  uint32 glFormat;
+  uint32 glInternalFormat;
+  uint32 glBaseInternalFormat;
+  uint32 pixelWidth;
+  uint32 pixelHeight;
+  uint32 pixelDepth;
+  uint32 numberOfArrayElements;
+  uint32 numberOfFaces;
+  uint32 numberOfMipmapLevels;
+  uint32 bytesOfKeyValueData;
+};
+
+struct KTXFormat
+{
+  PixelFormat::Semantic semantic;
+  PixelFormat::Type type;
+  uint32 format;
+  uint32 internalFormat;
+  uint32 baseInternalFormat;
+  bool sRGB;
+};
+
+// The first entry for each pixel format and color space is the one written
+// to KTX files
+const KTXFormat KTX_FORMATS[] =
+{
+  { PixelFormat::L, PixelFormat::UINT8, 0x1903, 0x8229, 0x1903, false },
+  { PixelFormat::L, PixelFormat::UINT8, 0x1909, 0x8040, 0x1909, false },
+  { PixelFormat::LA, PixelFormat::UINT8, 0x8227, 0x822b, 0x8227, false },
+  { PixelFormat::LA, PixelFormat::UINT8, 0x190a, 0x8045, 0x190a, false },
+  { PixelFormat::RGB, PixelFormat::UINT8, 0x1907, 0x8051, 0x1907, false },
+  { PixelFormat::RGB, PixelFormat::UINT8, 0x1907, 0x8c41, 0x1907, true },
+  { PixelFormat::RGBA, PixelFormat::UINT8, 0x1908, 0x8058, 0x1908, false },
+  { PixelFormat::RGBA, PixelFormat::UINT8, 0x1908, 0x8c43, 0x1908, true },
+  { PixelFormat::RGB, PixelFormat::BC1, 0, 0x83f0, 0x1907, false },
+  { PixelFormat::RGB, PixelFormat::BC1, 0, 0x8c4c, 0x1907, true },
+  { PixelFormat::RGBA, PixelFormat::BC3, 0, 0x83f3, 0x1908, false },
+  { PixelFormat::RGBA, PixelFormat::BC3, 0, 0x8c4f, 0x1908, true },
+  { PixelFormat::L, PixelFormat::BC4, 0, 0x8dbb, 0x1903, false },
+  { PixelFormat::LA, PixelFormat::BC5, 0, 0x8dbd, 0x8227, false },
+  { PixelFormat::RGBA, PixelFormat::BC7, 0, 0x8e8c, 0x1908, false },
+  { PixelFormat::RGBA, PixelFormat::BC7, 0, 0x8e8d, 0x1908, true },
+  { PixelFormat::RGB, PixelFormat::ETC2, 0, 0x9274, 0x1907, false },
+  { PixelFormat::RGB, PixelFormat::ETC2, 0, 0x9275, 0x1907, true },
+  { PixelFormat::RGBA, PixelFormat::ETC2, 0, 0x9278, 0x1908, false },
+  { PixelFormat::RGBA, PixelFormat::ETC2, 0, 0x9279, 0x1908, true }
+};
+
+const KTXFormat* findKTXFormat(uint32 internalFormat)
+{
+  for (const KTXFormat& f : KTX_FORMATS)
+  {
+    if (f.internalFormat == internalFormat)
+      return &f;
+  }
+
+  return nullptr;
+}
+
+const KTXFormat* findKTXFormat(const PixelFormat& format, bool sRGB)
+{
+  for (const KTXFormat& f : KTX_FORMATS)
+  {
+    if (f.semantic == format.semantic() && f.type == format.type() &&
+        f.sRGB == sRGB)
+    {
+      return &f;
+    }
+  }
+
+  return nullptr;
+}
+
+bool isKTX(const Path& path)
+{
+  std::ifstream stream(path.name().c_str(), std::ios::in | std::ios::binary);
+
+  uint8 identifier[sizeof(KTX_IDENTIFIER)];
+  if (!stream.read((char*) identifier, sizeof(identifier)))
+    return false;
+
+  return std::memcmp(identifier, KTX_IDENTIFIER, sizeof(identifier)) == 0;
+}
+
+// Rows of uncompressed KTX images are aligned to four bytes
+size_t ktxRowSize(const PixelFormat& format, uint width)
+{
+  return (format.size(width) + 3) & ~size_t(3);
+}
+
 } /*namespace*/
 
 bool Image::crop(const Recti& area)
 {
+  if (m_format.isCompressed() || m_levels > 1)
+  {
+    logError("Cannot crop compressed or mipmapped image");
+    return false;
+  }
+
   if (dimensionCount() > 2)
   {
     logError("Cannot 2D crop 3D image");
@@ -101,6 +220,12 @@ bool Image::crop(const Recti& area)
 
 void Image::flipHorizontal()
 {
+  if (m_format.isCompressed() || m_levels > 1)
+  {
+    logError("Cannot flip compressed or mipmapped image");
+    return;
+  }
+
   const size_t rowSize = m_width * m_format.size();
   std::vector<char> temp(m_data.size());
 
@@ -121,6 +246,12 @@ void Image::flipHorizontal()
 
 void Image::flipVertical()
 {
+  if (m_format.isCompressed() || m_levels > 1)
+  {
+    logError("Cannot flip compressed or mipmapped image");
+    return;
+  }
+
   const size_t pixelSize = m_format.size();
   std::vector<char> temp(m_data.size());
 
@@ -131,7 +262,7 @@ void Image::flipVertical()
       const char* source = m_data.data() + (z * m_height + y) * m_width * pixelSize;
       char* target = temp.data() + ((z * m_height + y + 1) * m_width - 1) * pixelSize;
 
-      while (source < target)
+      for (uint x = 0;  x < m_width;  x++)
       {
         std::memcpy(target, source, pixelSize);
         source += pixelSize;
@@ -145,6 +276,15 @@ void Image::flipVertical()
 
 bool Image::write(const Path& path) const
 {
+  if (path.suffix() == "ktx")
+    return writeKTX(path);
+
+  if (m_format.isCompressed() || m_levels > 1)
+  {
+    logError("Compressed and mipmapped images can only be written to KTX files");
+    return false;
+  }
+
   if (dimensionCount() > 2)
   {
     logError("Cannot write 3D images to PNG file");
@@ -173,7 +313,7 @@ bool Image::isPOT() const
 
 void* Image::pixel(uint x, uint y, uint z)
 {
-  if (x >= m_width || y >= m_height || z >= m_depth)
+  if (x >= m_width || y >= m_height || z >= m_depth || m_format.isCompressed())
     return nullptr;
 
   return m_data.data() + ((z * m_height + y) * m_width + x) * m_format.size();
@@ -181,7 +321,7 @@ void* Image::pixel(uint x, uint y, uint z)
 
 const void* Image::pixel(uint x, uint y, uint z) const
 {
-  if (x >= m_width || y >= m_height || z >= m_depth)
+  if (x >= m_width || y >= m_height || z >= m_depth || m_format.isCompressed())
     return nullptr;
 
   return m_data.data() + ((z * m_height + y) * m_width + x) * m_format.size();
@@ -204,10 +344,11 @@ Ref<Image> Image::create(const ResourceInfo& info,
                          uint height,
                          uint depth,
                          const void* pixels,
-                         ptrdiff_t pitch)
+                         ptrdiff_t pitch,
+                         uint levels)
 {
   Ref<Image> image(new Image(info));
-  if (!image->init(format, width, height, depth, (const char*) pixels, pitch))
+  if (!image->init(format, width, height, depth, (const char*) pixels, pitch, levels))
     return nullptr;
 
   return image;
@@ -215,7 +356,11 @@ Ref<Image> Image::create(const ResourceInfo& info,
 
 Ref<Image> Image::read(ResourceCache& cache, const std::string& name)
 {
-  if (Image* cached = cache.find<Image>(name))
+  // This may run on loader threads, so keep others from creating the same
+  // resource until this one is done
+  ResourceCache::NameLock lock(cache, name);
+
+  if (Ref<Image> cached = cache.find<Image>(name))
     return cached;
 
   const Path path = cache.findFile(name);
@@ -225,6 +370,9 @@ Ref<Image> Image::read(ResourceCache& cache, const std::string& name)
     return nullptr;
   }
 
+  if (isKTX(path))
+    return readKTX(cache, name, path);
+
   int width, height, format;
   stbi_uc* pixels = stbi_load(path.name().c_str(),
                               &width, &height,
@@ -251,7 +399,9 @@ Ref<Image> Image::read(ResourceCache& cache, const std::string& name)
 }
 
 Image::Image(const ResourceInfo& info):
-  Resource(info)
+  Resource(info, this),
+  m_levels(1),
+  m_sRGB(false)
 {
 }
 
@@ -260,17 +410,21 @@ bool Image::init(const PixelFormat& format,
                  uint height,
                  uint depth,
                  const char* pixels,
-                 ptrdiff_t pitch)
+                 ptrdiff_t pitch,
+                 uint levels)
 {
   m_format = format;
   m_width = width;
   m_height = height;
   m_depth = depth;
+  m_levels = levels;
 
   assert(m_format.isValid());
   assert(m_width);
   assert(m_height);
   assert(m_depth);
+  assert(m_levels);
+  assert(!pitch || (m_levels == 1 && !m_format.isCompressed()));
 
   if (pixels)
   {
@@ -293,13 +447,238 @@ bool Image::init(const PixelFormat& format,
       }
     }
     else
-      m_data.assign(pixels, pixels + m_width * m_height * m_depth * m_format.size());
+      m_data.assign(pixels, pixels + offset(m_levels));
   }
   else
-    m_data.resize(m_width * m_height * m_depth * m_format.size(), 0);
+    m_data.resize(offset(m_levels), 0);
 
   return true;
 }
 
+bool Image::writeKTX(const Path& path) const
+{
+  if (dimensionCount() > 2)
+  {
+    logError("Cannot write 3D images to KTX file");
+    return false;
+  }
+
+  const KTXFormat* format = findKTXFormat(m_format, m_sRGB);
+  if (!format)
+  {
+    logError("Cannot write %simages of pixel format %s to KTX file",
+             m_sRGB ? "sRGB " : "",
+             stringCast(m_format).c_str());
+    return false;
+  }
+
+  // Rows are stored bottom to top, as in all Wendy images
+  const char orientation[] = "KTXorientation\0S=r,T=u";
+  const uint32 orientationSize = sizeof(orientation);
+  const uint8 padding[4] = { 0, 0, 0, 0 };
+
+  KTXHeader header;
+  std::memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+  header.endianness = KTX_ENDIANNESS;
+  header.glType = m_format.isCompressed() ? 0 : KTX_UNSIGNED_BYTE;
+  header.glTypeSize = 1;
+  header.glFormat = format->format;
+  header.glInternalFormat = format->internalFormat;
+  header.glBaseInternalFormat = format->baseInternalFormat;
+  header.pixelWidth = m_width;
+  header.pixelHeight = m_height;
+  header.pixelDepth = 0;
+  header.numberOfArrayElements = 0;
+  header.numberOfFaces = 1;
+  header.numberOfMipmapLevels = m_levels;
+  header.bytesOfKeyValueData = sizeof(uint32) + ((orientationSize + 3) & ~3u);
+
+  std::ofstream stream(path.name().c_str(), std::ios::out | std::ios::binary);
+  if (!stream)
+  {
+    logError("Failed to create KTX file %s", path.name().c_str());
+    return false;
+  }
+
+  stream.write((const char*) &header, sizeof(header));
+  stream.write((const char*) &orientationSize, sizeof(orientationSize));
+  stream.write(orientation, orientationSize);
+  stream.write((const char*) padding, (4 - orientationSize % 4) % 4);
+
+  for (uint level = 0;  level < m_levels;  level++)
+  {
+    const uint width = max(m_width >> level, 1u);
+    const uint height = max(m_height >> level, 1u);
+    const char* source = (const char*) pixels(level);
+
+    if (m_format.isCompressed())
+    {
+      const uint32 imageSize = uint32(m_format.size(width, height));
+      stream.write((const char*) &imageSize, sizeof(imageSize));
+      stream.write(source, imageSize);
+    }
+    else
+    {
+      const size_t rowSize = m_format.size(width);
+      const size_t paddedSize = ktxRowSize(m_format, width);
+
+      const uint32 imageSize = uint32(paddedSize * height);
+      stream.write((const char*) &imageSize, sizeof(imageSize));
+
+      for (uint y = 0;  y < height;  y++)
+      {
+        stream.write(source + y * rowSize, rowSize);
+        stream.write((const char*) padding, paddedSize - rowSize);
+      }
+    }
+  }
+
+  if (!stream)
+  {
+    logError("Failed to write KTX file %s", path.name().c_str());
+    return false;
+  }
+
+  return true;
+}
+
+Ref<Image> Image::readKTX(ResourceCache& cache,
+                          const std::string& name,
+                          const Path& path)
+{
+  std::ifstream stream(path.name().c_str(), std::ios::in | std::ios::binary);
+
+  KTXHeader header;
+  if (!stream.read((char*) &header, sizeof(header)))
+  {
+    logError("Failed to read header of KTX image %s", path.name().c_str());
+    return nullptr;
+  }
+
+  if (header.endianness != KTX_ENDIANNESS)
+  {
+    logError("KTX image %s has unsupported endianness", path.name().c_str());
+    return nullptr;
+  }
+
+  if (header.pixelDepth > 1 ||
+      header.numberOfArrayElements > 0 ||
+      header.numberOfFaces != 1)
+  {
+    logError("KTX image %s is not a single two-dimensional image",
+             path.name().c_str());
+    return nullptr;
+  }
+
+  const KTXFormat* format = findKTXFormat(header.glInternalFormat);
+  if (!format || (format->format && header.glType != KTX_UNSIGNED_BYTE))
+  {
+    logError("KTX image %s has unsupported format 0x%04x",
+             path.name().c_str(),
+             header.glInternalFormat);
+    return nullptr;
+  }
+
+  // Rows are assumed to be stored bottom to top, as in all Wendy images
+  stream.seekg(header.bytesOfKeyValueData, std::ios::cur);
+
+  const PixelFormat pixelFormat(format->semantic, format->type);
+  const uint width = header.pixelWidth;
+  const uint height = max(header.pixelHeight, 1u);
+  const uint levels = max(header.numberOfMipmapLevels, 1u);
+
+  if (width == 0 || width > KTX_MAX_SIZE || height > KTX_MAX_SIZE)
+  {
+    logError("KTX image %s has invalid size %ux%u",
+             path.name().c_str(),
+             header.pixelWidth,
+             header.pixelHeight);
+    return nullptr;
+  }
+
+  uint maxLevels = 1;
+  while ((max(width, height) >> maxLevels) > 0)
+    maxLevels++;
+
+  if (levels > maxLevels)
+  {
+    logError("KTX image %s has %u mipmap levels but at most %u fit its size",
+             path.name().c_str(),
+             levels,
+             maxLevels);
+    return nullptr;
+  }
+
+  Ref<Image> image(new Image(ResourceInfo(cache, name, path)));
+  if (!image->init(pixelFormat, width, height, 1, nullptr, 0, levels))
+    return nullptr;
+
+  image->m_sRGB = format->sRGB;
+
+  for (uint level = 0;  level < levels;  level++)
+  {
+    const uint levelWidth = max(width >> level, 1u);
+    const uint levelHeight = max(height >> level, 1u);
+    char* target = (char*) image->pixels(level);
+
+    uint32 imageSize = 0;
+    stream.read((char*) &imageSize, sizeof(imageSize));
+
+    if (pixelFormat.isCompressed())
+    {
+      if (imageSize != pixelFormat.size(levelWidth, levelHeight))
+      {
+        logError("KTX image %s has invalid size for level %u",
+                 path.name().c_str(),
+                 level);
+        return nullptr;
+      }
+
+      stream.read(target, imageSize);
+    }
+    else
+    {
+      const size_t rowSize = pixelFormat.size(levelWidth);
+      const size_t paddedSize = ktxRowSize(pixelFormat, levelWidth);
+
+      if (imageSize != paddedSize * levelHeight)
+      {
+        logError("KTX image %s has invalid size for level %u",
+                 path.name().c_str(),
+                 level);
+        return nullptr;
+      }
+
+      for (uint y = 0;  y < levelHeight;  y++)
+      {
+        stream.read(target + y * rowSize, rowSize);
+        stream.seekg(paddedSize - rowSize, std::ios::cur);
+      }
+    }
+  }
+
+  if (!stream)
+  {
+    logError("Failed to read pixel data of KTX image %s", path.name().c_str());
+    return nullptr;
+  }
+
+  return image;
+}
+
+size_t Image::offset(uint level) const
+{
+  size_t offset = 0;
+
+  for (uint i = 0;  i < level;  i++)
+  {
+    offset += m_format.size(max(m_width >> i, 1u),
+                            max(m_height >> i, 1u),
+                            max(m_depth >> i, 1u));
+  }
+
+  return offset;
+}
+
 } /*namespace wendy*/
 
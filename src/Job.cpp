@@ -0,0 +1,408 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Time.hpp>
+#include <wendy/Profile.hpp>
+#include <wendy/Job.hpp>
+
+#include <algorithm>
+
+namespace wendy
+{
+
+namespace
+{
+
+thread_local const JobSystem* currentSystem = nullptr;
+thread_local uint currentIndex = 0;
+
+} /*namespace*/
+
+struct JobSystem::Job
+{
+  JobFunction function;
+  JobCounter* counter;
+  const char* name;
+};
+
+/* The profile of a worker is only written by its thread while busy, and
+ * otherwise only under the profile mutex.
+ */
+struct JobSystem::Worker
+{
+  Worker(): busy(false) { }
+  std::deque<Job*> jobs;
+  std::mutex mutex;
+  Profile profile;
+  std::mutex profileMutex;
+  std::condition_variable idleCondition;
+  bool busy;
+};
+
+JobCounter::JobCounter():
+  m_count(0)
+{
+}
+
+bool JobCounter::isDone() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_count == 0;
+}
+
+uint JobCounter::count() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_count;
+}
+
+JobSystem::~JobSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_stopping = true;
+  }
+
+  m_sleepCondition.notify_all();
+
+  for (std::thread& t : m_threads)
+    t.join();
+
+  for (Job* job : m_injected)
+    delete job;
+
+  for (Job* job : m_deferred)
+    delete job;
+
+  for (auto& w : m_workers)
+  {
+    for (Job* job : w->jobs)
+      delete job;
+  }
+}
+
+void JobSystem::submit(const JobFunction& function,
+                       JobCounter* counter,
+                       const char* name)
+{
+  if (counter)
+  {
+    std::lock_guard<std::mutex> lock(counter->m_mutex);
+    counter->m_count++;
+  }
+
+  schedule(new Job{function, counter, name});
+}
+
+void JobSystem::submitAfter(JobCounter& dependency,
+                            const JobFunction& function,
+                            JobCounter* counter,
+                            const char* name)
+{
+  if (counter)
+  {
+    std::lock_guard<std::mutex> lock(counter->m_mutex);
+    counter->m_count++;
+  }
+
+  Job* job = new Job{function, counter, name};
+
+  {
+    std::lock_guard<std::mutex> lock(dependency.m_mutex);
+    if (dependency.m_count)
+    {
+      // Deferred jobs are tracked so that the destructor can free them
+      {
+        std::lock_guard<std::mutex> deferredLock(m_deferredMutex);
+        m_deferred.insert(job);
+      }
+
+      dependency.m_waiting.push_back([this, job]()
+      {
+        {
+          std::lock_guard<std::mutex> lock(m_deferredMutex);
+          m_deferred.erase(job);
+        }
+
+        schedule(job);
+      });
+
+      return;
+    }
+  }
+
+  schedule(job);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+  ProfileNodeCall call("JobSystem::wait");
+
+  const uint index = currentWorker();
+
+  while (!counter.isDone())
+  {
+    if (Job* job = findJob(index))
+      execute(job);
+    else
+      std::this_thread::yield();
+  }
+}
+
+void JobSystem::parallelFor(uint begin,
+                            uint end,
+                            uint grainSize,
+                            const std::function<void (uint, uint)>& function,
+                            const char* name)
+{
+  if (begin >= end)
+    return;
+
+  grainSize = std::max(grainSize, 1u);
+
+  JobCounter counter;
+
+  // The calling thread takes the first chunk itself
+  uint first = std::min(end, begin + grainSize);
+
+  for (uint start = first;  start < end;  start += grainSize)
+  {
+    const uint stop = std::min(end, start + grainSize);
+    submit([&function, start, stop]() { function(start, stop); }, &counter, name);
+  }
+
+  {
+    ProfileNodeCall call(name);
+    function(begin, first);
+  }
+
+  wait(counter);
+}
+
+void JobSystem::collectProfiles(const std::function<void (uint, const Profile&)>& function)
+{
+  for (uint i = 0;  i < m_workers.size();  i++)
+  {
+    Worker& worker = *m_workers[i];
+
+    std::lock_guard<std::mutex> lock(worker.profileMutex);
+    if (worker.busy)
+      continue;
+
+    worker.profile.endFrame();
+    function(i, worker.profile);
+    worker.profile.beginFrame();
+  }
+}
+
+void JobSystem::setProfileHistory(uint frameCount, uint eventCapacity)
+{
+  for (auto& w : m_workers)
+  {
+    std::unique_lock<std::mutex> lock(w->profileMutex);
+    w->idleCondition.wait(lock, [&w]() { return !w->busy; });
+    w->profile.setHistory(frameCount, eventCapacity);
+  }
+}
+
+uint JobSystem::currentWorker() const
+{
+  if (currentSystem == this)
+    return currentIndex;
+
+  return workerCount();
+}
+
+std::unique_ptr<JobSystem> JobSystem::create(uint workerCount)
+{
+  std::unique_ptr<JobSystem> system(new JobSystem());
+  if (!system->init(workerCount))
+    return nullptr;
+
+  return system;
+}
+
+JobSystem::JobSystem():
+  m_queued(0),
+  m_stopping(false)
+{
+}
+
+bool JobSystem::init(uint workerCount)
+{
+  if (!workerCount)
+    workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+  for (uint i = 0;  i < workerCount;  i++)
+  {
+    m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    m_workers.back()->profile.setName(format("Worker %u", i));
+  }
+
+  for (uint i = 0;  i < workerCount;  i++)
+    m_threads.push_back(std::thread(&JobSystem::runWorker, this, i));
+
+  return true;
+}
+
+void JobSystem::schedule(Job* job)
+{
+  const uint index = currentWorker();
+  if (index < m_workers.size())
+  {
+    Worker& worker = *m_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.jobs.push_back(job);
+  }
+  else
+  {
+    std::lock_guard<std::mutex> lock(m_injectedMutex);
+    m_injected.push_back(job);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_queued++;
+  }
+
+  m_sleepCondition.notify_one();
+}
+
+JobSystem::Job* JobSystem::findJob(uint index)
+{
+  Job* job = nullptr;
+
+  if (index < m_workers.size())
+  {
+    Worker& worker = *m_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.jobs.empty())
+    {
+      job = worker.jobs.back();
+      worker.jobs.pop_back();
+    }
+  }
+
+  if (!job)
+  {
+    std::lock_guard<std::mutex> lock(m_injectedMutex);
+    if (!m_injected.empty())
+    {
+      job = m_injected.front();
+      m_injected.pop_front();
+    }
+  }
+
+  for (uint i = 1;  !job && i <= m_workers.size();  i++)
+  {
+    Worker& victim = *m_workers[(index + i) % m_workers.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty())
+    {
+      job = victim.jobs.front();
+      victim.jobs.pop_front();
+    }
+  }
+
+  if (job)
+    m_queued--;
+
+  return job;
+}
+
+void JobSystem::execute(Job* job)
+{
+  {
+    ProfileNodeCall call(job->name);
+    job->function();
+  }
+
+  if (job->counter)
+    finish(*job->counter);
+
+  delete job;
+}
+
+void JobSystem::finish(JobCounter& counter)
+{
+  std::vector<JobFunction> waiting;
+
+  {
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+    if (--counter.m_count == 0)
+      waiting.swap(counter.m_waiting);
+  }
+
+  for (const JobFunction& function : waiting)
+    function();
+}
+
+void JobSystem::runWorker(uint index)
+{
+  Worker& worker = *m_workers[index];
+
+  currentSystem = this;
+  currentIndex = index;
+
+  Profile::setCurrent(&worker.profile);
+
+  {
+    std::lock_guard<std::mutex> lock(worker.profileMutex);
+    worker.profile.beginFrame();
+  }
+
+  for (;;)
+  {
+    if (Job* job = findJob(index))
+    {
+      {
+        std::lock_guard<std::mutex> lock(worker.profileMutex);
+        worker.busy = true;
+      }
+
+      execute(job);
+
+      {
+        std::lock_guard<std::mutex> lock(worker.profileMutex);
+        worker.busy = false;
+      }
+
+      worker.idleCondition.notify_all();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_sleepCondition.wait(lock, [this]() { return m_stopping || m_queued > 0; });
+    if (m_stopping)
+      break;
+  }
+
+  Profile::setCurrent(nullptr);
+}
+
+} /*namespace wendy*/
@@ -445,7 +445,7 @@ Ref<Material> Material::read(RenderContext& context, const std::string& name)
 {
   initializeMaps();
 
-  if (Material* cached = context.cache().find<Material>(name))
+  if (Ref<Material> cached = context.cache().find<Material>(name))
     return cached;
 
   const Path path = context.cache().findFile(name);
@@ -497,7 +497,7 @@ Ref<Material> Material::read(RenderContext& context, const std::string& name)
 }
 
 Material::Material(const ResourceInfo& info):
-  Resource(info)
+  Resource(info, this)
 {
 }
 
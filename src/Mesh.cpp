@@ -269,7 +269,7 @@ void MeshTriangle::setIndices(uint32 a, uint32 b, uint32 c)
 }
 
 Mesh::Mesh(const ResourceInfo& info):
-  Resource(info)
+  Resource(info, this)
 {
 }
 
@@ -460,7 +460,11 @@ size_t Mesh::triangleCount() const
 
 Ref<Mesh> Mesh::read(ResourceCache& cache, const std::string& name)
 {
-  if (Mesh* cached = cache.find<Mesh>(name))
+  // This may run on loader threads, so keep others from creating the same
+  // resource until this one is done
+  ResourceCache::NameLock lock(cache, name);
+
+  if (Ref<Mesh> cached = cache.find<Mesh>(name))
     return cached;
 
   const Path path = cache.findFile(name);
@@ -51,6 +51,104 @@ namespace
 
 const uint MODEL_XML_VERSION = 3;
 
+/*! Everything in a model specification that can be read without a context.
+ */
+struct ModelData
+{
+  Path path;
+  Ref<Mesh> mesh;
+  std::vector<std::pair<std::string, std::string>> materials;
+};
+
+bool readModelData(ResourceCache& cache, const std::string& name, ModelData& data)
+{
+  data.path = cache.findFile(name);
+  if (data.path.isEmpty())
+  {
+    logError("Failed to find model %s", name.c_str());
+    return false;
+  }
+
+  pugi::xml_document document;
+
+  const pugi::xml_parse_result result = document.load_file(data.path.name().c_str());
+  if (!result)
+  {
+    logError("Failed to load model %s: %s",
+             name.c_str(),
+             result.description());
+    return false;
+  }
+
+  pugi::xml_node root = document.child("model");
+  if (!root || root.attribute("version").as_uint() != MODEL_XML_VERSION)
+  {
+    logError("Model file format mismatch in %s", name.c_str());
+    return false;
+  }
+
+  const std::string meshName(root.attribute("mesh").value());
+  if (meshName.empty())
+  {
+    logError("No mesh for model %s", name.c_str());
+    return false;
+  }
+
+  data.mesh = Mesh::read(cache, meshName);
+  if (!data.mesh)
+  {
+    logError("Failed to load mesh for model %s", name.c_str());
+    return false;
+  }
+
+  for (auto m : root.children("material"))
+  {
+    const std::string materialAlias(m.attribute("alias").value());
+    if (materialAlias.empty())
+    {
+      logError("Empty material alias found in model %s", name.c_str());
+      return false;
+    }
+
+    const std::string materialName(m.attribute("name").value());
+    if (materialName.empty())
+    {
+      logError("Empty material name for alias %s in model %s",
+               materialAlias.c_str(),
+               name.c_str());
+      return false;
+    }
+
+    data.materials.push_back(std::make_pair(materialAlias, materialName));
+  }
+
+  return true;
+}
+
+Ref<Model> createModel(RenderContext& context,
+                       const std::string& name,
+                       const ModelData& data)
+{
+  Model::MaterialMap materials;
+
+  for (const auto& m : data.materials)
+  {
+    Ref<Material> material = Material::read(context, m.second);
+    if (!material)
+    {
+      logError("Failed to load material for alias %s of model %s",
+               m.first.c_str(),
+               m.second.c_str());
+      return nullptr;
+    }
+
+    materials[m.first] = material;
+  }
+
+  return Model::create(ResourceInfo(context.cache(), name, data.path),
+                       context, *data.mesh, materials);
+}
+
 } /*namespace*/
 
 ModelSection::ModelSection(const IndexRange& range,
@@ -215,82 +313,31 @@ bool Model::init(RenderContext& context, const Mesh& data, const MaterialMap& ma
 
 Ref<Model> Model::read(RenderContext& context, const std::string& name)
 {
-  if (Model* cached = context.cache().find<Model>(name))
+  if (Ref<Model> cached = context.cache().find<Model>(name))
     return cached;
 
-  const Path path = context.cache().findFile(name);
-  if (path.isEmpty())
-  {
-    logError("Failed to find model %s", name.c_str());
+  ModelData data;
+  if (!readModelData(context.cache(), name, data))
     return nullptr;
-  }
-
-  pugi::xml_document document;
 
-  const pugi::xml_parse_result result = document.load_file(path.name().c_str());
-  if (!result)
-  {
-    logError("Failed to load model %s: %s",
-             name.c_str(),
-             result.description());
-    return nullptr;
-  }
-
-  pugi::xml_node root = document.child("model");
-  if (!root || root.attribute("version").as_uint() != MODEL_XML_VERSION)
-  {
-    logError("Model file format mismatch in %s", name.c_str());
-    return nullptr;
-  }
+  return createModel(context, name, data);
+}
 
-  const std::string meshName(root.attribute("mesh").value());
-  if (meshName.empty())
-  {
-    logError("No mesh for model %s", name.c_str());
-    return nullptr;
-  }
+AsyncResource<Model> Model::readAsync(RenderContext& context, const std::string& name)
+{
+  ResourceCache& cache = context.cache();
 
-  Ref<Mesh> mesh = Mesh::read(context.cache(), meshName);
-  if (!mesh)
+  std::function<bool (ModelData&)> decode = [&cache, name](ModelData& data)
   {
-    logError("Failed to load mesh for model %s", name.c_str());
-    return nullptr;
-  }
-
-  Model::MaterialMap materials;
+    return readModelData(cache, name, data);
+  };
 
-  for (auto m : root.children("material"))
+  std::function<Ref<Model> (ModelData&)> finish = [&context, name](ModelData& data)
   {
-    const std::string materialAlias(m.attribute("alias").value());
-    if (materialAlias.empty())
-    {
-      logError("Empty material alias found in model %s", name.c_str());
-      return nullptr;
-    }
-
-    const std::string materialName(m.attribute("name").value());
-    if (materialName.empty())
-    {
-      logError("Empty material name for alias %s in model %s",
-               materialAlias.c_str(),
-               name.c_str());
-      return nullptr;
-    }
-
-    Ref<Material> material = Material::read(context, materialName);
-    if (!material)
-    {
-      logError("Failed to load material for alias %s of model %s",
-               materialAlias.c_str(),
-               materialName.c_str());
-      return nullptr;
-    }
-
-    materials[materialAlias] = material;
-  }
+    return createModel(context, name, data);
+  };
 
-  return create(ResourceInfo(context.cache(), name, path),
-                context, *mesh, materials);
+  return cache.loadAsync<Model, ModelData>(name, decode, finish);
 }
 
 } /*namespace wendy*/
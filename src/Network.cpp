@@ -306,7 +306,17 @@ bool Host::update(Time timeout)
         if (isClient())
           peerID = SERVER;
         else
-          peerID = m_clientIDs.allocateID();
+        {
+          const Handle handle = m_clientIDs.allocate();
+          if (handle.isNull())
+          {
+            logError("Out of client IDs for peer %s", name);
+            enet_peer_reset(event.peer);
+            break;
+          }
+
+          peerID = TargetID(handle.index());
+        }
 
         m_peers.push_back(Peer(event.peer, peerID, name));
         event.peer->data = &(m_peers.back());
@@ -335,7 +345,8 @@ bool Host::update(Time timeout)
             if (m_observer)
               m_observer->onPeerDisconnected(*p, reason);
 
-            m_clientIDs.releaseID(p->id());
+            if (isServer())
+              m_clientIDs.release(m_clientIDs.handleOf(p->id()));
 
             m_peers.erase(p);
             break;
@@ -504,8 +515,8 @@ std::unique_ptr<Host> Host::connect(const std::string& name,
 Host::Host():
   m_object(nullptr),
   m_observer(nullptr),
-  m_clientIDs(FIRST_CLIENT),
-  m_objectIDs(OBJECT_ID_POOL_BASE),
+  m_clientIDs(FIRST_CLIENT, std::numeric_limits<TargetID>::max() + 1),
+  m_objectIDs(OBJECT_ID_POOL_BASE, std::numeric_limits<NetworkObjectID>::max() + 1),
   m_allocated(0)
 {
 }
@@ -627,7 +638,13 @@ NetworkObject::NetworkObject(Host& host, NetworkObjectID objectID):
   if (isOnServer())
   {
     if (m_id == OBJECT_ID_INVALID)
-      m_id = m_host.m_objectIDs.allocateID();
+    {
+      m_handle = m_host.m_objectIDs.allocate();
+      if (m_handle.isNull())
+        panic("Out of network object IDs");
+
+      m_id = NetworkObjectID(m_handle.index());
+    }
   }
   else
   {
@@ -645,8 +662,8 @@ NetworkObject::NetworkObject(Host& host, NetworkObjectID objectID):
 
 NetworkObject::~NetworkObject()
 {
-  if (isOnServer() && m_id >= OBJECT_ID_POOL_BASE)
-    m_host.m_objectIDs.releaseID(m_id);
+  if (!m_handle.isNull())
+    m_host.m_objectIDs.release(m_handle);
 
   m_host.m_objects[m_id] = nullptr;
 }
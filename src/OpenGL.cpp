@@ -292,6 +292,105 @@ GLenum convertToGL(const PixelFormat& format, bool sRGB)
       break;
     }
 
+    case PixelFormat::BC1:
+    case PixelFormat::BC3:
+    {
+      if (!GREG_EXT_texture_compression_s3tc)
+      {
+        logError("S3TC texture compression not supported; "
+                 "cannot convert pixel format");
+        return 0;
+      }
+
+      if (sRGB && !GREG_EXT_texture_sRGB)
+      {
+        logError("Compressed sRGB textures not supported; "
+                 "cannot convert pixel format");
+        return 0;
+      }
+
+      if (format == PixelFormat::RGB_BC1)
+      {
+        if (sRGB)
+          return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+        else
+          return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      }
+
+      if (format == PixelFormat::RGBA_BC3)
+      {
+        if (sRGB)
+          return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+        else
+          return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      }
+
+      break;
+    }
+
+    case PixelFormat::BC4:
+    case PixelFormat::BC5:
+    {
+      // There are no sRGB variants of the RGTC formats
+      if (sRGB)
+        break;
+
+      if (format == PixelFormat::L_BC4)
+        return GL_COMPRESSED_RED_RGTC1;
+      if (format == PixelFormat::LA_BC5)
+        return GL_COMPRESSED_RG_RGTC2;
+
+      break;
+    }
+
+    case PixelFormat::BC7:
+    {
+      if (!GREG_ARB_texture_compression_bptc)
+      {
+        logError("BPTC texture compression not supported; "
+                 "cannot convert pixel format");
+        return 0;
+      }
+
+      if (format == PixelFormat::RGBA_BC7)
+      {
+        if (sRGB)
+          return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+        else
+          return GL_COMPRESSED_RGBA_BPTC_UNORM;
+      }
+
+      break;
+    }
+
+    case PixelFormat::ETC2:
+    {
+      if (!GREG_ARB_ES3_compatibility)
+      {
+        logError("ETC2 texture compression not supported; "
+                 "cannot convert pixel format");
+        return 0;
+      }
+
+      if (format == PixelFormat::RGB_ETC2)
+      {
+        if (sRGB)
+          return GL_COMPRESSED_SRGB8_ETC2;
+        else
+          return GL_COMPRESSED_RGB8_ETC2;
+      }
+
+      if (format == PixelFormat::RGBA_ETC2)
+      {
+        if (sRGB)
+          return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+        else
+          return GL_COMPRESSED_RGBA8_ETC2_EAC;
+      }
+
+      break;
+    }
+
     default:
       break;
   }
@@ -341,8 +440,91 @@ GLfloat getFloat(GLenum token)
   return value;
 }
 
-Preprocessor::Preprocessor(ResourceCache& cache):
-  m_cache(cache)
+void* initStreamStorage(GLenum target, size_t size)
+{
+  if (GREG_ARB_buffer_storage)
+  {
+    const GLbitfield flags = GL_MAP_WRITE_BIT |
+                             GL_MAP_PERSISTENT_BIT |
+                             GL_MAP_COHERENT_BIT;
+
+    glBufferStorage(target, size, nullptr, flags);
+    return glMapBufferRange(target, 0, size, flags);
+  }
+
+  glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+  return nullptr;
+}
+
+void writeStream(GLenum target,
+                 void* mapping,
+                 size_t offset,
+                 size_t size,
+                 const void* source)
+{
+  // Stream sections are fenced before reuse, so no implicit sync is needed
+  if (mapping)
+    std::memcpy((char*) mapping + offset, source, size);
+  else
+  {
+    const GLbitfield flags = GL_MAP_WRITE_BIT |
+                             GL_MAP_INVALIDATE_RANGE_BIT |
+                             GL_MAP_UNSYNCHRONIZED_BIT;
+
+    if (void* data = glMapBufferRange(target, offset, size, flags))
+    {
+      std::memcpy(data, source, size);
+      glUnmapBuffer(target);
+    }
+  }
+}
+
+uint64 hashString(const std::string& string, uint64 hash)
+{
+  for (char c : string)
+  {
+    hash ^= uint8(c);
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+const PreprocessedUnit* PreprocessorCache::findFile(const Path& path) const
+{
+  auto entry = m_files.find(path.name());
+  if (entry == m_files.end())
+    return nullptr;
+
+  return entry->second;
+}
+
+const PreprocessedUnit* PreprocessorCache::findUnit(uint64 hash) const
+{
+  auto entry = m_units.find(hash);
+  if (entry == m_units.end())
+    return nullptr;
+
+  return entry->second.get();
+}
+
+void PreprocessorCache::addFile(const Path& path, const PreprocessedUnit& unit)
+{
+  m_files[path.name()] = &unit;
+}
+
+const PreprocessedUnit& PreprocessorCache::addUnit(uint64 hash,
+                                                   PreprocessedUnit&& unit)
+{
+  std::unique_ptr<PreprocessedUnit>& entry = m_units[hash];
+  entry.reset(new PreprocessedUnit(std::move(unit)));
+  return *entry;
+}
+
+Preprocessor::Preprocessor(ResourceCache& cache, PreprocessorCache& units):
+  m_cache(cache),
+  m_units(units),
+  m_unit(nullptr)
 {
 }
 
@@ -364,6 +546,17 @@ void Preprocessor::parse(const char* name)
     throw Exception("Failed to find shader file");
   }
 
+  m_paths.push_back(path);
+
+  if (std::find(m_names.begin(), m_names.end(), name) != m_names.end())
+    return;
+
+  if (const PreprocessedUnit* unit = m_units.findFile(path))
+  {
+    emit(name, *unit);
+    return;
+  }
+
   std::ifstream stream(path.name());
   if (stream.fail())
   {
@@ -380,8 +573,6 @@ void Preprocessor::parse(const char* name)
     throw Exception("Failed to open shader file");
   }
 
-  m_paths.push_back(path);
-
   std::string text;
 
   stream.seekg(0, std::ios::end);
@@ -390,7 +581,14 @@ void Preprocessor::parse(const char* name)
   stream.read(&text[0], text.size());
   stream.close();
 
-  parse(name, text.c_str());
+  const uint64 hash = hashString(text);
+
+  const PreprocessedUnit* unit = m_units.findUnit(hash);
+  if (!unit)
+    unit = &m_units.addUnit(hash, tokenize(name, text.c_str()));
+
+  m_units.addFile(path, *unit);
+  emit(name, *unit);
 }
 
 void Preprocessor::parse(const char* name, const char* text)
@@ -398,15 +596,26 @@ void Preprocessor::parse(const char* name, const char* text)
   if (std::find(m_names.begin(), m_names.end(), name) != m_names.end())
     return;
 
-  m_files.push_back(File(name, text));
-  m_names.push_back(name);
+  const uint64 hash = hashString(text);
 
-  m_list += format("( file %u: %s )\n", (uint) m_names.size(), name);
+  const PreprocessedUnit* unit = m_units.findUnit(hash);
+  if (!unit)
+    unit = &m_units.addUnit(hash, tokenize(name, text));
 
-  m_output.reserve(m_output.size() + std::strlen(text));
-  appendToOutput(format("#line 0 %u /* entering %s */\n",
-                        (uint) m_files.size(),
-                        m_files.back().name).c_str());
+  emit(name, *unit);
+}
+
+PreprocessedUnit Preprocessor::tokenize(const char* name, const char* text)
+{
+  PreprocessedUnit unit;
+
+  // Segment text is collected in the output, which is swapped back once the
+  // whole file has been tokenized
+  std::string output;
+  output.swap(m_output);
+
+  m_unit = &unit;
+  m_files.push_back(File(name, text));
 
   while (hasMore())
   {
@@ -428,6 +637,48 @@ void Preprocessor::parse(const char* name, const char* text)
     }
   }
 
+  addDirective(PreprocessedUnit::NO_DIRECTIVE, std::string());
+
+  m_files.pop_back();
+  m_unit = nullptr;
+
+  output.swap(m_output);
+  return unit;
+}
+
+void Preprocessor::emit(const char* name, const PreprocessedUnit& unit)
+{
+  m_files.push_back(File(name, nullptr));
+  m_names.push_back(name);
+
+  m_list += format("( file %u: %s )\n", (uint) m_names.size(), name);
+
+  appendToOutput(format("#line 0 %u /* entering %s */\n",
+                        (uint) m_files.size(),
+                        m_files.back().name).c_str());
+
+  for (const PreprocessedUnit::Segment& segment : unit.segments)
+  {
+    m_output.append(segment.text);
+    m_files.back().line = segment.line;
+
+    if (segment.type == PreprocessedUnit::INCLUDE_DIRECTIVE)
+      parse(segment.argument.c_str());
+    else if (segment.type == PreprocessedUnit::VERSION_DIRECTIVE)
+    {
+      if (!m_version.empty())
+      {
+        logError("%s:%u: Duplicate #version directive",
+                 m_files.back().name,
+                 m_files.back().line);
+
+        throw Exception("Duplicate #version directive");
+      }
+
+      m_version = segment.argument;
+    }
+  }
+
   m_files.pop_back();
 
   if (!m_files.empty())
@@ -439,6 +690,18 @@ void Preprocessor::parse(const char* name, const char* text)
   }
 }
 
+void Preprocessor::addDirective(PreprocessedUnit::DirectiveType type,
+                                const std::string& argument)
+{
+  PreprocessedUnit::Segment segment;
+  segment.text.swap(m_output);
+  segment.type = type;
+  segment.argument = argument;
+  segment.line = m_files.back().line;
+
+  m_unit->segments.push_back(std::move(segment));
+}
+
 bool Preprocessor::hasVersion() const
 {
   return !m_version.empty();
@@ -647,22 +910,14 @@ void Preprocessor::parseCommand()
     passWhitespace();
     const std::string name = passShaderName();
     discard();
-    parse(name.c_str());
+    addDirective(PreprocessedUnit::INCLUDE_DIRECTIVE, name);
   }
   else if (command == "version")
   {
-    if (!m_version.empty())
-    {
-      logError("%s:%u: Duplicate #version directive",
-               m_files.back().name,
-               m_files.back().line);
-
-      throw Exception("Duplicate #version directive");
-    }
-
     passWhitespace();
-    m_version = passNumber();
+    const std::string version = passNumber();
     discard();
+    addDirective(PreprocessedUnit::VERSION_DIRECTIVE, version);
   }
 
   while (hasMore())
@@ -45,7 +45,21 @@ const size_t uniformTypeSizes[] =
   sizeof(mat2), sizeof(mat3), sizeof(mat4)
 };
 
-IDPool<PassID> passIDs;
+// Revisions are unique across all passes, so a program can tell whether the
+// uniform values it last received came from the current state of a pass
+uint64 nextRevision = 0;
+
+// Pass IDs are packed into render operation sort keys
+HandlePool passHandles(0, 0x10000);
+
+Handle allocatePassHandle()
+{
+  const Handle handle = passHandles.allocate();
+  if (handle.isNull())
+    panic("Out of pass IDs");
+
+  return handle;
+}
 
 } /*namespace*/
 
@@ -62,12 +76,14 @@ UniformStateIndex::UniformStateIndex(uint16 index, uint16 offset):
 }
 
 Pass::Pass():
-  m_id(passIDs.allocateID())
+  m_handle(allocatePassHandle()),
+  m_revision(++nextRevision)
 {
 }
 
 Pass::Pass(const Pass& source):
-  m_id(passIDs.allocateID())
+  m_handle(allocatePassHandle()),
+  m_revision(++nextRevision)
 {
   operator = (source);
 }
@@ -75,7 +91,7 @@ Pass::Pass(const Pass& source):
 Pass::~Pass()
 {
   setProgram(nullptr);
-  passIDs.releaseID(m_id);
+  passHandles.release(m_handle);
 }
 
 void Pass::apply() const
@@ -89,6 +105,12 @@ void Pass::apply() const
   SharedProgramState* state = context.sharedProgramState();
   assert(state);
 
+  // The program still holds the values of this pass if it was last applied
+  // with this revision
+  const bool current = m_program->m_passRevision == m_revision;
+  m_program->m_passRevision = m_revision;
+
+  uint skippedUniforms = 0, skippedTextures = 0;
   uint textureUnit = 0;
   size_t offset = 0;
 
@@ -96,16 +118,26 @@ void Pass::apply() const
   {
     if (uniform.isSampler())
     {
-      context.setTextureUnit(textureUnit);
-      textureUnit++;
-
       if (uniform.isShared())
+      {
+        context.setTextureUnit(textureUnit);
         state->updateTo(uniform);
+      }
       else
       {
-        context.setTexture(*(Ref<Texture>*)(&m_uniformState[offset]));
+        Texture* texture = *(Ref<Texture>*)(&m_uniformState[offset]);
         offset += uniformTypeSizes[uniform.type()];
+
+        if (context.boundTexture(textureUnit) == texture)
+          skippedTextures++;
+        else
+        {
+          context.setTextureUnit(textureUnit);
+          context.setTexture(texture);
+        }
       }
+
+      textureUnit++;
     }
     else
     {
@@ -113,11 +145,16 @@ void Pass::apply() const
         state->updateTo(uniform);
       else
       {
-        uniform.copyFrom(&m_uniformState[offset]);
+        if (current || !uniform.copyFrom(&m_uniformState[offset]))
+          skippedUniforms++;
+
         offset += uniformTypeSizes[uniform.type()];
       }
     }
   }
+
+  if (RenderStats* stats = context.stats())
+    stats->addSkippedCalls(skippedUniforms, skippedTextures);
 }
 
 Pass& Pass::operator = (const Pass& source)
@@ -432,6 +469,7 @@ void Pass::setUniformTexture(UniformStateIndex index, Texture* texture)
   assert(m_program);
   assert(m_program->uniform(index.index).type() == UniformType(texture->type()));
   *(Ref<Texture>*)(&m_uniformState[index.offset]) = texture;
+  m_revision = ++nextRevision;
 }
 
 UniformStateIndex Pass::uniformStateIndex(const char* name) const
@@ -479,6 +517,7 @@ void Pass::setProgram(Program* program)
 
   m_uniformState.clear();
   m_program = program;
+  m_revision = ++nextRevision;
 
   if (m_program)
   {
@@ -501,6 +540,8 @@ void* Pass::data(UniformStateIndex index, UniformType type)
   assert(m_program);
   assert(m_program->uniform(index.index).type() == type);
 
+  m_revision = ++nextRevision;
+
   return &m_uniformState[index.offset];
 }
 
@@ -260,6 +260,52 @@ std::vector<std::string> Path::children() const
   return children;
 }
 
+std::vector<std::string> Path::files() const
+{
+  std::vector<std::string> files;
+
+#if WENDY_SYSTEM_WIN32
+  WIN32_FIND_DATA data;
+  HANDLE search;
+
+  search = FindFirstFile((m_string + "/*").c_str(), &data);
+  if (search != INVALID_HANDLE_VALUE)
+  {
+    do
+    {
+      if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        files.push_back(data.cFileName);
+    }
+    while (FindNextFile(search, &data));
+
+    FindClose(search);
+  }
+#else
+  DIR* stream;
+  dirent* entry;
+
+  stream = opendir(m_string.c_str());
+  if (stream)
+  {
+    while ((entry = readdir(stream)))
+    {
+      // Only entries of unknown type or symbolic links need a stat
+      if (entry->d_type == DT_REG)
+        files.push_back(entry->d_name);
+      else if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK)
+      {
+        if ((*this + entry->d_name).isFile())
+          files.push_back(entry->d_name);
+      }
+    }
+
+    closedir(stream);
+  }
+#endif
+
+  return files;
+}
+
 std::vector<std::string> Path::childrenMatching(const std::regex& regex) const
 {
   std::vector<std::string> children;
@@ -69,6 +69,9 @@ PixelFormat::PixelFormat(const char* specification):
 
   std::string typeName;
 
+  if (*c == '_')
+    c++;
+
   while (std::isdigit(*c) || std::isalpha(*c))
     typeName += std::tolower(*c++);
 
@@ -84,6 +87,18 @@ PixelFormat::PixelFormat(const char* specification):
     m_type = FLOAT16;
   else if (typeName == "32f")
     m_type = FLOAT32;
+  else if (typeName == "bc1")
+    m_type = BC1;
+  else if (typeName == "bc3")
+    m_type = BC3;
+  else if (typeName == "bc4")
+    m_type = BC4;
+  else if (typeName == "bc5")
+    m_type = BC5;
+  else if (typeName == "bc7")
+    m_type = BC7;
+  else if (typeName == "etc2")
+    m_type = ETC2;
   else
     throw Exception("Invalid pixel format type name");
 }
@@ -98,11 +113,25 @@ bool PixelFormat::operator != (const PixelFormat& other) const
   return m_semantic != other.m_semantic || m_type != other.m_type;
 }
 
+size_t PixelFormat::size(uint width, uint height, uint depth) const
+{
+  if (isCompressed())
+    return ((width + 3) / 4) * ((height + 3) / 4) * depth * blockSize();
+
+  return width * height * depth * size();
+}
+
 size_t PixelFormat::channelSize() const
 {
   switch (m_type)
   {
     case DUMMY:
+    case BC1:
+    case BC3:
+    case BC4:
+    case BC5:
+    case BC7:
+    case ETC2:
       return 0;
     case UINT8:
       return 1;
@@ -119,6 +148,24 @@ size_t PixelFormat::channelSize() const
   }
 }
 
+size_t PixelFormat::blockSize() const
+{
+  switch (m_type)
+  {
+    case BC1:
+    case BC4:
+      return 8;
+    case BC3:
+    case BC5:
+    case BC7:
+      return 16;
+    case ETC2:
+      return m_semantic == RGBA ? 16 : 8;
+    default:
+      return 0;
+  }
+}
+
 uint PixelFormat::channelCount() const
 {
   switch (m_semantic)
@@ -174,6 +221,18 @@ const char* stringCast(PixelFormat::Type type)
       return "16f";
     case PixelFormat::FLOAT32:
       return "32f";
+    case PixelFormat::BC1:
+      return "bc1";
+    case PixelFormat::BC3:
+      return "bc3";
+    case PixelFormat::BC4:
+      return "bc4";
+    case PixelFormat::BC5:
+      return "bc5";
+    case PixelFormat::BC7:
+      return "bc7";
+    case PixelFormat::ETC2:
+      return "etc2";
     default:
       panic("Invalid pixel format type %i", type);
   }
@@ -181,7 +240,12 @@ const char* stringCast(PixelFormat::Type type)
 
 std::string stringCast(PixelFormat format)
 {
-  return std::string(stringCast(format.semantic())) + stringCast(format.type());
+  std::string result(stringCast(format.semantic()));
+
+  if (format.isCompressed())
+    result += '_';
+
+  return result + stringCast(format.type());
 }
 
 const PixelFormat PixelFormat::L8(PixelFormat::L, PixelFormat::UINT8);
@@ -210,5 +274,13 @@ const PixelFormat PixelFormat::DEPTH32(PixelFormat::DEPTH, PixelFormat::UINT32);
 const PixelFormat PixelFormat::DEPTH16F(PixelFormat::DEPTH, PixelFormat::FLOAT16);
 const PixelFormat PixelFormat::DEPTH32F(PixelFormat::DEPTH, PixelFormat::FLOAT32);
 
+const PixelFormat PixelFormat::RGB_BC1(PixelFormat::RGB, PixelFormat::BC1);
+const PixelFormat PixelFormat::RGBA_BC3(PixelFormat::RGBA, PixelFormat::BC3);
+const PixelFormat PixelFormat::L_BC4(PixelFormat::L, PixelFormat::BC4);
+const PixelFormat PixelFormat::LA_BC5(PixelFormat::LA, PixelFormat::BC5);
+const PixelFormat PixelFormat::RGBA_BC7(PixelFormat::RGBA, PixelFormat::BC7);
+const PixelFormat PixelFormat::RGB_ETC2(PixelFormat::RGB, PixelFormat::ETC2);
+const PixelFormat PixelFormat::RGBA_ETC2(PixelFormat::RGBA, PixelFormat::ETC2);
+
 } /*namespace wendy*/
 
@@ -186,7 +186,7 @@ void Sphere::envelop(const Sphere& sphere)
                               (radius - sphere.radius);
   const float distanceSquared = length2(difference);
 
-  if (distanceSquared < radiusSquared)
+  if (distanceSquared <= radiusSquared)
   {
     if (sphere.radius > radius)
       operator = (sphere);
@@ -195,9 +195,10 @@ void Sphere::envelop(const Sphere& sphere)
   }
 
   const float distance = sqrt(distanceSquared);
+  const float newRadius = (distance + radius + sphere.radius) / 2.f;
 
-  center = center + (difference / distance) * (distance - radius);
-  radius = (distance + radius + sphere.radius) / 2.f;
+  center = center + (difference / distance) * (newRadius - radius);
+  radius = newRadius;
 }
 
 void Sphere::set(vec3 newCenter, float newRadius)
@@ -28,12 +28,51 @@
 #include <wendy/Core.hpp>
 #include <wendy/Time.hpp>
 #include <wendy/Profile.hpp>
+#include <wendy/Path.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+
+#include <cstring>
 
 namespace wendy
 {
 
+namespace
+{
+
+const uint MAX_ZONE_COUNT = 4096;
+
+const char* zoneNames[MAX_ZONE_COUNT];
+std::atomic<uint> zoneNameCount(0);
+std::mutex zoneMutex;
+
+// Zone and thread names are arbitrary text, so quotes, backslashes and control
+// characters must be escaped to keep the trace valid JSON
+std::string escapeJSON(const char* text)
+{
+  std::string result;
+
+  for (const char* c = text;  *c;  c++)
+  {
+    if (*c == '"' || *c == '\\')
+    {
+      result += '\\';
+      result += *c;
+    }
+    else if ((unsigned char) *c < 0x20)
+      result += format("\\u%04x", uint((unsigned char) *c));
+    else
+      result += *c;
+  }
+
+  return result;
+}
+
+} /*namespace*/
+
 bool ProfileNode::operator == (const char* string) const
 {
   return m_name == string;
@@ -55,17 +94,40 @@ ProfileNode* ProfileNode::findChild(const char* name)
   return &(*n);
 }
 
+Profile::Profile(const std::string& name):
+  m_name(name),
+  m_root("Root"),
+  m_eventCount(0),
+  m_frameHistory(0)
+{
+}
+
 void Profile::beginFrame()
 {
+  if (m_frameHistory)
+  {
+    m_frames.push_back(m_eventCount);
+    if (m_frames.size() > m_frameHistory)
+      m_frames.pop_front();
+
+    recordEvent("Frame", PROFILE_EVENT_BEGIN);
+  }
+
   resetNode(m_root);
   beginNode(m_root);
   m_timer.start();
+
+  for (ProfileZoneStats& z : m_zones)
+    z = ProfileZoneStats{0, 0};
 }
 
 void Profile::endFrame()
 {
   endNode();
   m_timer.stop();
+
+  if (m_frameHistory)
+    recordEvent("Frame", PROFILE_EVENT_END);
 }
 
 void Profile::beginNode(const char* name)
@@ -80,6 +142,9 @@ void Profile::beginNode(const char* name)
   }
 
   beginNode(*node);
+
+  if (m_frameHistory)
+    recordEvent(name, PROFILE_EVENT_BEGIN);
 }
 
 void Profile::endNode()
@@ -88,6 +153,41 @@ void Profile::endNode()
   node->m_duration = m_timer.time() - node->m_duration;
 
   m_stack.pop_back();
+
+  if (m_frameHistory && !m_stack.empty())
+    recordEvent(nullptr, PROFILE_EVENT_END);
+}
+
+void Profile::setHistory(uint frameCount, uint eventCapacity)
+{
+  m_events.clear();
+  m_frames.clear();
+  m_eventCount = 0;
+  m_frameHistory = frameCount;
+
+  if (frameCount)
+    m_events.resize(std::max(eventCapacity, 1u));
+}
+
+void Profile::visitHistory(const std::function<void (const ProfileEvent&)>& function) const
+{
+  const uint64 capacity = m_events.size();
+  const uint64 oldest = m_eventCount > capacity ? m_eventCount - capacity : 0;
+
+  // Start at the oldest frame whose events have not been overwritten, or at
+  // the oldest event if there is no such frame
+  uint64 first = oldest;
+  for (uint64 f : m_frames)
+  {
+    if (f >= oldest)
+    {
+      first = f;
+      break;
+    }
+  }
+
+  for (uint64 i = first;  i < m_eventCount;  i++)
+    function(m_events[i % capacity]);
 }
 
 void Profile::beginNode(ProfileNode& node)
@@ -98,6 +198,59 @@ void Profile::beginNode(ProfileNode& node)
   m_stack.push_back(&node);
 }
 
+void Profile::recordEvent(const char* name, ProfileEventType type)
+{
+  ProfileEvent& event = m_events[m_eventCount % m_events.size()];
+  event.name = name;
+  event.time = profileClock() / 1e9;
+  event.duration = 0.0;
+  event.type = type;
+
+  m_eventCount++;
+}
+
+void Profile::recordZone(uint zone, uint64 start, uint64 end)
+{
+  ProfileEvent& event = m_events[m_eventCount % m_events.size()];
+  event.name = zoneName(zone);
+  event.time = start / 1e9;
+  event.duration = (end - start) / 1e9;
+  event.type = PROFILE_EVENT_ZONE;
+
+  m_eventCount++;
+}
+
+uint Profile::zoneID(const char* name)
+{
+  std::lock_guard<std::mutex> lock(zoneMutex);
+
+  const uint count = zoneNameCount.load(std::memory_order_relaxed);
+
+  for (uint i = 0;  i < count;  i++)
+  {
+    if (std::strcmp(zoneNames[i], name) == 0)
+      return i;
+  }
+
+  if (count == MAX_ZONE_COUNT)
+    panic("Too many profile zones");
+
+  zoneNames[count] = name;
+  zoneNameCount.store(count + 1, std::memory_order_release);
+  return count;
+}
+
+const char* Profile::zoneName(uint zone)
+{
+  assert(zone < zoneNameCount.load(std::memory_order_acquire));
+  return zoneNames[zone];
+}
+
+uint Profile::zoneCount()
+{
+  return zoneNameCount.load(std::memory_order_acquire);
+}
+
 void Profile::resetNode(ProfileNode& node)
 {
   node.m_calls = 0;
@@ -107,7 +260,114 @@ void Profile::resetNode(ProfileNode& node)
     resetNode(c);
 }
 
-Profile* Profile::m_current = nullptr;
+thread_local Profile* Profile::m_current = nullptr;
+
+ProfileTrace::ProfileTrace():
+  m_start(0.0),
+  m_end(0.0)
+{
+}
+
+void ProfileTrace::addProfile(const Profile& profile)
+{
+  const uint thread = uint(m_threads.size());
+  m_threads.push_back(profile.name());
+
+  const bool first = thread == 0;
+  const size_t base = m_events.size();
+
+  // Pair up begin and end events into complete events, dropping ends whose
+  // beginning is no longer in the history
+  std::vector<size_t> stack;
+  Time last = 0.0;
+
+  profile.visitHistory([&](const ProfileEvent& e)
+  {
+    last = std::max(last, e.time + e.duration);
+
+    if (e.type == PROFILE_EVENT_ZONE)
+      m_events.push_back(Event{e.name, e.time, e.duration, thread});
+    else if (e.type == PROFILE_EVENT_BEGIN)
+    {
+      stack.push_back(m_events.size());
+      m_events.push_back(Event{e.name, e.time, 0.0, thread});
+    }
+    else if (!stack.empty())
+    {
+      Event& event = m_events[stack.back()];
+      event.duration = e.time - event.start;
+      stack.pop_back();
+    }
+  });
+
+  // Close nodes that were still open when the history was read
+  for (size_t index : stack)
+    m_events[index].duration = last - m_events[index].start;
+
+  if (first)
+  {
+    if (m_events.empty())
+      return;
+
+    m_start = m_events.front().start;
+    for (const Event& e : m_events)
+      m_start = std::min(m_start, e.start);
+    m_end = last;
+  }
+  else
+  {
+    auto outside = [this](const Event& e)
+    {
+      return e.start + e.duration < m_start || e.start > m_end;
+    };
+
+    m_events.erase(std::remove_if(m_events.begin() + base, m_events.end(), outside),
+                   m_events.end());
+  }
+}
+
+bool ProfileTrace::write(const Path& path) const
+{
+  std::ofstream stream(path.name());
+  if (!stream.is_open())
+  {
+    logError("Failed to open %s for writing", path.name().c_str());
+    return false;
+  }
+
+  stream << "{\"traceEvents\":[\n";
+
+  for (size_t i = 0;  i < m_threads.size();  i++)
+  {
+    if (i > 0)
+      stream << ",\n";
+
+    stream << format("{\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                     "\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+                     uint(i), escapeJSON(m_threads[i].c_str()).c_str());
+  }
+
+  // Timestamps are in microseconds relative to the start of the trace
+  for (const Event& e : m_events)
+  {
+    stream << format(",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                     "\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f}",
+                     e.thread,
+                     escapeJSON(e.name).c_str(),
+                     (e.start - m_start) * 1e6,
+                     e.duration * 1e6);
+  }
+
+  stream << "\n]}\n";
+
+  if (!stream)
+  {
+    logError("Failed to write trace to %s", path.name().c_str());
+    return false;
+  }
+
+  return true;
+}
 
 } /*namespace wendy*/
 
@@ -25,6 +25,9 @@
 
 #include <wendy/Config.hpp>
 
+#include <wendy/Core.hpp>
+#include <wendy/Time.hpp>
+#include <wendy/Profile.hpp>
 #include <wendy/Texture.hpp>
 #include <wendy/RenderBuffer.hpp>
 #include <wendy/Program.hpp>
@@ -34,9 +37,17 @@
 
 #include <internal/OpenGL.hpp>
 
+#if WENDY_HAVE_UNISTD_H
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <process.h>
+#endif
+
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 
+#include <cctype>
 #include <cstring>
 
 #include <pugixml.hpp>
@@ -79,15 +90,17 @@ const struct
   bool scalar;
   bool vector;
   uint elementCount;
+  uint columnCount;
   GLenum elementType;
   GLenum nativeType;
   const char* name;
 } attributeTypes[] =
 {
-  {  true, false, 1, GL_FLOAT, GL_FLOAT,      "float" },
-  { false,  true, 2, GL_FLOAT, GL_FLOAT_VEC2, "vec2" },
-  { false,  true, 3, GL_FLOAT, GL_FLOAT_VEC3, "vec3" },
-  { false,  true, 4, GL_FLOAT, GL_FLOAT_VEC4, "vec4" },
+  {  true, false,  1, 1, GL_FLOAT, GL_FLOAT,      "float" },
+  { false,  true,  2, 1, GL_FLOAT, GL_FLOAT_VEC2, "vec2" },
+  { false,  true,  3, 1, GL_FLOAT, GL_FLOAT_VEC3, "vec3" },
+  { false,  true,  4, 1, GL_FLOAT, GL_FLOAT_VEC4, "vec4" },
+  { false, false, 16, 4, GL_FLOAT, GL_FLOAT_MAT4, "mat4" },
 };
 
 AttributeType convertAttributeType(GLenum type)
@@ -122,6 +135,32 @@ bool isSupportedUniformType(GLenum type)
   return convertUniformType(type) != -1;
 }
 
+// Bump when the layout of cached program binary files changes
+const char PROGRAM_BINARY_MAGIC[8] = { 'W', 'Y', 'P', 'R', 'O', 'G', '0', '1' };
+
+struct ProgramBinaryHeader
+{
+  char magic[8];
+  uint64 key;
+  uint32 format;
+  uint32 size;
+};
+
+// Numbers the temporary files written by this process, so that concurrent
+// saves never share a temporary file
+std::atomic<uint> temporaryCount(0);
+
+uint processID()
+{
+#if WENDY_HAVE_UNISTD_H
+  return uint(getpid());
+#elif defined(_WIN32)
+  return uint(_getpid());
+#else
+  return 0;
+#endif
+}
+
 GLenum convertToGL(ShaderType type)
 {
   switch (type)
@@ -135,6 +174,48 @@ GLenum convertToGL(ShaderType type)
   panic("Invalid GLSL shader type %i", type);
 }
 
+bool isIdentifierChar(char c)
+{
+  return std::isalnum((unsigned char) c) || c == '_';
+}
+
+bool referencesName(const std::string& text, const char* name)
+{
+  const size_t length = std::strlen(name);
+
+  for (size_t start = text.find(name);
+       start != std::string::npos;
+       start = text.find(name, start + 1))
+  {
+    if (start > 0 && isIdentifierChar(text[start - 1]))
+      continue;
+
+    const size_t end = start + length;
+    if (end < text.length() && isIdentifierChar(text[end]))
+      continue;
+
+    return true;
+  }
+
+  return false;
+}
+
+/* Returns the number of inverse matrices at the end of the wyObject block, in
+ * block order, up to and including the last one the text refers to.
+ */
+uint countObjectInverses(const std::string& text)
+{
+  const char* names[] = { "wyInvM", "wyInvMV", "wyInvMVP" };
+
+  for (uint count = 3;  count > 0;  count--)
+  {
+    if (referencesName(text, names[count - 1]))
+      return count;
+  }
+
+  return 0;
+}
+
 } /*namespace*/
 
 Shader::~Shader()
@@ -149,7 +230,7 @@ Ref<Shader> Shader::create(const ResourceInfo& info,
                           const std::string& text)
 {
   Ref<Shader> shader(new Shader(info, context, type));
-  if (!shader->init(text))
+  if (!shader->init(text.c_str()))
     return nullptr;
 
   return shader;
@@ -171,41 +252,37 @@ Ref<Shader> Shader::read(RenderContext& context,
     return nullptr;
   }
 
-  std::ifstream stream(path.name());
-  if (stream.fail())
-  {
-    logError("Failed to open shader file %s", path.name().c_str());
+  // The file is read through the preprocessor cache of the context
+  Ref<Shader> shader(new Shader(ResourceInfo(cache, name, path), context, type));
+  if (!shader->init(nullptr))
     return nullptr;
-  }
-
-  std::string text;
-
-  stream.seekg(0, std::ios::end);
-  text.resize((uint) stream.tellg());
-
-  stream.seekg(0, std::ios::beg);
-  stream.read(&text[0], text.size());
 
-  return create(ResourceInfo(cache, name, path), context, type, text);
+  return shader;
 }
 
 Shader::Shader(const ResourceInfo& info,
                RenderContext& context,
                ShaderType type):
-  Resource(info),
+  Resource(info, this),
   m_context(context),
   m_type(type),
-  m_shaderID(0)
+  m_shaderID(0),
+  m_objectInverses(0)
 {
 }
 
-bool Shader::init(const std::string& text)
+bool Shader::init(const char* text)
 {
-  Preprocessor spp(cache());
+  Preprocessor spp(cache(), m_context.preprocessorCache());
 
   try
   {
-    spp.parse(name().c_str(), text.c_str());
+    WENDY_PROFILE_ZONE("Shader::preprocess");
+
+    if (text)
+      spp.parse(name().c_str(), text);
+    else
+      spp.parse(name().c_str());
   }
   catch (Exception& e)
   {
@@ -222,15 +299,29 @@ bool Shader::init(const std::string& text)
     shader += "\n";
   }
 
+  if (m_type == VERTEX_SHADER)
+    shader += "#define WY_VERTEX_SHADER 1\n";
+
   shader += "#line 0 0 /*shared program state*/\n";
   shader += m_context.sharedProgramStateDeclaration();
   shader += spp.output();
 
+  m_text = shader;
+  m_names = spp.names();
+  m_objectInverses = countObjectInverses(spp.output());
+  return true;
+}
+
+bool Shader::compile()
+{
+  if (m_shaderID)
+    return true;
+
   GLsizei lengths[1];
   const GLchar* strings[1];
 
-  lengths[0] = (GLsizei) shader.length();
-  strings[0] = (const GLchar*) shader.c_str();
+  lengths[0] = (GLsizei) m_text.length();
+  strings[0] = (const GLchar*) m_text.c_str();
 
   m_shaderID = glCreateShader(convertToGL(m_type));
 
@@ -264,7 +355,7 @@ bool Shader::init(const std::string& text)
       {
         logWarning("Warning(s) compiling shader %s:\n%s%s",
                    name().c_str(),
-                   spp.names().c_str(),
+                   m_names.c_str(),
                    infoLog.c_str());
       }
     }
@@ -276,7 +367,7 @@ bool Shader::init(const std::string& text)
       {
         logError("Failed to compile shader %s:\n%s%s",
                  name().c_str(),
-                 spp.names().c_str(),
+                 m_names.c_str(),
                  infoLog.c_str());
       }
 
@@ -305,22 +396,77 @@ uint Attribute::elementCount() const
   return attributeTypes[m_type].elementCount;
 }
 
-void Attribute::bind(size_t stride, size_t offset)
+uint Attribute::columnCount() const
 {
-  glVertexAttribPointer(m_location,
-                        attributeTypes[m_type].elementCount,
-                        attributeTypes[m_type].elementType,
-                        GL_FALSE,
-                        (GLsizei) stride,
-                        (const void*) offset);
+  return attributeTypes[m_type].columnCount;
+}
+
+void Attribute::bind(size_t stride, size_t offset, bool instanced)
+{
+  const uint columns = attributeTypes[m_type].columnCount;
+  const uint rows = attributeTypes[m_type].elementCount / columns;
+
+  for (uint i = 0;  i < columns;  i++)
+  {
+    glEnableVertexAttribArray(m_location + i);
+    glVertexAttribPointer(m_location + i,
+                          rows,
+                          attributeTypes[m_type].elementType,
+                          GL_FALSE,
+                          (GLsizei) stride,
+                          (const void*) (offset + i * rows * sizeof(float)));
+
+    if (GREG_ARB_instanced_arrays)
+      glVertexAttribDivisorARB(m_location + i, instanced ? 1 : 0);
+  }
 
 #if WENDY_DEBUG
   checkGL("Failed to set attribute %s", m_name.c_str());
 #endif
 }
 
-void Uniform::copyFrom(const void* data)
+void Attribute::setValue(const float* data)
 {
+  const uint columns = attributeTypes[m_type].columnCount;
+  const uint rows = attributeTypes[m_type].elementCount / columns;
+
+  for (uint i = 0;  i < columns;  i++)
+  {
+    glDisableVertexAttribArray(m_location + i);
+
+    switch (rows)
+    {
+      case 1:
+        glVertexAttrib1fv(m_location + i, data + i * rows);
+        break;
+      case 2:
+        glVertexAttrib2fv(m_location + i, data + i * rows);
+        break;
+      case 3:
+        glVertexAttrib3fv(m_location + i, data + i * rows);
+        break;
+      case 4:
+        glVertexAttrib4fv(m_location + i, data + i * rows);
+        break;
+    }
+  }
+
+#if WENDY_DEBUG
+  checkGL("Failed to set value of attribute %s", m_name.c_str());
+#endif
+}
+
+bool Uniform::copyFrom(const void* data)
+{
+  // All non-sampler uniform types have four byte elements
+  const size_t size = uniformTypes[m_type].elementCount * 4;
+
+  if (m_cached && std::memcmp(m_value, data, size) == 0)
+    return false;
+
+  std::memcpy(m_value, data, size);
+  m_cached = true;
+
   switch (m_type)
   {
     case UNIFORM_INT:
@@ -355,6 +501,8 @@ void Uniform::copyFrom(const void* data)
 #if WENDY_DEBUG
   checkGL("Failed to set uniform %s", m_name.c_str());
 #endif
+
+  return true;
 }
 
 bool Uniform::isScalar() const
@@ -394,6 +542,8 @@ const char* stringCast(UniformType type)
 
 Program::~Program()
 {
+  m_context.removeVertexArrays(this);
+
   if (m_programID)
     glDeleteProgram(m_programID);
 
@@ -522,9 +672,12 @@ Ref<Program> Program::read(RenderContext& context,
 }
 
 Program::Program(const ResourceInfo& info, RenderContext& context):
-  Resource(info),
+  Resource(info, this),
   m_context(context),
-  m_programID(0)
+  m_programID(0),
+  m_sharedBlocks(false),
+  m_objectInverses(0),
+  m_passRevision(0)
 {
   if (RenderStats* stats = m_context.stats())
     stats->addProgram();
@@ -561,9 +714,51 @@ bool Program::init(Shader& vertexShader, Shader& fragmentShader)
   if (m_context.debug())
     glObjectLabel(GL_PROGRAM, m_programID, name().length(), name().c_str());
 
+  const Path& cachePath = m_context.programCachePath();
+  if (cachePath.isEmpty())
+  {
+    if (!link())
+      return false;
+  }
+  else
+  {
+    // The shader texts include the shared program state declaration
+    uint64 key = hashString(m_context.driverString());
+    key = hashString(m_vertexShader->m_text, key);
+    key = hashString(m_fragmentShader->m_text, key);
+
+    const Path path = cachePath + format("%016llx.bin",
+                                         (unsigned long long) key);
+
+    if (!loadBinary(path, key))
+    {
+      if (!link())
+        return false;
+
+      saveBinary(path, key);
+    }
+  }
+
+  if (!retrieveUniforms())
+    return false;
+
+  if (!retrieveAttributes())
+    return false;
+
+  return true;
+}
+
+bool Program::link()
+{
+  if (!m_vertexShader->compile() || !m_fragmentShader->compile())
+    return false;
+
   glAttachShader(m_programID, m_vertexShader->m_shaderID);
   glAttachShader(m_programID, m_fragmentShader->m_shaderID);
 
+  if (!m_context.programCachePath().isEmpty())
+    glProgramParameteri(m_programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
   glLinkProgram(m_programID);
 
   const std::string info = infoLog();
@@ -587,15 +782,112 @@ bool Program::init(Shader& vertexShader, Shader& fragmentShader)
   if (!checkGL("Failed to create object for program %s", name().c_str()))
     return false;
 
-  if (!retrieveUniforms())
+  return true;
+}
+
+bool Program::loadBinary(const Path& path, uint64 key)
+{
+  std::ifstream stream(path.name(), std::ios::in | std::ios::binary);
+  if (stream.fail())
     return false;
 
-  if (!retrieveAttributes())
+  ProgramBinaryHeader header;
+  if (!stream.read((char*) &header, sizeof(header)) ||
+      std::memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic)) ||
+      header.key != key)
+  {
+    logWarning("Ignoring mismatched program binary %s for program %s",
+               path.name().c_str(),
+               name().c_str());
+    return false;
+  }
+
+  // The size comes from the file, so check it against what the file holds
+  // before allocating anything
+  const std::streampos start = stream.tellg();
+  stream.seekg(0, std::ios::end);
+  const std::streamoff remaining = stream.tellg() - start;
+  stream.seekg(start);
+
+  if (!stream || std::streamoff(header.size) > remaining)
+  {
+    logWarning("Ignoring truncated program binary %s for program %s",
+               path.name().c_str(),
+               name().c_str());
+    return false;
+  }
+
+  std::vector<char> binary(header.size);
+  if (!stream.read(binary.data(), binary.size()))
+  {
+    logWarning("Ignoring truncated program binary %s for program %s",
+               path.name().c_str(),
+               name().c_str());
     return false;
+  }
+
+  glProgramBinary(m_programID,
+                  header.format,
+                  binary.data(),
+                  GLsizei(binary.size()));
+
+  // Drivers reject binaries they can no longer use, for example after being
+  // updated without changing their version string
+  int status;
+  glGetProgramiv(m_programID, GL_LINK_STATUS, &status);
+  if (!status)
+  {
+    // Clear any error raised by the rejected binary
+    glGetError();
+    return false;
+  }
 
   return true;
 }
 
+void Program::saveBinary(const Path& path, uint64 key)
+{
+  GLint size;
+  glGetProgramiv(m_programID, GL_PROGRAM_BINARY_LENGTH, &size);
+  if (!size)
+    return;
+
+  ProgramBinaryHeader header;
+  std::memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic));
+  header.key = key;
+
+  std::vector<char> binary(size);
+  glGetProgramBinary(m_programID, size, &size, &header.format, binary.data());
+  header.size = size;
+
+  if (!checkGL("Failed to retrieve binary for program %s", name().c_str()))
+    return;
+
+  // Write to a temporary file unique to this save first, so that other
+  // processes never see a partially written binary
+  Path temporary(format("%s.%u.%u.tmp",
+                        path.name().c_str(),
+                        processID(),
+                        temporaryCount++));
+
+  {
+    std::ofstream stream(temporary.name(), std::ios::out | std::ios::binary);
+    if (stream.fail() ||
+        !stream.write((const char*) &header, sizeof(header)) ||
+        !stream.write(binary.data(), binary.size()))
+    {
+      logWarning("Failed to write program binary %s", temporary.name().c_str());
+      return;
+    }
+  }
+
+  if (!temporary.rename(path.name()))
+  {
+    logWarning("Failed to write program binary %s", path.name().c_str());
+    temporary.remove();
+  }
+}
+
 bool Program::retrieveUniforms()
 {
   m_context.setProgram(this);
@@ -633,6 +925,13 @@ bool Program::retrieveUniforms()
       continue;
     }
 
+    // Members of uniform blocks are backed by buffers, not by locations
+    const GLuint index = i;
+    GLint blockIndex;
+    glGetActiveUniformsiv(m_programID, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+    if (blockIndex != -1)
+      continue;
+
     if (isSupportedUniformType(uniformType))
     {
       m_uniforms.push_back(Uniform());
@@ -641,6 +940,7 @@ bool Program::retrieveUniforms()
       uniform.m_type = convertUniformType(uniformType);
       uniform.m_location = glGetUniformLocation(m_programID, uniformName);
       uniform.m_sharedID = m_context.sharedUniformID(uniformName, uniform.type());
+      uniform.m_cached = false;
 
       if (uniform.isSampler())
       {
@@ -654,6 +954,25 @@ bool Program::retrieveUniforms()
 
   delete [] uniformName;
 
+  const GLuint frameIndex = glGetUniformBlockIndex(m_programID, "wyFrame");
+  if (frameIndex != GL_INVALID_INDEX)
+  {
+    glUniformBlockBinding(m_programID, frameIndex, RenderContext::SHARED_FRAME_BLOCK);
+    m_sharedBlocks = true;
+  }
+
+  const GLuint objectIndex = glGetUniformBlockIndex(m_programID, "wyObject");
+  if (objectIndex != GL_INVALID_INDEX)
+  {
+    glUniformBlockBinding(m_programID, objectIndex, RenderContext::SHARED_OBJECT_BLOCK);
+    m_sharedBlocks = true;
+
+    // The block is std140, so all of its members are reported as active and
+    // the shader text is the only record of which inverses are used
+    m_objectInverses = std::max(m_vertexShader->m_objectInverses,
+                                m_fragmentShader->m_objectInverses);
+  }
+
   m_context.setProgram(nullptr);
 
   if (!checkGL("Failed to retrieve uniforms for program %s", name().c_str()))
@@ -709,20 +1028,6 @@ bool Program::retrieveAttributes()
   return true;
 }
 
-void Program::bind()
-{
-  glUseProgram(m_programID);
-
-  for (const Attribute& a : m_attributes)
-    glEnableVertexAttribArray(a.m_location);
-}
-
-void Program::unbind()
-{
-  for (const Attribute& a : m_attributes)
-    glDisableVertexAttribArray(a.m_location);
-}
-
 bool Program::isValid() const
 {
   glValidateProgram(m_programID);
@@ -786,6 +1091,9 @@ void ProgramInterface::addAttributes(const VertexFormat& format)
       case 4:
         type = ATTRIBUTE_VEC4;
         break;
+      case 16:
+        type = ATTRIBUTE_MAT4;
+        break;
       default:
         panic("Invalid vertex format component element count");
     }
@@ -880,7 +1188,8 @@ bool ProgramInterface::matches(const VertexFormat& format, bool verbose) const
     if ((component->elementCount() == 1 && a.second != ATTRIBUTE_FLOAT) ||
         (component->elementCount() == 2 && a.second != ATTRIBUTE_VEC2) ||
         (component->elementCount() == 3 && a.second != ATTRIBUTE_VEC3) ||
-        (component->elementCount() == 4 && a.second != ATTRIBUTE_VEC4))
+        (component->elementCount() == 4 && a.second != ATTRIBUTE_VEC4) ||
+        (component->elementCount() == 16 && a.second != ATTRIBUTE_MAT4))
     {
       return false;
     }
@@ -111,6 +111,8 @@ bool isColorAttachment(TextureFramebuffer::Attachment attachment)
 
 VertexBuffer::~VertexBuffer()
 {
+  m_context.removeVertexArrays(this);
+
   if (m_bufferID)
     glDeleteBuffers(1, &m_bufferID);
 
@@ -120,6 +122,10 @@ VertexBuffer::~VertexBuffer()
 
 void VertexBuffer::discard()
 {
+  // Stream storage may be immutable and is recycled by the context
+  if (m_stream)
+    return;
+
   m_context.setVertexBuffer(this);
 
   glBufferData(GL_ARRAY_BUFFER,
@@ -140,10 +146,20 @@ void VertexBuffer::copyFrom(const void* source, size_t sourceCount, size_t start
     return;
   }
 
-  m_context.setVertexBuffer(this);
-
   const size_t size = m_format.size();
-  glBufferSubData(GL_ARRAY_BUFFER, start * size, sourceCount * size, source);
+
+  if (m_stream)
+  {
+    if (!m_mapping)
+      m_context.setVertexBuffer(this);
+
+    writeStream(GL_ARRAY_BUFFER, m_mapping, start * size, sourceCount * size, source);
+  }
+  else
+  {
+    m_context.setVertexBuffer(this);
+    glBufferSubData(GL_ARRAY_BUFFER, start * size, sourceCount * size, source);
+  }
 
 #if WENDY_DEBUG
   checkGL("Error during copy to vertex buffer");
@@ -180,11 +196,25 @@ Ref<VertexBuffer> VertexBuffer::create(RenderContext& context,
   return buffer;
 }
 
+Ref<VertexBuffer> VertexBuffer::createStream(RenderContext& context,
+                                             size_t count,
+                                             const VertexFormat& format)
+{
+  Ref<VertexBuffer> buffer(new VertexBuffer(context));
+  buffer->m_stream = true;
+  if (!buffer->init(format, count, USAGE_STREAM))
+    return nullptr;
+
+  return buffer;
+}
+
 VertexBuffer::VertexBuffer(RenderContext& context):
   m_context(context),
   m_bufferID(0),
   m_count(0),
-  m_usage(USAGE_STATIC)
+  m_usage(USAGE_STATIC),
+  m_stream(false),
+  m_mapping(nullptr)
 {
 }
 
@@ -198,10 +228,15 @@ bool VertexBuffer::init(const VertexFormat& format, size_t count, BufferUsage us
 
   m_context.setVertexBuffer(this);
 
-  glBufferData(GL_ARRAY_BUFFER,
-               m_count * m_format.size(),
-               nullptr,
-               convertToGL(m_usage));
+  if (m_stream)
+    m_mapping = initStreamStorage(GL_ARRAY_BUFFER, size());
+  else
+  {
+    glBufferData(GL_ARRAY_BUFFER,
+                 m_count * m_format.size(),
+                 nullptr,
+                 convertToGL(m_usage));
+  }
 
   if (!checkGL("Error during creation of vertex buffer of format %s",
                stringCast(m_format).c_str()))
@@ -218,6 +253,8 @@ bool VertexBuffer::init(const VertexFormat& format, size_t count, BufferUsage us
 
 IndexBuffer::~IndexBuffer()
 {
+  m_context.removeVertexArrays(this);
+
   if (m_bufferID)
     glDeleteBuffers(1, &m_bufferID);
 
@@ -233,10 +270,20 @@ void IndexBuffer::copyFrom(const void* source, size_t sourceCount, size_t start)
     return;
   }
 
-  m_context.setIndexBuffer(this);
-
   const size_t size = typeSize(m_type);
-  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, start * size, sourceCount * size, source);
+
+  if (m_stream)
+  {
+    if (!m_mapping)
+      m_context.setIndexBuffer(this);
+
+    writeStream(GL_ELEMENT_ARRAY_BUFFER, m_mapping, start * size, sourceCount * size, source);
+  }
+  else
+  {
+    m_context.setIndexBuffer(this);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, start * size, sourceCount * size, source);
+  }
 
 #if WENDY_DEBUG
   checkGL("Error during copy to index buffer");
@@ -293,12 +340,26 @@ size_t IndexBuffer::typeSize(IndexType type)
   panic("Invalid index buffer type %u", type);
 }
 
+Ref<IndexBuffer> IndexBuffer::createStream(RenderContext& context,
+                                           size_t count,
+                                           IndexType type)
+{
+  Ref<IndexBuffer> buffer(new IndexBuffer(context));
+  buffer->m_stream = true;
+  if (!buffer->init(count, type, USAGE_STREAM))
+    return nullptr;
+
+  return buffer;
+}
+
 IndexBuffer::IndexBuffer(RenderContext& context):
   m_context(context),
   m_type(INDEX_UINT8),
   m_usage(USAGE_STATIC),
   m_bufferID(0),
-  m_count(0)
+  m_count(0),
+  m_stream(false),
+  m_mapping(nullptr)
 {
 }
 
@@ -312,10 +373,15 @@ bool IndexBuffer::init(size_t count, IndexType type, BufferUsage usage)
 
   m_context.setIndexBuffer(this);
 
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-               m_count * typeSize(m_type),
-               nullptr,
-               convertToGL(m_usage));
+  if (m_stream)
+    m_mapping = initStreamStorage(GL_ELEMENT_ARRAY_BUFFER, size());
+  else
+  {
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 m_count * typeSize(m_type),
+                 nullptr,
+                 convertToGL(m_usage));
+  }
 
   if (!checkGL("Error during creation of index buffer of element size %u",
                (uint) typeSize(m_type)))
@@ -580,7 +646,9 @@ WindowFramebuffer::WindowFramebuffer(RenderContext& context):
               getInteger(GL_BLUE_BITS)),
   m_depthBits(getInteger(GL_DEPTH_BITS)),
   m_stencilBits(getInteger(GL_STENCIL_BITS)),
-  m_samples(getInteger(GL_SAMPLES))
+  m_samples(getInteger(GL_SAMPLES)),
+  m_width(0),
+  m_height(0)
 {
 }
 
@@ -595,11 +663,17 @@ void WindowFramebuffer::apply() const
 
 uint WindowFramebuffer::width() const
 {
+  if (context().isHeadless())
+    return m_width;
+
   return context().window().width();
 }
 
 uint WindowFramebuffer::height() const
 {
+  if (context().isHeadless())
+    return m_height;
+
   return context().window().height();
 }
 
@@ -36,7 +36,11 @@
 #include <wendy/RenderContext.hpp>
 
 #define GREG_IMPLEMENTATION
+#if WENDY_USE_EGL
+#define GREG_USE_EGL
+#else
 #define GREG_USE_GLFW3
+#endif
 #include <GREG/greg.h>
 
 #include <internal/OpenGL.hpp>
@@ -46,7 +50,14 @@
 
 #include <GLFW/glfw3.h>
 
+#if WENDY_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
 
 namespace wendy
 {
@@ -111,10 +122,12 @@ const char* getMessageSeverityName(GLenum severity)
   return "UNKNOWN";
 }
 
+#if !WENDY_USE_EGL
 void errorCallback(int error, const char* message)
 {
   logError("GLFW reported error: %s", message);
 }
+#endif
 
 void GLAPIENTRY debugCallback(GLenum source,
                               GLenum type,
@@ -316,6 +329,8 @@ bool isCompatible(const Attribute& attribute, const VertexComponent& component)
       return component.elementCount() == 3;
     case ATTRIBUTE_VEC4:
       return component.elementCount() == 4;
+    case ATTRIBUTE_MAT4:
+      return component.elementCount() == 16;
   }
 
   return false;
@@ -329,6 +344,56 @@ void setBooleanState(uint state, bool value)
     glDisable(state);
 }
 
+/*! Contents of the wyFrame uniform block in std140 layout.
+ */
+struct SharedFrameBlock
+{
+  mat4 V;
+  mat4 P;
+  mat4 VP;
+  mat4 invV;
+  mat4 invP;
+  mat4 invVP;
+  vec3 cameraPosition;
+  float cameraNearZ;
+  float cameraFarZ;
+  float cameraAspectRatio;
+  float cameraFOV;
+  float viewportWidth;
+  float viewportHeight;
+  float time;
+  float padding[2];
+};
+
+/*! Contents of the wyObject uniform block in std140 layout.
+ */
+struct SharedObjectBlock
+{
+  mat4 M;
+  mat4 MV;
+  mat4 MVP;
+  mat4 invM;
+  mat4 invMV;
+  mat4 invMVP;
+};
+
+const size_t SHARED_BUFFER_SIZE = 1024 * 1024;
+
+const size_t UPLOAD_SECTION_SIZE = 4 * 1024 * 1024;
+
+const size_t STREAM_GRANULARITY = 16384;
+
+size_t streamSectionSize(size_t previousSize, size_t count)
+{
+  const size_t size = STREAM_GRANULARITY * ((count + STREAM_GRANULARITY - 1) / STREAM_GRANULARITY);
+  return std::max(size, previousSize * 2);
+}
+
+size_t alignSize(size_t size, size_t alignment)
+{
+  return (size + alignment - 1) / alignment * alignment;
+}
+
 } /*namespace (and Gandalf)*/
 
 RenderConfig::RenderConfig(uint colorBits,
@@ -382,6 +447,7 @@ RenderLimits::RenderLimits(RenderContext& context)
   maxTextureRectangleSize = getInteger(GL_MAX_RECTANGLE_TEXTURE_SIZE);
   maxTextureCoords = getInteger(GL_MAX_TEXTURE_COORDS);
   maxVertexAttributes = getInteger(GL_MAX_VERTEX_ATTRIBS);
+  uniformBufferOffsetAlignment = getInteger(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT);
 
   if (GREG_EXT_texture_filter_anisotropic)
     maxTextureAnisotropy = getFloat(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT);
@@ -433,31 +499,46 @@ void RenderStats::addStateChange()
   frame.stateChangeCount++;
 }
 
-void RenderStats::addPrimitives(PrimitiveType type, uint vertexCount)
+void RenderStats::addFlush()
+{
+  Frame& frame = m_frames.front();
+  frame.flushCount++;
+}
+
+void RenderStats::addSkippedCalls(uint uniformCount, uint textureCount)
+{
+  Frame& frame = m_frames.front();
+  frame.skippedUniformCount += uniformCount;
+  frame.skippedTextureCount += textureCount;
+}
+
+void RenderStats::addPrimitives(PrimitiveType type,
+                                uint vertexCount,
+                                uint instanceCount)
 {
   Frame& frame = m_frames.front();
-  frame.vertexCount += vertexCount;
+  frame.vertexCount += vertexCount * instanceCount;
   frame.operationCount++;
 
   switch (type)
   {
     case POINT_LIST:
-      frame.pointCount += vertexCount;
+      frame.pointCount += vertexCount * instanceCount;
       break;
     case LINE_LIST:
-      frame.lineCount += vertexCount / 2;
+      frame.lineCount += vertexCount / 2 * instanceCount;
       break;
     case LINE_STRIP:
-      frame.lineCount += vertexCount - 1;
+      frame.lineCount += (vertexCount - 1) * instanceCount;
       break;
     case TRIANGLE_LIST:
-      frame.triangleCount += vertexCount / 3;
+      frame.triangleCount += vertexCount / 3 * instanceCount;
       break;
     case TRIANGLE_STRIP:
-      frame.triangleCount += vertexCount - 2;
+      frame.triangleCount += (vertexCount - 2) * instanceCount;
       break;
     case TRIANGLE_FAN:
-      frame.triangleCount += vertexCount - 2;
+      frame.triangleCount += (vertexCount - 2) * instanceCount;
       break;
     default:
       panic("Invalid primitive type %u", type);
@@ -512,6 +593,9 @@ void RenderStats::removeProgram()
 
 RenderStats::Frame::Frame():
   stateChangeCount(0),
+  flushCount(0),
+  skippedUniformCount(0),
+  skippedTextureCount(0),
   operationCount(0),
   vertexCount(0),
   pointCount(0),
@@ -531,6 +615,8 @@ SharedProgramState::SharedProgramState():
   m_dirtyInvModelView(true),
   m_dirtyInvViewProj(true),
   m_dirtyInvModelViewProj(true),
+  m_frameRevision(1),
+  m_objectRevision(1),
   m_cameraNearZ(0.f),
   m_cameraFarZ(0.f),
   m_cameraAspect(0.f),
@@ -559,6 +645,7 @@ void SharedProgramState::setModelMatrix(const mat4& newMatrix)
   m_modelMatrix = newMatrix;
   m_dirtyModelView = m_dirtyModelViewProj = true;
   m_dirtyInvModel = m_dirtyInvModelView = m_dirtyInvModelViewProj = true;
+  m_objectRevision++;
 }
 
 void SharedProgramState::setViewMatrix(const mat4& newMatrix)
@@ -566,6 +653,8 @@ void SharedProgramState::setViewMatrix(const mat4& newMatrix)
   m_viewMatrix = newMatrix;
   m_dirtyModelView = m_dirtyViewProj = m_dirtyModelViewProj = true;
   m_dirtyInvView = m_dirtyInvModelView = m_dirtyInvViewProj = m_dirtyInvModelViewProj = true;
+  m_frameRevision++;
+  m_objectRevision++;
 }
 
 void SharedProgramState::setProjectionMatrix(const mat4& newMatrix)
@@ -573,6 +662,8 @@ void SharedProgramState::setProjectionMatrix(const mat4& newMatrix)
   m_projectionMatrix = newMatrix;
   m_dirtyViewProj = m_dirtyModelViewProj = true;
   m_dirtyInvProj = m_dirtyInvViewProj = m_dirtyInvModelViewProj = true;
+  m_frameRevision++;
+  m_objectRevision++;
 }
 
 void SharedProgramState::setOrthoProjectionMatrix(float width, float height)
@@ -609,17 +700,20 @@ void SharedProgramState::setCameraProperties(const vec3& position,
   m_cameraAspect = aspect;
   m_cameraNearZ = nearZ;
   m_cameraFarZ = farZ;
+  m_frameRevision++;
 }
 
 void SharedProgramState::setViewportSize(float newWidth, float newHeight)
 {
   m_viewportWidth = newWidth;
   m_viewportHeight = newHeight;
+  m_frameRevision++;
 }
 
 void SharedProgramState::setTime(float newTime)
 {
   m_time = newTime;
+  m_frameRevision++;
 }
 
 void SharedProgramState::updateTo(Uniform& uniform)
@@ -646,147 +740,55 @@ void SharedProgramState::updateTo(Uniform& uniform)
 
     case SHARED_MODELVIEW_MATRIX:
     {
-      if (m_dirtyModelView)
-      {
-        m_modelViewMatrix = m_viewMatrix;
-        m_modelViewMatrix *= m_modelMatrix;
-        m_dirtyModelView = false;
-      }
-
-      uniform.copyFrom(value_ptr(m_modelViewMatrix));
+      uniform.copyFrom(value_ptr(modelViewMatrix()));
       return;
     }
 
     case SHARED_VIEWPROJECTION_MATRIX:
     {
-      if (m_dirtyViewProj)
-      {
-        m_viewProjMatrix = m_projectionMatrix;
-        m_viewProjMatrix *= m_viewMatrix;
-        m_dirtyViewProj = false;
-      }
-
-      uniform.copyFrom(value_ptr(m_viewProjMatrix));
+      uniform.copyFrom(value_ptr(viewProjMatrix()));
       return;
     }
 
     case SHARED_MODELVIEWPROJECTION_MATRIX:
     {
-      if (m_dirtyModelViewProj)
-      {
-        if (m_dirtyViewProj)
-        {
-          m_viewProjMatrix = m_projectionMatrix;
-          m_viewProjMatrix *= m_viewMatrix;
-          m_dirtyViewProj = false;
-        }
-
-        m_modelViewProjMatrix = m_viewProjMatrix;
-        m_modelViewProjMatrix *= m_modelMatrix;
-        m_dirtyModelViewProj = false;
-      }
-
-      uniform.copyFrom(value_ptr(m_modelViewProjMatrix));
+      uniform.copyFrom(value_ptr(modelViewProjMatrix()));
       return;
     }
 
     case SHARED_INVERSE_MODEL_MATRIX:
     {
-      if (m_dirtyInvModel)
-      {
-        m_invModelMatrix = inverse(m_modelMatrix);
-        m_dirtyInvModel = false;
-      }
-
-      uniform.copyFrom(value_ptr(m_invModelMatrix));
+      uniform.copyFrom(value_ptr(invModelMatrix()));
       return;
     }
 
     case SHARED_INVERSE_VIEW_MATRIX:
     {
-      if (m_dirtyInvView)
-      {
-        m_invViewMatrix = inverse(m_viewMatrix);
-        m_dirtyInvView = false;
-      }
-
-      uniform.copyFrom(value_ptr(m_invViewMatrix));
+      uniform.copyFrom(value_ptr(invViewMatrix()));
       return;
     }
 
     case SHARED_INVERSE_PROJECTION_MATRIX:
     {
-      if (m_dirtyInvProj)
-      {
-        m_invProjMatrix = inverse(m_projectionMatrix);
-        m_dirtyInvProj = false;
-      }
-
-      uniform.copyFrom(value_ptr(m_invProjMatrix));
+      uniform.copyFrom(value_ptr(invProjMatrix()));
       return;
     }
 
     case SHARED_INVERSE_MODELVIEW_MATRIX:
     {
-      if (m_dirtyInvModelView)
-      {
-        if (m_dirtyModelView)
-        {
-          m_modelViewMatrix = m_viewMatrix;
-          m_modelViewMatrix *= m_modelMatrix;
-          m_dirtyModelView = false;
-        }
-
-        m_invModelViewMatrix = inverse(m_modelViewMatrix);
-        m_dirtyInvModelView = false;
-      }
-
-      uniform.copyFrom(value_ptr(m_invModelViewMatrix));
+      uniform.copyFrom(value_ptr(invModelViewMatrix()));
       return;
     }
 
     case SHARED_INVERSE_VIEWPROJECTION_MATRIX:
     {
-      if (m_dirtyInvViewProj)
-      {
-        if (m_dirtyViewProj)
-        {
-          m_viewProjMatrix = m_projectionMatrix;
-          m_viewProjMatrix *= m_viewMatrix;
-          m_dirtyViewProj = false;
-        }
-
-        m_invViewProjMatrix = inverse(m_viewProjMatrix);
-        m_dirtyInvViewProj = false;
-      }
-
-      uniform.copyFrom(value_ptr(m_invViewProjMatrix));
+      uniform.copyFrom(value_ptr(invViewProjMatrix()));
       return;
     }
 
     case SHARED_INVERSE_MODELVIEWPROJECTION_MATRIX:
     {
-      if (m_dirtyInvModelViewProj)
-      {
-        if (m_dirtyModelViewProj)
-        {
-          if (m_dirtyViewProj)
-          {
-            m_viewProjMatrix = m_projectionMatrix;
-            m_viewProjMatrix *= m_viewMatrix;
-            m_dirtyViewProj = false;
-          }
-
-          m_modelViewProjMatrix = m_viewProjMatrix;
-          m_modelViewProjMatrix *= m_modelMatrix;
-          m_dirtyModelViewProj = false;
-        }
-
-        m_invModelViewProjMatrix = inverse(m_modelViewProjMatrix);
-        m_dirtyInvModelViewProj = false;
-      }
-
-      uniform.copyFrom(value_ptr(m_invModelViewProjMatrix));
+      uniform.copyFrom(value_ptr(invModelViewProjMatrix()));
       return;
     }
 
@@ -843,6 +845,108 @@ void SharedProgramState::updateTo(Uniform& uniform)
            uniform.name().c_str());
 }
 
+const mat4& SharedProgramState::modelViewMatrix()
+{
+  if (m_dirtyModelView)
+  {
+    m_modelViewMatrix = m_viewMatrix;
+    m_modelViewMatrix *= m_modelMatrix;
+    m_dirtyModelView = false;
+  }
+
+  return m_modelViewMatrix;
+}
+
+const mat4& SharedProgramState::viewProjMatrix()
+{
+  if (m_dirtyViewProj)
+  {
+    m_viewProjMatrix = m_projectionMatrix;
+    m_viewProjMatrix *= m_viewMatrix;
+    m_dirtyViewProj = false;
+  }
+
+  return m_viewProjMatrix;
+}
+
+const mat4& SharedProgramState::modelViewProjMatrix()
+{
+  if (m_dirtyModelViewProj)
+  {
+    m_modelViewProjMatrix = viewProjMatrix();
+    m_modelViewProjMatrix *= m_modelMatrix;
+    m_dirtyModelViewProj = false;
+  }
+
+  return m_modelViewProjMatrix;
+}
+
+const mat4& SharedProgramState::invModelMatrix()
+{
+  if (m_dirtyInvModel)
+  {
+    m_invModelMatrix = inverse(m_modelMatrix);
+    m_dirtyInvModel = false;
+  }
+
+  return m_invModelMatrix;
+}
+
+const mat4& SharedProgramState::invViewMatrix()
+{
+  if (m_dirtyInvView)
+  {
+    m_invViewMatrix = inverse(m_viewMatrix);
+    m_dirtyInvView = false;
+  }
+
+  return m_invViewMatrix;
+}
+
+const mat4& SharedProgramState::invProjMatrix()
+{
+  if (m_dirtyInvProj)
+  {
+    m_invProjMatrix = inverse(m_projectionMatrix);
+    m_dirtyInvProj = false;
+  }
+
+  return m_invProjMatrix;
+}
+
+const mat4& SharedProgramState::invModelViewMatrix()
+{
+  if (m_dirtyInvModelView)
+  {
+    m_invModelViewMatrix = inverse(modelViewMatrix());
+    m_dirtyInvModelView = false;
+  }
+
+  return m_invModelViewMatrix;
+}
+
+const mat4& SharedProgramState::invViewProjMatrix()
+{
+  if (m_dirtyInvViewProj)
+  {
+    m_invViewProjMatrix = inverse(viewProjMatrix());
+    m_dirtyInvViewProj = false;
+  }
+
+  return m_invViewProjMatrix;
+}
+
+const mat4& SharedProgramState::invModelViewProjMatrix()
+{
+  if (m_dirtyInvModelViewProj)
+  {
+    m_invModelViewProjMatrix = inverse(modelViewProjMatrix());
+    m_dirtyInvModelViewProj = false;
+  }
+
+  return m_invModelViewProjMatrix;
+}
+
 class RenderContext::SharedUniform
 {
 public:
@@ -859,17 +963,51 @@ public:
 
 RenderContext::~RenderContext()
 {
-  m_framebuffer = nullptr;
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  // Only touch GL state if initialization got far enough to have any
+  if (m_windowFramebuffer)
+  {
+    m_framebuffer = nullptr;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-  setVertexBuffer(nullptr);
-  setIndexBuffer(nullptr);
-  setProgram(nullptr);
+    setVertexBuffer(nullptr);
+    setIndexBuffer(nullptr);
+    setProgram(nullptr);
 
-  for (uint i = 0;  i < m_textureUnits.size();  i++)
-  {
-    setTextureUnit(i);
-    setTexture(nullptr);
+    for (uint i = 0;  i < m_textureUnits.size();  i++)
+    {
+      setTextureUnit(i);
+      setTexture(nullptr);
+    }
+
+    for (Stream& s : m_vertexStreams)
+      destroyStream(s);
+    for (Stream& s : m_indexStreams)
+      destroyStream(s);
+    for (Stream& s : m_retiredStreams)
+      destroyStream(s);
+
+    m_vertexStreams.clear();
+    m_indexStreams.clear();
+    m_retiredStreams.clear();
+
+    glBindVertexArray(0);
+    m_vertexArray = nullptr;
+
+    for (auto& a : m_vertexArrays)
+      glDeleteVertexArrays(1, &(a.second.arrayID));
+
+    m_vertexArrays.clear();
+
+    if (m_sharedBufferID)
+      glDeleteBuffers(1, &m_sharedBufferID);
+
+    m_uploads.clear();
+
+    if (m_uploadBufferID)
+    {
+      destroyStream(m_uploadStream);
+      glDeleteBuffers(1, &m_uploadBufferID);
+    }
   }
 
   if (m_handle)
@@ -877,6 +1015,21 @@ RenderContext::~RenderContext()
     glfwDestroyWindow(m_handle);
     m_handle = nullptr;
   }
+
+#if WENDY_USE_EGL
+  if (m_display)
+  {
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if (m_context)
+      eglDestroyContext(m_display, m_context);
+    if (m_surface)
+      eglDestroySurface(m_display, m_surface);
+
+    eglTerminate(m_display);
+    m_display = nullptr;
+  }
+#endif
 }
 
 void RenderContext::clearColorBuffer(const vec4& color)
@@ -957,15 +1110,61 @@ void RenderContext::render(const PrimitiveRange& range)
     return;
   }
 
-  setVertexBuffer(range.vertexBuffer());
-  setIndexBuffer(range.indexBuffer());
+  draw(range.vertexBuffer(),
+       range.indexBuffer(),
+       range.type(),
+       range.start(),
+       range.count(),
+       range.base(),
+       1);
+}
+
+void RenderContext::render(const PrimitiveRange& range, const VertexRange& instances)
+{
+  if (range.isEmpty())
+  {
+    logWarning("Rendering empty primitive range with shader program %s",
+               m_program->name().c_str());
+    return;
+  }
+
+  if (instances.isEmpty())
+    return;
 
-  render(range.type(), range.start(), range.count(), range.base());
+  if (!isInstancingSupported())
+  {
+    logError("Cannot render instances without support for instanced arrays");
+    return;
+  }
+
+  m_instanceBuffer = instances.vertexBuffer();
+  m_instanceStart = instances.start();
+
+  draw(range.vertexBuffer(),
+       range.indexBuffer(),
+       range.type(),
+       range.start(),
+       range.count(),
+       range.base(),
+       instances.count());
+
+  m_instanceBuffer = nullptr;
 }
 
 void RenderContext::render(PrimitiveType type, uint start, uint count, uint base)
 {
-  ProfileNodeCall call("RenderContext::render");
+  draw(m_vertexBuffer, m_indexBuffer, type, start, count, base, 1);
+}
+
+void RenderContext::draw(VertexBuffer* vertexBuffer,
+                         IndexBuffer* indexBuffer,
+                         PrimitiveType type,
+                         uint start,
+                         uint count,
+                         uint base,
+                         uint instanceCount)
+{
+  WENDY_PROFILE_ZONE("RenderContext::render");
 
   if (!m_program)
   {
@@ -973,70 +1172,480 @@ void RenderContext::render(PrimitiveType type, uint start, uint count, uint base
     return;
   }
 
-  if (!m_vertexBuffer)
+  if (!vertexBuffer)
   {
     logError("Cannot render without a current vertex buffer");
     return;
   }
 
-  if (m_dirtyBinding)
+  const VertexArray* array = setVertexArray(*vertexBuffer, indexBuffer);
+  if (!array)
+    return;
+
+  if (m_program->m_sharedBlocks && m_sharedProgramState)
+    updateSharedBlocks();
+
+  if (m_instanceBuffer)
   {
-    const VertexFormat& format = m_vertexBuffer->format();
+    const size_t stride = m_instanceBuffer->format().size();
+
+    setVertexBuffer(m_instanceBuffer);
+
+    for (auto& a : array->instanceAttributes)
+      a.first->bind(stride, stride * m_instanceStart + a.second, true);
+  }
 
-    if (m_program->attributeCount() > format.components().size())
+  if (array->instanceTransform)
+  {
+    if (m_sharedProgramState)
+      array->instanceTransform->setValue(value_ptr(m_sharedProgramState->modelMatrix()));
+    else
+      array->instanceTransform->setValue(value_ptr(mat4(1.f)));
+  }
+
+#if WENDY_DEBUG
+  if (!m_program->isValid())
+    return;
+#endif
+
+  if (indexBuffer)
+  {
+    const size_t size = IndexBuffer::typeSize(indexBuffer->type());
+
+    if (m_instanceBuffer)
     {
-      logError("Shader program %s has more attributes than vertex format has components",
-               m_program->name().c_str());
-      return;
+      glDrawElementsInstancedBaseVertex(convertToGL(type),
+                                        count,
+                                        convertToGL(indexBuffer->type()),
+                                        (GLvoid*) (size * start),
+                                        instanceCount,
+                                        base);
     }
-
-    for (size_t i = 0;  i < m_program->attributeCount();  i++)
+    else
     {
-      Attribute& attribute = m_program->attribute(i);
+      glDrawElementsBaseVertex(convertToGL(type),
+                               count,
+                               convertToGL(indexBuffer->type()),
+                               (GLvoid*) (size * start),
+                               base);
+    }
+  }
+  else
+  {
+    if (m_instanceBuffer)
+      glDrawArraysInstanced(convertToGL(type), start, count, instanceCount);
+    else
+      glDrawArrays(convertToGL(type), start, count);
+  }
 
-      const VertexComponent* component = format.findComponent(attribute.name().c_str());
-      if (!component)
-      {
-        logError("Attribute %s of program %s has no corresponding vertex format component",
-                 attribute.name().c_str(),
-                 m_program->name().c_str());
-        return;
-      }
+  if (m_stats)
+    m_stats->addPrimitives(type, count, instanceCount);
+}
+
+size_t RenderContext::VertexArrayKeyHash::operator () (const VertexArrayKey& key) const
+{
+  std::hash<const void*> hasher;
+
+  size_t hash = hasher(key.program);
+  hash = hash * 31 + hasher(key.vertexBuffer);
+  hash = hash * 31 + hasher(key.indexBuffer);
+  hash = hash * 31 + hasher(key.instanceBuffer);
+  return hash;
+}
+
+const RenderContext::VertexArray* RenderContext::setVertexArray(VertexBuffer& vertexBuffer,
+                                                                IndexBuffer* indexBuffer)
+{
+  VertexArrayKey key;
+  key.program = m_program;
+  key.vertexBuffer = &vertexBuffer;
+  key.indexBuffer = indexBuffer;
+  key.instanceBuffer = m_instanceBuffer;
+
+  if (m_vertexArray && m_vertexArray->key == key)
+    return m_vertexArray;
+
+  auto entry = m_vertexArrays.find(key);
+  if (entry != m_vertexArrays.end())
+  {
+    m_vertexArray = &(entry->second);
+    glBindVertexArray(m_vertexArray->arrayID);
+    return m_vertexArray;
+  }
+
+  VertexArray array;
+  array.key = key;
+  array.instanceTransform = nullptr;
+
+  glGenVertexArrays(1, &array.arrayID);
+  glBindVertexArray(array.arrayID);
+
+  if (!initVertexArray(array, vertexBuffer, indexBuffer))
+  {
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &array.arrayID);
+    m_vertexArray = nullptr;
+    return nullptr;
+  }
+
+  m_vertexArray = &(m_vertexArrays[key] = array);
+  return m_vertexArray;
+}
+
+bool RenderContext::initVertexArray(VertexArray& array,
+                                    VertexBuffer& vertexBuffer,
+                                    IndexBuffer* indexBuffer)
+{
+  if (indexBuffer)
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer->m_bufferID);
+
+  setVertexBuffer(&vertexBuffer);
 
+  const VertexFormat& format = vertexBuffer.format();
+
+  for (size_t i = 0;  i < m_program->attributeCount();  i++)
+  {
+    Attribute& attribute = m_program->attribute(i);
+
+    const VertexComponent* component = format.findComponent(attribute.name().c_str());
+    if (component)
+    {
       if (!isCompatible(attribute, *component))
       {
         logError("Attribute %s of shader program %s has incompatible type",
                  attribute.name().c_str(),
                  m_program->name().c_str());
-        return;
+        return false;
+      }
+
+      attribute.bind(format.size(), component->offset(), component->isInstanced());
+      continue;
+    }
+
+    // Instance attributes are bound per draw, as the instance range moves
+    if (m_instanceBuffer)
+    {
+      component = m_instanceBuffer->format().findComponent(attribute.name().c_str());
+      if (component)
+      {
+        if (!isCompatible(attribute, *component))
+        {
+          logError("Attribute %s of shader program %s has incompatible type",
+                   attribute.name().c_str(),
+                   m_program->name().c_str());
+          return false;
+        }
+
+        array.instanceAttributes.push_back(std::make_pair(&attribute, component->offset()));
+        continue;
       }
+    }
 
-      attribute.bind(format.size(), component->offset());
+    // Programs using the instance transform convention can still be used
+    // for single draws, with the current model matrix as a constant value
+    if (attribute.type() == ATTRIBUTE_MAT4 && attribute.name() == "wyInstanceM")
+    {
+      array.instanceTransform = &attribute;
+      continue;
     }
 
-    m_dirtyBinding = false;
+    logError("Attribute %s of program %s has no corresponding vertex format component",
+             attribute.name().c_str(),
+             m_program->name().c_str());
+    return false;
   }
 
-#if WENDY_DEBUG
-  if (!m_program->isValid())
+  if (!checkGL("Failed to set up vertex array for program %s", m_program->name().c_str()))
+    return false;
+
+  return true;
+}
+
+void RenderContext::removeVertexArrays(const void* object)
+{
+  auto a = m_vertexArrays.begin();
+
+  while (a != m_vertexArrays.end())
+  {
+    const VertexArrayKey& key = a->first;
+
+    if (key.program == object ||
+        key.vertexBuffer == object ||
+        key.indexBuffer == object ||
+        key.instanceBuffer == object)
+    {
+      if (m_vertexArray == &(a->second))
+      {
+        glBindVertexArray(0);
+        m_vertexArray = nullptr;
+      }
+
+      glDeleteVertexArrays(1, &(a->second.arrayID));
+      a = m_vertexArrays.erase(a);
+    }
+    else
+      a++;
+  }
+}
+
+RenderContext::Stream RenderContext::createStream(size_t sectionSize)
+{
+  Stream stream;
+  stream.sectionSize = sectionSize;
+  stream.head = 0;
+  stream.section = 0;
+
+  for (uint i = 0;  i < STREAM_SECTIONS;  i++)
+  {
+    stream.frames[i] = m_frame - 1;
+    stream.fences[i] = nullptr;
+  }
+
+  return stream;
+}
+
+bool RenderContext::reserve(Stream& stream, size_t count)
+{
+  if (count > stream.sectionSize)
+    return false;
+
+  if (stream.head + count > (stream.section + 1) * stream.sectionSize)
+  {
+    const uint next = (stream.section + 1) % STREAM_SECTIONS;
+
+    // Ranges allocated during this frame may not have been rendered yet
+    if (stream.frames[next] == m_frame)
+      return false;
+
+    if (GLsync fence = (GLsync) stream.fences[next])
+    {
+      GLenum result;
+
+      do
+      {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+      }
+      while (result == GL_TIMEOUT_EXPIRED);
+
+      glDeleteSync(fence);
+      stream.fences[next] = nullptr;
+    }
+
+    stream.section = next;
+    stream.head = next * stream.sectionSize;
+  }
+
+  stream.frames[stream.section] = m_frame;
+  return true;
+}
+
+void RenderContext::fenceStream(Stream& stream)
+{
+  for (uint i = 0;  i < STREAM_SECTIONS;  i++)
+  {
+    if (stream.frames[i] != m_frame)
+      continue;
+
+    // The new fence also covers anything the old one did
+    if (stream.fences[i])
+      glDeleteSync((GLsync) stream.fences[i]);
+
+    stream.fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+}
+
+void RenderContext::destroyStream(Stream& stream)
+{
+  for (uint i = 0;  i < STREAM_SECTIONS;  i++)
+  {
+    if (stream.fences[i])
+    {
+      glDeleteSync((GLsync) stream.fences[i]);
+      stream.fences[i] = nullptr;
+    }
+  }
+
+  stream.vertexBuffer = nullptr;
+  stream.indexBuffer = nullptr;
+}
+
+void RenderContext::processUploads()
+{
+  if (m_uploads.empty())
     return;
-#endif
 
-  if (m_indexBuffer)
+  WENDY_PROFILE_ZONE("RenderContext::processUploads");
+
+  size_t budget = m_uploadBudget;
+  bool started = false;
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBufferID);
+
+  while (!m_uploads.empty())
   {
-    const size_t size = IndexBuffer::typeSize(m_indexBuffer->type());
+    Upload& upload = m_uploads.front();
+    Texture& texture = *upload.texture;
+    const Image& image = *upload.image;
+
+    const size_t rowSize = image.format().size() * image.width();
+    const char* source = (const char*) image.pixels() + upload.row * rowSize;
+
+    uint rowCount = min(image.height() - upload.row,
+                        uint(min(max(budget, rowSize),
+                                 m_uploadStream.sectionSize) / rowSize));
+
+    // Keep offsets aligned for any component type of the next texture
+    m_uploadStream.head = alignSize(m_uploadStream.head, 16);
+
+    bool success;
+
+    if (rowCount && reserve(m_uploadStream, rowCount * rowSize))
+    {
+      writeStream(GL_PIXEL_UNPACK_BUFFER, m_uploadMapping,
+                  m_uploadStream.head, rowCount * rowSize, source);
+
+      // Texel pointers are offsets into the bound unpack buffer
+      const TextureData data(image.format(), image.width(), rowCount, 1,
+                             (const void*) m_uploadStream.head);
+
+      success = texture.copyFrom(TextureImage(), data, 0, upload.row);
+      m_uploadStream.head += rowCount * rowSize;
+    }
+    else if (!started)
+    {
+      // Rows too large for the staging buffer are copied directly, one per
+      // frame, so that every upload keeps making progress
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+      rowCount = 1;
+      success = texture.copyFrom(TextureImage(),
+                                 TextureData(image.format(), image.width(), 1, 1, source),
+                                 0, upload.row);
 
-    glDrawElementsBaseVertex(convertToGL(type),
-                             count,
-                             convertToGL(m_indexBuffer->type()),
-                             (GLvoid*) (size * start),
-                             base);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBufferID);
+    }
+    else
+      break;
+
+    budget -= min(budget, rowCount * rowSize);
+    started = true;
+
+    if (!success)
+    {
+      // The remaining rows would most likely fail the same way
+      logError("Failed to stream rows %u to %u of texture %s",
+               upload.row,
+               upload.row + rowCount - 1,
+               texture.name().c_str());
+
+      texture.m_streaming = false;
+      m_uploads.pop_front();
+    }
+    else
+    {
+      upload.row += rowCount;
+
+      if (upload.row == image.height())
+      {
+        if (texture.m_params.flags & TF_MIPMAPPED)
+          texture.generateMipmaps();
+
+        texture.m_streaming = false;
+        m_uploads.pop_front();
+      }
+    }
+
+    if (!budget)
+      break;
   }
-  else
-    glDrawArrays(convertToGL(type), start, count);
 
-  if (m_stats)
-    m_stats->addPrimitives(type, count);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void RenderContext::updateSharedBlocks()
+{
+  SharedProgramState& state = *m_sharedProgramState;
+
+  // Inverses no program has asked for are neither computed nor uploaded, so
+  // the block is rewritten if this program uses one the last write left out
+  const uint inverses = m_program->m_objectInverses;
+
+  bool dirtyFrame = m_frameRevision != state.m_frameRevision;
+  bool dirtyObject = m_objectRevision != state.m_objectRevision ||
+                     m_objectInverses < inverses;
+  if (!dirtyFrame && !dirtyObject)
+    return;
+
+  const size_t alignment = m_limits->uniformBufferOffsetAlignment;
+  const size_t frameSize = alignSize(sizeof(SharedFrameBlock), alignment);
+  const size_t objectSize = alignSize(sizeof(SharedObjectBlock), alignment);
+
+  size_t required = 0;
+  if (dirtyFrame)
+    required += frameSize;
+  if (dirtyObject)
+    required += objectSize;
+
+  if (m_sharedBufferOffset + required > SHARED_BUFFER_SIZE)
+  {
+    // Orphan the old storage, which may still be read by pending draws, and
+    // rewrite both blocks as their bound ranges now refer to the new storage
+    glBufferData(GL_UNIFORM_BUFFER, SHARED_BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+    m_sharedBufferOffset = 0;
+    dirtyFrame = dirtyObject = true;
+  }
+
+  if (dirtyFrame)
+  {
+    SharedFrameBlock block;
+    block.V = state.m_viewMatrix;
+    block.P = state.m_projectionMatrix;
+    block.VP = state.viewProjMatrix();
+    block.invV = state.invViewMatrix();
+    block.invP = state.invProjMatrix();
+    block.invVP = state.invViewProjMatrix();
+    block.cameraPosition = state.m_cameraPos;
+    block.cameraNearZ = state.m_cameraNearZ;
+    block.cameraFarZ = state.m_cameraFarZ;
+    block.cameraAspectRatio = state.m_cameraAspect;
+    block.cameraFOV = state.m_cameraFOV;
+    block.viewportWidth = state.m_viewportWidth;
+    block.viewportHeight = state.m_viewportHeight;
+    block.time = state.m_time;
+
+    glBufferSubData(GL_UNIFORM_BUFFER, m_sharedBufferOffset, sizeof(block), &block);
+    glBindBufferRange(GL_UNIFORM_BUFFER, SHARED_FRAME_BLOCK, m_sharedBufferID,
+                      m_sharedBufferOffset, sizeof(block));
+
+    m_sharedBufferOffset += frameSize;
+    m_frameRevision = state.m_frameRevision;
+  }
+
+  if (dirtyObject)
+  {
+    SharedObjectBlock block;
+    block.M = state.m_modelMatrix;
+    block.MV = state.modelViewMatrix();
+    block.MVP = state.modelViewProjMatrix();
+    if (inverses > 0)
+      block.invM = state.invModelMatrix();
+    if (inverses > 1)
+      block.invMV = state.invModelViewMatrix();
+    if (inverses > 2)
+      block.invMVP = state.invModelViewProjMatrix();
+
+    // The whole block is bound, but the trailing inverses this program does
+    // not use are left as they were
+    const size_t size = offsetof(SharedObjectBlock, invM) + inverses * sizeof(mat4);
+
+    glBufferSubData(GL_UNIFORM_BUFFER, m_sharedBufferOffset, size, &block);
+    glBindBufferRange(GL_UNIFORM_BUFFER, SHARED_OBJECT_BLOCK, m_sharedBufferID,
+                      m_sharedBufferOffset, sizeof(block));
+
+    m_sharedBufferOffset += objectSize;
+    m_objectRevision = state.m_objectRevision;
+    m_objectInverses = inverses;
+  }
 }
 
 VertexRange RenderContext::allocateVertices(uint count, const VertexFormat& format)
@@ -1044,48 +1653,99 @@ VertexRange RenderContext::allocateVertices(uint count, const VertexFormat& form
   if (!count)
     return VertexRange();
 
-  Slot* slot = nullptr;
+  Stream* stream = nullptr;
 
-  for (Slot& s : m_slots)
+  for (Stream& s : m_vertexStreams)
   {
-    if (s.buffer->format() == format && s.available >= count)
+    if (s.vertexBuffer->format() == format)
     {
-      slot = &s;
+      stream = &s;
       break;
     }
   }
 
-  if (!slot)
+  if (!stream || !reserve(*stream, count))
   {
-    m_slots.push_back(Slot());
-    slot = &(m_slots.back());
+    const size_t previousSize = stream ? stream->sectionSize : 0;
+    Stream replacement = createStream(streamSectionSize(previousSize, count));
+    const size_t size = replacement.sectionSize * STREAM_SECTIONS;
 
-    const size_t granularity = 16384;
+    replacement.vertexBuffer = VertexBuffer::createStream(*this, size, format);
+    if (!replacement.vertexBuffer)
+      return VertexRange();
 
-    const uint actualCount = granularity * ((count + granularity - 1) / granularity);
+    log("Allocated vertex stream of size %u format %s",
+        (uint) replacement.vertexBuffer->count(),
+        stringCast(format).c_str());
 
-    slot->buffer = VertexBuffer::create(*this,
-                                        actualCount,
-                                        format,
-                                        USAGE_DYNAMIC);
-    if (!slot->buffer)
+    if (stream)
     {
-      m_slots.pop_back();
-      return VertexRange();
+      m_retiredStreams.push_back(*stream);
+      *stream = replacement;
+    }
+    else
+    {
+      m_vertexStreams.push_back(replacement);
+      stream = &(m_vertexStreams.back());
     }
 
-    log("Allocated vertex pool of size %u format %s",
-        actualCount,
-        stringCast(format).c_str());
+    reserve(*stream, count);
+  }
 
-    slot->available = slot->buffer->count();
+  const size_t start = stream->head;
+  stream->head += count;
+
+  return VertexRange(*(stream->vertexBuffer), start, count);
+}
+
+IndexRange RenderContext::allocateIndices(uint count, IndexType type)
+{
+  if (!count)
+    return IndexRange();
+
+  Stream* stream = nullptr;
+
+  for (Stream& s : m_indexStreams)
+  {
+    if (s.indexBuffer->type() == type)
+    {
+      stream = &s;
+      break;
+    }
   }
 
-  const uint start = slot->buffer->count() - slot->available;
+  if (!stream || !reserve(*stream, count))
+  {
+    const size_t previousSize = stream ? stream->sectionSize : 0;
+    Stream replacement = createStream(streamSectionSize(previousSize, count));
+    const size_t size = replacement.sectionSize * STREAM_SECTIONS;
+
+    replacement.indexBuffer = IndexBuffer::createStream(*this, size, type);
+    if (!replacement.indexBuffer)
+      return IndexRange();
+
+    log("Allocated index stream of size %u element size %u",
+        (uint) replacement.indexBuffer->count(),
+        (uint) IndexBuffer::typeSize(type));
+
+    if (stream)
+    {
+      m_retiredStreams.push_back(*stream);
+      *stream = replacement;
+    }
+    else
+    {
+      m_indexStreams.push_back(replacement);
+      stream = &(m_indexStreams.back());
+    }
+
+    reserve(*stream, count);
+  }
 
-  slot->available -= count;
+  const size_t start = stream->head;
+  stream->head += count;
 
-  return VertexRange(*(slot->buffer), start, count);
+  return IndexRange(*(stream->indexBuffer), start, count);
 }
 
 void RenderContext::createSharedUniform(const char* name, UniformType type, int ID)
@@ -1119,6 +1779,8 @@ SharedProgramState* RenderContext::sharedProgramState() const
 void RenderContext::setSharedProgramState(SharedProgramState* newState)
 {
   m_sharedProgramState = newState;
+  m_frameRevision = m_objectRevision = 0;
+  m_objectInverses = 0;
 }
 
 const char* RenderContext::sharedProgramStateDeclaration() const
@@ -1126,6 +1788,11 @@ const char* RenderContext::sharedProgramStateDeclaration() const
   return m_declaration.c_str();
 }
 
+bool RenderContext::isInstancingSupported() const
+{
+  return GREG_ARB_instanced_arrays != 0;
+}
+
 int RenderContext::swapInterval() const
 {
   return m_swapInterval;
@@ -1133,7 +1800,9 @@ int RenderContext::swapInterval() const
 
 void RenderContext::setSwapInterval(int newInterval)
 {
-  glfwSwapInterval(newInterval);
+  if (m_handle)
+    glfwSwapInterval(newInterval);
+
   m_swapInterval = newInterval;
 }
 
@@ -1214,14 +1883,10 @@ void RenderContext::setProgram(Program* newProgram)
 {
   if (newProgram != m_program)
   {
-    if (m_program)
-      m_program->unbind();
-
     m_program = newProgram;
-    m_dirtyBinding = true;
 
     if (m_program)
-      m_program->bind();
+      glUseProgram(m_program->m_programID);
     else
       glUseProgram(0);
   }
@@ -1232,7 +1897,6 @@ void RenderContext::setVertexBuffer(VertexBuffer* newVertexBuffer)
   if (newVertexBuffer != m_vertexBuffer)
   {
     m_vertexBuffer = newVertexBuffer;
-    m_dirtyBinding = true;
 
     if (m_vertexBuffer)
       glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer->m_bufferID);
@@ -1248,10 +1912,17 @@ void RenderContext::setVertexBuffer(VertexBuffer* newVertexBuffer)
 
 void RenderContext::setIndexBuffer(IndexBuffer* newIndexBuffer)
 {
+  // The index buffer binding is vertex array state, so leave any cached
+  // vertex array before touching it
+  if (m_vertexArray)
+  {
+    glBindVertexArray(0);
+    m_vertexArray = nullptr;
+  }
+
   if (newIndexBuffer != m_indexBuffer)
   {
     m_indexBuffer = newIndexBuffer;
-    m_dirtyBinding = true;
 
     if (m_indexBuffer)
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer->m_bufferID);
@@ -1343,11 +2014,40 @@ ResourceCache& RenderContext::cache() const
   return m_cache;
 }
 
+void RenderContext::setLoadBudget(Time newBudget)
+{
+  m_loadBudget = newBudget;
+}
+
+void RenderContext::setUploadBudget(size_t newBudget)
+{
+  m_uploadBudget = newBudget;
+}
+
+void RenderContext::queueUpload(Texture& texture, Image& image)
+{
+  texture.m_streaming = true;
+
+  Upload upload;
+  upload.texture = &texture;
+  upload.image = &image;
+  upload.row = 0;
+  m_uploads.push_back(upload);
+}
+
 Window& RenderContext::window()
 {
   return m_window;
 }
 
+void RenderContext::finishFrame()
+{
+  glFinish();
+  onFrame();
+
+  deliverLog();
+}
+
 const RenderLimits& RenderContext::limits() const
 {
   return *m_limits;
@@ -1364,20 +2064,55 @@ std::unique_ptr<RenderContext> RenderContext::create(ResourceCache& cache,
   return context;
 }
 
+std::unique_ptr<RenderContext> RenderContext::createHeadless(ResourceCache& cache,
+                                                             uint width,
+                                                             uint height,
+                                                             const RenderConfig& rc)
+{
+  std::unique_ptr<RenderContext> context(new RenderContext(cache));
+  if (!context->init(width, height, rc))
+    return nullptr;
+
+  return context;
+}
+
 RenderContext::RenderContext(ResourceCache& cache):
   m_cache(cache),
   m_handle(nullptr),
+  m_headless(false),
+  m_display(nullptr),
+  m_surface(nullptr),
+  m_context(nullptr),
   m_debug(false),
-  m_dirtyBinding(true),
+  m_preprocessorCache(new PreprocessorCache()),
+  m_loadBudget(0.002),
+  m_vertexArray(nullptr),
+  m_sharedBufferID(0),
+  m_sharedBufferOffset(0),
+  m_frameRevision(0),
+  m_objectRevision(0),
+  m_objectInverses(0),
   m_dirtyState(true),
   m_cullingInverted(false),
   m_textureUnit(0),
+  m_instanceStart(0),
+  m_uploadBufferID(0),
+  m_uploadMapping(nullptr),
+  m_uploadBudget(2 * 1024 * 1024),
+  m_frame(0),
   m_stats(nullptr)
 {
 }
 
 bool RenderContext::init(const WindowConfig& wc, const RenderConfig& rc)
 {
+#if WENDY_USE_EGL
+  (void) wc;
+  (void) rc;
+
+  logError("Windowed render contexts are not available in EGL builds");
+  return false;
+#else
   glfwSetErrorCallback(errorCallback);
 
   if (!glfwInit())
@@ -1425,6 +2160,147 @@ bool RenderContext::init(const WindowConfig& wc, const RenderConfig& rc)
     m_window.updated().connect(*this, &RenderContext::onFrame);
   }
 
+  int width, height;
+  glfwGetWindowSize(m_handle, &width, &height);
+
+  return initGL(rc, width, height);
+#endif
+}
+
+bool RenderContext::init(uint width, uint height, const RenderConfig& rc)
+{
+#if WENDY_USE_EGL
+  // Prefer the surfaceless platform, as it needs no window system
+  {
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && std::strstr(extensions, "EGL_MESA_platform_surfaceless"))
+    {
+      PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+        eglGetProcAddress("eglGetPlatformDisplayEXT");
+      if (getPlatformDisplay)
+      {
+        m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                       EGL_DEFAULT_DISPLAY,
+                                       nullptr);
+      }
+    }
+
+    if (!m_display)
+      m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+
+    if (!m_display || !eglInitialize(m_display, &major, &minor))
+    {
+      logError("Failed to initialize EGL: error 0x%04x", eglGetError());
+      return false;
+    }
+
+    log("EGL version %i.%i initialized", major, minor);
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+      logError("EGL display does not support OpenGL");
+      return false;
+    }
+  }
+
+  // Create context and pbuffer, or no surface at all if pbuffers are missing
+  {
+    const uint colorBits = min(rc.colorBits, 24u);
+
+    EGLint configAttribs[] =
+    {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, EGLint(colorBits / 3),
+      EGL_GREEN_SIZE, EGLint(colorBits / 3),
+      EGL_BLUE_SIZE, EGLint(colorBits / 3),
+      EGL_DEPTH_SIZE, EGLint(rc.depthBits),
+      EGL_STENCIL_SIZE, EGLint(rc.stencilBits),
+      EGL_SAMPLE_BUFFERS, rc.samples ? 1 : 0,
+      EGL_SAMPLES, EGLint(rc.samples),
+      EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint count;
+
+    if (!eglChooseConfig(m_display, configAttribs, &config, 1, &count) || !count)
+    {
+      const char* extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+      if (!extensions || !std::strstr(extensions, "EGL_KHR_surfaceless_context"))
+      {
+        logError("Failed to find a suitable EGL pbuffer configuration");
+        return false;
+      }
+
+      configAttribs[1] = EGL_DONT_CARE;
+
+      if (!eglChooseConfig(m_display, configAttribs, &config, 1, &count) || !count)
+      {
+        logError("Failed to find a suitable EGL configuration");
+        return false;
+      }
+    }
+    else
+    {
+      const EGLint surfaceAttribs[] =
+      {
+        EGL_WIDTH, EGLint(width),
+        EGL_HEIGHT, EGLint(height),
+        EGL_NONE
+      };
+
+      m_surface = eglCreatePbufferSurface(m_display, config, surfaceAttribs);
+      if (!m_surface)
+      {
+        logError("Failed to create EGL pbuffer: error 0x%04x", eglGetError());
+        return false;
+      }
+    }
+
+    const EGLint contextAttribs[] =
+    {
+      EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+      EGL_CONTEXT_MINOR_VERSION_KHR, 2,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR,
+      EGL_CONTEXT_FLAGS_KHR, rc.debug ? EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR : 0,
+      EGL_NONE
+    };
+
+    m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (!m_context)
+    {
+      logError("Failed to create EGL context: error 0x%04x", eglGetError());
+      return false;
+    }
+
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context))
+    {
+      logError("Failed to make EGL context current: error 0x%04x", eglGetError());
+      return false;
+    }
+
+    if (!m_surface)
+      log("EGL context has no surface; render into a texture framebuffer");
+  }
+
+  m_headless = true;
+
+  return initGL(rc, width, height);
+#else
+  (void) width;
+  (void) height;
+  (void) rc;
+
+  logError("Headless render contexts require Wendy to be built with EGL");
+  return false;
+#endif
+}
+
+bool RenderContext::initGL(const RenderConfig& rc, uint width, uint height)
+{
   // Initialize greg and check extensions
   {
     if (!gregInit())
@@ -1434,8 +2310,8 @@ bool RenderContext::init(const WindowConfig& wc, const RenderConfig& rc)
     }
 
     log("OpenGL context version %i.%i created",
-        glfwGetWindowAttrib(m_handle, GLFW_CONTEXT_VERSION_MAJOR),
-        glfwGetWindowAttrib(m_handle, GLFW_CONTEXT_VERSION_MINOR));
+        getInteger(GL_MAJOR_VERSION),
+        getInteger(GL_MINOR_VERSION));
 
     log("OpenGL context GLSL version is %s",
         (const char*) glGetString(GL_SHADING_LANGUAGE_VERSION));
@@ -1444,6 +2320,12 @@ bool RenderContext::init(const WindowConfig& wc, const RenderConfig& rc)
         (const char*) glGetString(GL_RENDERER),
         (const char*) glGetString(GL_VENDOR));
 
+    m_driverString = (const char*) glGetString(GL_VENDOR);
+    m_driverString += '\n';
+    m_driverString += (const char*) glGetString(GL_RENDERER);
+    m_driverString += '\n';
+    m_driverString += (const char*) glGetString(GL_VERSION);
+
     if (rc.debug && GREG_KHR_debug)
     {
       glDebugMessageCallback(debugCallback, nullptr);
@@ -1454,6 +2336,24 @@ bool RenderContext::init(const WindowConfig& wc, const RenderConfig& rc)
     }
   }
 
+  // Set up the program binary cache
+  if (!rc.programCachePath.isEmpty())
+  {
+    if (!GREG_ARB_get_program_binary ||
+        !getInteger(GL_NUM_PROGRAM_BINARY_FORMATS))
+    {
+      logWarning("Program binaries are not supported by this context");
+    }
+    else if (!rc.programCachePath.isDirectory() &&
+             !rc.programCachePath.createDirectory())
+    {
+      logWarning("Failed to create program cache directory %s",
+                 rc.programCachePath.name().c_str());
+    }
+    else
+      m_programCachePath = rc.programCachePath;
+  }
+
   // Retrieve context limits and set up dependent caches
   {
     m_limits.reset(new RenderLimits(*this));
@@ -1467,14 +2367,13 @@ bool RenderContext::init(const WindowConfig& wc, const RenderConfig& rc)
   // Create and apply default framebuffer
   {
     m_windowFramebuffer = new WindowFramebuffer(*this);
+    m_windowFramebuffer->m_width = width;
+    m_windowFramebuffer->m_height = height;
     m_framebuffer = m_windowFramebuffer;
   }
 
   // Force a known GL state
   {
-    int width, height;
-    glfwGetWindowSize(m_handle, &width, &height);
-
     setViewportArea(Recti(0, 0, width, height));
     setScissorArea(Recti(0, 0, width, height));
 
@@ -1485,6 +2384,67 @@ bool RenderContext::init(const WindowConfig& wc, const RenderConfig& rc)
     glEnable(GL_PROGRAM_POINT_SIZE);
   }
 
+  // Create ring buffer for shared uniform blocks
+  {
+    glGenBuffers(1, &m_sharedBufferID);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_sharedBufferID);
+    glBufferData(GL_UNIFORM_BUFFER, SHARED_BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+
+    if (!checkGL("Failed to create shared uniform buffer"))
+      return false;
+  }
+
+  // Create ring buffer for staging texture uploads
+  {
+    m_uploadStream = createStream(UPLOAD_SECTION_SIZE);
+
+    glGenBuffers(1, &m_uploadBufferID);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBufferID);
+    m_uploadMapping = initStreamStorage(GL_PIXEL_UNPACK_BUFFER,
+                                        UPLOAD_SECTION_SIZE * STREAM_SECTIONS);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!checkGL("Failed to create texture upload buffer"))
+      return false;
+  }
+
+  m_declaration += "#ifdef WY_VERTEX_SHADER\n"
+                   "#if __VERSION__ >= 130\n"
+                   "in mat4 wyInstanceM;\n"
+                   "#else\n"
+                   "attribute mat4 wyInstanceM;\n"
+                   "#endif\n"
+                   "#endif\n";
+
+  m_declaration += "#if __VERSION__ >= 140\n"
+                   "layout(std140) uniform wyFrame\n"
+                   "{\n"
+                   "  mat4 wyV;\n"
+                   "  mat4 wyP;\n"
+                   "  mat4 wyVP;\n"
+                   "  mat4 wyInvV;\n"
+                   "  mat4 wyInvP;\n"
+                   "  mat4 wyInvVP;\n"
+                   "  vec3 wyCameraPosition;\n"
+                   "  float wyCameraNearZ;\n"
+                   "  float wyCameraFarZ;\n"
+                   "  float wyCameraAspectRatio;\n"
+                   "  float wyCameraFOV;\n"
+                   "  float wyViewportWidth;\n"
+                   "  float wyViewportHeight;\n"
+                   "  float wyTime;\n"
+                   "};\n"
+                   "layout(std140) uniform wyObject\n"
+                   "{\n"
+                   "  mat4 wyM;\n"
+                   "  mat4 wyMV;\n"
+                   "  mat4 wyMVP;\n"
+                   "  mat4 wyInvM;\n"
+                   "  mat4 wyInvMV;\n"
+                   "  mat4 wyInvMVP;\n"
+                   "};\n"
+                   "#else\n";
+
   createSharedUniform("wyM", UNIFORM_MAT4, SHARED_MODEL_MATRIX);
   createSharedUniform("wyV", UNIFORM_MAT4, SHARED_VIEW_MATRIX);
   createSharedUniform("wyP", UNIFORM_MAT4, SHARED_PROJECTION_MATRIX);
@@ -1510,6 +2470,8 @@ bool RenderContext::init(const WindowConfig& wc, const RenderConfig& rc)
 
   createSharedUniform("wyTime", UNIFORM_FLOAT, SHARED_TIME);
 
+  m_declaration += "#endif\n";
+
   return true;
 }
 
@@ -1751,14 +2713,26 @@ void RenderContext::onFrame()
     }
   }
 
-  for (Slot& s : m_slots)
-  {
-    s.available = s.buffer->count();
-    s.buffer->discard();
-  }
+  // Ranges allocated during a frame may be drawn at any point in it, so
+  // sections are fenced only once all of its commands have been issued
+  for (Stream& s : m_vertexStreams)
+    fenceStream(s);
+  for (Stream& s : m_indexStreams)
+    fenceStream(s);
+  if (m_uploadBufferID)
+    fenceStream(m_uploadStream);
+
+  for (Stream& s : m_retiredStreams)
+    destroyStream(s);
+
+  m_retiredStreams.clear();
+  m_frame++;
 
   if (m_stats)
     m_stats->addFrame();
+
+  m_cache.finishLoads(m_loadBudget);
+  processUploads();
 }
 
 } /*namespace wendy*/
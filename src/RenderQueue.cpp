@@ -37,7 +37,6 @@
 #include <wendy/Material.hpp>
 #include <wendy/RenderQueue.hpp>
 
-#include <algorithm>
 
 namespace wendy
 {
@@ -86,25 +85,21 @@ void Light::setColor(const vec3& newColor)
 
 RenderOpKey RenderOpKey::makeOpaqueKey(uint8 layer, uint16 state, float depth)
 {
-  RenderOpKey key;
-  key.layer = layer;
-  key.state = state;
-  key.depth = (unsigned) (((1 << 24) - 1) * clamp(depth, 0.f, 1.f));
-
-  return key;
+  return RenderOpKey(layer,
+                     state,
+                     uint32(((1 << 24) - 1) * clamp(depth, 0.f, 1.f)));
 }
 
 RenderOpKey RenderOpKey::makeBlendedKey(uint8 layer, float depth)
 {
-  RenderOpKey key;
-  key.layer = layer;
-  key.depth = (unsigned) (((1 << 24) - 1) * (1.f - clamp(depth, 0.f, 1.f)));
-
-  return key;
+  return RenderOpKey(layer,
+                     0,
+                     uint32(((1 << 24) - 1) * (1.f - clamp(depth, 0.f, 1.f))));
 }
 
 RenderOp::RenderOp():
-  state(nullptr)
+  state(nullptr),
+  transform(0)
 {
 }
 
@@ -115,8 +110,7 @@ RenderBucket::RenderBucket():
 
 void RenderBucket::addOperation(const RenderOp& operation, RenderOpKey key)
 {
-  key.index = (uint16) m_operations.size();
-  m_keys.push_back(key);
+  m_entries.push_back(Entry{key, uint32(m_operations.size())});
   m_operations.push_back(operation);
   m_sorted = false;
 }
@@ -124,24 +118,88 @@ void RenderBucket::addOperation(const RenderOp& operation, RenderOpKey key)
 void RenderBucket::removeOperations()
 {
   m_operations.clear();
-  m_keys.clear();
+  m_entries.clear();
+  m_order.clear();
   m_sorted = true;
 }
 
-const std::vector<uint64>& RenderBucket::keys() const
+const std::vector<uint32>& RenderBucket::order() const
 {
-  if (!m_sorted)
+  if (m_sorted)
+    return m_order;
+
+  ProfileNodeCall call("RenderBucket::order");
+
+  const size_t count = m_entries.size();
+
+  // Comparison sorting is faster for small buckets, and breaking ties by index
+  // gives the same order as the stable radix sort
+  if (count < 2048)
   {
-    std::sort(m_keys.begin(), m_keys.end());
-    m_sorted = true;
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b)
+    {
+      return a.key < b.key || (a.key == b.key && a.index < b.index);
+    });
   }
+  else
+    sortEntries();
 
-  return m_keys;
+  m_order.resize(count);
+  for (size_t i = 0;  i < count;  i++)
+    m_order[i] = m_entries[i].index;
+
+  m_sorted = true;
+  return m_order;
+}
+
+void RenderBucket::sortEntries() const
+{
+  const uint RADIX_BITS = 8;
+  const uint RADIX_SIZE = 1 << RADIX_BITS;
+  const uint PASS_COUNT = RenderOpKey::BITS / RADIX_BITS;
+
+  const size_t count = m_entries.size();
+
+  // Build the histograms for all passes in a single read of the keys
+  uint32 histograms[PASS_COUNT][RADIX_SIZE] = {};
+
+  for (const Entry& e : m_entries)
+  {
+    for (uint p = 0;  p < PASS_COUNT;  p++)
+      histograms[p][(e.key >> (p * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+  }
+
+  m_scratch.resize(count);
+
+  for (uint p = 0;  p < PASS_COUNT;  p++)
+  {
+    uint32* histogram = histograms[p];
+
+    // Skip passes where every key has the same digit
+    const uint digit = (m_entries.front().key >> (p * RADIX_BITS)) & (RADIX_SIZE - 1);
+    if (histogram[digit] == count)
+      continue;
+
+    uint32 offset = 0;
+
+    for (uint i = 0;  i < RADIX_SIZE;  i++)
+    {
+      const uint32 size = histogram[i];
+      histogram[i] = offset;
+      offset += size;
+    }
+
+    for (const Entry& e : m_entries)
+      m_scratch[histogram[(e.key >> (p * RADIX_BITS)) & (RADIX_SIZE - 1)]++] = e;
+
+    m_entries.swap(m_scratch);
+  }
 }
 
 RenderQueue::RenderQueue(RenderContext& context, RenderPhase phase):
   m_context(context),
-  m_phase(phase)
+  m_phase(phase),
+  m_transforms(1, mat4())
 {
 }
 
@@ -166,16 +224,26 @@ void RenderQueue::createOperations(const mat4& transform,
 {
   RenderOp operation;
   operation.range = range;
-  operation.transform = transform;
+  operation.transform = addTransform(transform);
 
   operation.state = &material.pass(m_phase);
   addOperation(operation, depth, 0);
 }
 
+uint32 RenderQueue::addTransform(const mat4& transform)
+{
+  if (m_transforms.back() == transform)
+    return uint32(m_transforms.size() - 1);
+
+  m_transforms.push_back(transform);
+  return uint32(m_transforms.size() - 1);
+}
+
 void RenderQueue::removeOperations()
 {
   m_opaqueBucket.removeOperations();
   m_blendedBucket.removeOperations();
+  m_transforms.resize(1);
 }
 
 void RenderQueue::addLight(const LightData& light)
@@ -63,8 +63,8 @@ void Renderer::render(const RenderQueue& queue, const Camera& camera)
                                  camera.farZ());
   }
 
-  renderOperations(queue.opaqueBucket());
-  renderOperations(queue.blendedBucket());
+  renderOperations(queue, queue.opaqueBucket());
+  renderOperations(queue, queue.blendedBucket());
 
   m_context.setSharedProgramState(nullptr);
 }
@@ -97,21 +97,81 @@ bool Renderer::init()
   return true;
 }
 
-void Renderer::renderOperations(const RenderBucket& bucket)
+void Renderer::renderOperations(const RenderQueue& queue, const RenderBucket& bucket)
 {
   const auto& operations = bucket.operations();
+  const auto& transforms = queue.transforms();
+  const auto& order = bucket.order();
 
-  for (auto k : bucket.keys())
+  const bool instancing = m_context.isInstancingSupported();
+
+  size_t i = 0;
+
+  while (i < order.size())
   {
-    const RenderOpKey key(k);
-    const RenderOp& op = operations[key.index];
+    const RenderOp& op = operations[order[i]];
+
+    // Find the run of operations sharing this pass and primitive range
+    size_t end = i + 1;
+
+    if (instancing)
+    {
+      while (end < order.size())
+      {
+        const RenderOp& next = operations[order[end]];
+        if (next.state != op.state || next.range != op.range)
+          break;
+
+        end++;
+      }
+    }
+
+    if (end - i > 1 && isInstanced(*op.state))
+    {
+      const uint count = uint(end - i);
+
+      m_instances.resize(count);
+
+      for (uint j = 0;  j < count;  j++)
+        m_instances[j] = transforms[operations[order[i + j]].transform];
 
-    m_state->setModelMatrix(op.transform);
-    op.state->apply();
+      VertexRange range = m_context.allocateVertices(count, InstanceTransform::format);
+      if (!range.isEmpty())
+      {
+        range.copyFrom(m_instances.data());
 
-    m_context.render(op.range);
+        // The per-instance transforms are the model matrices, so programs
+        // combining them with the shared ones see the identity there
+        m_state->setModelMatrix(mat4());
+        op.state->apply();
+        m_context.render(op.range, range);
+
+        i = end;
+        continue;
+      }
+    }
+
+    for (;  i < end;  i++)
+    {
+      const RenderOp& op = operations[order[i]];
+
+      m_state->setModelMatrix(transforms[op.transform]);
+      op.state->apply();
+
+      m_context.render(op.range);
+    }
   }
 }
 
+bool Renderer::isInstanced(const Pass& pass) const
+{
+  const Program* program = pass.program();
+  if (!program)
+    return false;
+
+  const Attribute* attribute = program->findAttribute("wyInstanceM");
+  return attribute && attribute->type() == ATTRIBUTE_MAT4;
+}
+
 } /*namespace wendy*/
 
@@ -26,14 +26,39 @@
 #include <wendy/Config.hpp>
 
 #include <wendy/Core.hpp>
+#include <wendy/Time.hpp>
+#include <wendy/Profile.hpp>
 #include <wendy/Path.hpp>
 #include <wendy/Resource.hpp>
 
 #include <algorithm>
+#include <cctype>
 
 namespace wendy
 {
 
+namespace
+{
+
+// Returns the key of a directory entry in a cached listing, which ignores
+// case where the file system usually does
+std::string listingKey(const std::string& entry)
+{
+#if WENDY_SYSTEM_WIN32 || WENDY_SYSTEM_MACOSX
+  std::string key;
+  key.reserve(entry.size());
+
+  for (char c : entry)
+    key += std::tolower((unsigned char) c);
+
+  return key;
+#else
+  return entry;
+#endif
+}
+
+} /*namespace*/
+
 ResourceInfo::ResourceInfo(ResourceCache& cache,
                            const std::string& name,
                            const Path& path):
@@ -43,33 +68,29 @@ ResourceInfo::ResourceInfo(ResourceCache& cache,
 {
 }
 
-Resource::Resource(const ResourceInfo& info):
+Resource::Resource(const ResourceInfo& info, AtomicRefObject* counter):
   m_cache(info.cache),
   m_name(info.name),
-  m_path(info.path)
+  m_path(info.path),
+  m_counter(counter)
 {
   if (!m_name.empty())
   {
-    if (m_cache.findResource(m_name))
+    if (!m_cache.addResource(*this))
       panic("Duplicate name for resource %s", m_name.c_str());
-
-    m_cache.m_resources.push_back(this);
   }
 }
 
 Resource::Resource(const Resource& source):
-  m_cache(source.m_cache)
+  m_cache(source.m_cache),
+  m_counter(nullptr)
 {
 }
 
 Resource::~Resource()
 {
   if (!m_name.empty())
-  {
-    m_cache.m_resources.erase(std::find(m_cache.m_resources.begin(),
-                                        m_cache.m_resources.end(),
-                                        this));
-  }
+    m_cache.removeResource(*this);
 }
 
 Resource& Resource::operator = (const Resource& source)
@@ -77,15 +98,64 @@ Resource& Resource::operator = (const Resource& source)
   return *this;
 }
 
+ResourceCache::NameLock::NameLock(ResourceCache& cache, const std::string& name):
+  m_cache(cache),
+  m_name(name)
+{
+  std::unique_lock<std::mutex> lock(m_cache.m_nameMutex);
+
+  while (m_cache.m_lockedNames.count(m_name))
+    m_cache.m_nameCondition.wait(lock);
+
+  m_cache.m_lockedNames.insert(m_name);
+}
+
+ResourceCache::NameLock::~NameLock()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_cache.m_nameMutex);
+    m_cache.m_lockedNames.erase(m_name);
+  }
+
+  m_cache.m_nameCondition.notify_all();
+}
+
+ResourceCache::ResourceCache():
+  m_stopping(false)
+{
+}
+
 ResourceCache::~ResourceCache()
 {
-  if (!m_resources.empty())
+  // Abandon queued loads and wait for the ones in progress
   {
-    for (const Resource* r : m_resources)
-      logError("Resource %s not destroyed", r->name().c_str());
+    std::lock_guard<std::mutex> lock(m_loadMutex);
+    m_stopping = true;
+    m_loads.clear();
+  }
 
-    panic("Resource cache destroyed with attached resources");
+  m_loadCondition.notify_all();
+
+  for (std::thread& worker : m_workers)
+    worker.join();
+
+  // This releases decoded resources, so must happen before the check below
+  m_finished.clear();
+  m_pending.clear();
+
+  bool attached = false;
+
+  for (const Shard& s : m_shards)
+  {
+    for (const auto& entry : s.resources)
+    {
+      logError("Resource %s not destroyed", entry.first.c_str());
+      attached = true;
+    }
   }
+
+  if (attached)
+    panic("Resource cache destroyed with attached resources");
 }
 
 bool ResourceCache::addSearchPath(const Path& path)
@@ -106,15 +176,22 @@ void ResourceCache::removeSearchPath(const Path& path)
   m_paths.erase(std::find(m_paths.begin(), m_paths.end(), path));
 }
 
+void ResourceCache::clearFileCache()
+{
+  std::lock_guard<std::mutex> lock(m_fileMutex);
+  m_listings.clear();
+}
+
 Resource* ResourceCache::findResource(const std::string& name) const
 {
-  for (Resource* r : m_resources)
-  {
-    if (r->name() == name)
-      return r;
-  }
+  Shard& shard = shardOf(name);
+  std::lock_guard<std::mutex> lock(shard.mutex);
 
-  return nullptr;
+  auto entry = shard.resources.find(name);
+  if (entry == shard.resources.end())
+    return nullptr;
+
+  return entry->second;
 }
 
 Path ResourceCache::findFile(const std::string& name) const
@@ -124,19 +201,189 @@ Path ResourceCache::findFile(const std::string& name) const
     const Path path(name);
     if (path.isFile())
       return path;
+
+    return Path();
   }
+
+  // Split the name into a directory part, if any, and the entry to look for
+  std::string directory, entry;
+
+  const std::string::size_type offset = name.find_last_of('/');
+  if (offset == std::string::npos)
+    entry = name;
   else
   {
-    for (const Path& path : m_paths)
+    directory = name.substr(0, offset);
+    entry = name.substr(offset + 1);
+  }
+
+  const std::string key = listingKey(entry);
+
+  for (const Path& path : m_paths)
+  {
+    const Path parent = directory.empty() ? path : path + directory;
+
+    if (isListed(parent.name(), key))
+      return parent + entry;
+  }
+
+  return Path();
+}
+
+void ResourceCache::finishLoads(Time budget)
+{
+  ProfileNodeCall call("ResourceCache::finishLoads");
+
+  const Time start = Timer::currentTime();
+
+  for (;;)
+  {
+    Load load;
+
     {
-      const Path full(path + name);
-      if (full.isFile())
-        return full;
+      std::lock_guard<std::mutex> lock(m_loadMutex);
+      if (m_finished.empty())
+        break;
+
+      load = std::move(m_finished.front());
+      m_finished.pop_front();
     }
+
+    load.finish(load.success);
+
+    if (Timer::currentTime() - start >= budget)
+      break;
   }
+}
 
-  return Path();
+bool ResourceCache::addResource(Resource& resource)
+{
+  Shard& shard = shardOf(resource.name());
+
+  for (;;)
+  {
+    // Released after the lock, as dropping the last reference removes the
+    // resource from its shard
+    Ref<AtomicRefObject> pin;
+
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+
+      auto result = shard.resources.insert(std::make_pair(resource.name(), &resource));
+      if (result.second)
+        return true;
+
+      Resource* existing = result.first->second;
+      if (!existing->m_counter)
+        return false;
+
+      pin = Ref<AtomicRefObject>::acquire(existing->m_counter);
+      if (pin)
+        return false;
+    }
+
+    // The resource holding the name has no references, so it is either being
+    // destroyed on another thread or about to be referenced by its creator
+    std::this_thread::yield();
+  }
 }
 
-} /*namespace wendy*/
+void ResourceCache::removeResource(Resource& resource)
+{
+  Shard& shard = shardOf(resource.name());
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  // The name may already have been taken over by a new resource
+  auto entry = shard.resources.find(resource.name());
+  if (entry != shard.resources.end() && entry->second == &resource)
+    shard.resources.erase(entry);
+}
+
+ResourceCache::Shard& ResourceCache::shardOf(const std::string& name) const
+{
+  return m_shards[std::hash<std::string>()(name) % SHARD_COUNT];
+}
+
+bool ResourceCache::isListed(const std::string& directory,
+                             const std::string& key) const
+{
+  {
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+
+    auto entry = m_listings.find(directory);
+    if (entry != m_listings.end())
+      return entry->second.count(key) != 0;
+  }
+
+  // The directory is read without holding the lock, so that lookups in
+  // directories already listed are not kept waiting
+  Listing listing;
+
+  for (const std::string& file : Path(directory).files())
+    listing.insert(listingKey(file));
+
+  const bool listed = listing.count(key) != 0;
 
+  std::lock_guard<std::mutex> lock(m_fileMutex);
+  m_listings.insert(std::make_pair(directory, std::move(listing)));
+  return listed;
+}
+
+void ResourceCache::queueLoad(std::function<bool ()> decode,
+                              std::function<void (bool)> finish)
+{
+  if (m_workers.empty())
+  {
+    // Leave one core for the thread submitting the loads
+    const uint count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    for (uint i = 0;  i < count;  i++)
+      m_workers.push_back(std::thread(&ResourceCache::runWorker, this));
+  }
+
+  Load load;
+  load.decode = std::move(decode);
+  load.finish = std::move(finish);
+  load.success = false;
+
+  {
+    std::lock_guard<std::mutex> lock(m_loadMutex);
+    m_loads.push_back(std::move(load));
+  }
+
+  m_loadCondition.notify_one();
+}
+
+void ResourceCache::runWorker()
+{
+  for (;;)
+  {
+    Load load;
+
+    {
+      std::unique_lock<std::mutex> lock(m_loadMutex);
+
+      while (m_loads.empty() && !m_stopping)
+        m_loadCondition.wait(lock);
+
+      if (m_stopping)
+        return;
+
+      load = std::move(m_loads.front());
+      m_loads.pop_front();
+    }
+
+    load.success = load.decode();
+
+    // Release the data held by the decode step on this thread, so that only
+    // the finishing thread touches it from now on
+    load.decode = nullptr;
+
+    {
+      std::lock_guard<std::mutex> lock(m_loadMutex);
+      m_finished.push_back(std::move(load));
+    }
+  }
+}
+
+} /*namespace wendy*/
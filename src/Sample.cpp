@@ -39,7 +39,7 @@ Sample::Sample(const ResourceInfo& info,
                size_t size,
                SampleFormat format,
                uint frequency):
-  Resource(info),
+  Resource(info, this),
   data(data, data + size),
   format(format),
   frequency(frequency)
@@ -48,7 +48,11 @@ Sample::Sample(const ResourceInfo& info,
 
 Ref<Sample> Sample::read(ResourceCache& cache, const std::string& name)
 {
-  if (Sample* cached = cache.find<Sample>(name))
+  // This may run on loader threads, so keep others from creating the same
+  // resource until this one is done
+  ResourceCache::NameLock lock(cache, name);
+
+  if (Ref<Sample> cached = cache.find<Sample>(name))
     return cached;
 
   const Path path = cache.findFile(name);
@@ -31,6 +31,7 @@
 #include <wendy/Transform.hpp>
 #include <wendy/Primitive.hpp>
 #include <wendy/Frustum.hpp>
+#include <wendy/AABBTree.hpp>
 #include <wendy/Camera.hpp>
 
 #include <wendy/Texture.hpp>
@@ -47,11 +48,24 @@
 namespace wendy
 {
 
+namespace
+{
+
+const uint NO_PROXY = 0xffffffff;
+
+const uint ALL_FRUSTUM_PLANES = 0x3f;
+
+} /*namespace*/
+
 SceneNode::SceneNode():
   m_parent(nullptr),
   m_graph(nullptr),
   m_dirtyWorld(false),
-  m_dirtyBounds(false)
+  m_dirtyBounds(false),
+  m_dirtyWorldBounds(true),
+  m_proxy(NO_PROXY),
+  m_serial(0),
+  m_dirtyProxy(false)
 {
 }
 
@@ -201,6 +215,22 @@ const Sphere& SceneNode::totalBounds() const
   return m_totalBounds;
 }
 
+const Sphere& SceneNode::worldBounds() const
+{
+  if (m_dirtyWorldBounds)
+    updateWorldBounds();
+
+  return m_worldBounds;
+}
+
+const Sphere& SceneNode::worldTotalBounds() const
+{
+  if (m_dirtyWorldBounds)
+    updateWorldBounds();
+
+  return m_worldTotalBounds;
+}
+
 void SceneNode::setRenderable(Renderable* newRenderable)
 {
   m_renderable = newRenderable;
@@ -233,31 +263,93 @@ void SceneNode::update()
     m_camera->setTransform(worldTransform());
 }
 
-void SceneNode::enqueue(RenderQueue& queue, const Camera& camera) const
+void SceneNode::enqueue(RenderQueue& queue, const Camera& camera, uint planes) const
 {
+  const Frustum& frustum = camera.frustum();
+
+  if (planes)
+  {
+    const Sphere& bounds = worldTotalBounds();
+
+    for (uint i = 0;  i < 6;  i++)
+    {
+      if (!(planes & (1 << i)))
+        continue;
+
+      const Plane& plane = frustum.planes[i];
+      const float distance = dot(plane.normal, bounds.center);
+
+      if (distance - bounds.radius > plane.distance)
+        return;
+
+      if (distance + bounds.radius < plane.distance)
+        planes &= ~(1 << i);
+    }
+  }
+
   if (m_renderable)
-    m_renderable->enqueue(queue, camera, worldTransform());
+  {
+    if (!planes || frustum.intersects(worldBounds()))
+      m_renderable->enqueue(queue, camera, worldTransform());
+  }
 
   for (const SceneNode* c : m_children)
-    c->enqueue(queue, camera);
+    c->enqueue(queue, camera, planes);
 }
 
 void SceneNode::invalidateBounds()
 {
-  for (SceneNode* node = this;  node;  node = node->parent())
+  SceneNode* node = this;
+
+  for (;;)
+  {
     node->m_dirtyBounds = true;
+    node->m_dirtyWorldBounds = true;
+
+    if (!node->m_parent)
+      break;
+
+    node = node->m_parent;
+  }
+
+  node->invalidateProxy();
 }
 
 void SceneNode::invalidateWorldTransform()
 {
   m_dirtyWorld = true;
+  m_dirtyWorldBounds = true;
+
+  if (!m_parent)
+    invalidateProxy();
 
   for (SceneNode* c : m_children)
     c->invalidateWorldTransform();
 }
 
+void SceneNode::invalidateProxy()
+{
+  if (m_graph && !m_dirtyProxy)
+  {
+    m_graph->m_dirtyProxies.push_back(this);
+    m_dirtyProxy = true;
+  }
+}
+
+void SceneNode::updateWorldBounds() const
+{
+  const Transform3& transform = worldTransform();
+
+  m_worldBounds = transform * m_localBounds;
+  m_worldTotalBounds = transform * totalBounds();
+  m_dirtyWorldBounds = false;
+}
+
 void SceneNode::setGraph(SceneGraph* newGraph)
 {
+  if (m_graph)
+    m_graph->removeProxy(*this);
+
   if (m_graph && m_camera)
   {
     auto& updated = m_graph->m_updated;
@@ -273,6 +365,11 @@ void SceneNode::setGraph(SceneGraph* newGraph)
     c->setGraph(m_graph);
 }
 
+SceneGraph::SceneGraph():
+  m_nextSerial(0)
+{
+}
+
 SceneGraph::~SceneGraph()
 {
   destroyRootNodes();
@@ -288,31 +385,55 @@ void SceneGraph::enqueue(RenderQueue& queue, const Camera& camera) const
 {
   ProfileNodeCall call("SceneGraph::enqueue");
 
-  const Frustum& frustum = camera.frustum();
+  m_visible.clear();
+  query(camera.frustum(), m_visible);
 
-  for (const SceneNode* r : m_roots)
-  {
-    if (frustum.intersects(r->worldTransform() * r->totalBounds()))
-      r->enqueue(queue, camera);
-  }
+  for (const SceneNode* r : m_visible)
+    r->enqueue(queue, camera, ALL_FRUSTUM_PLANES);
 }
 
 void SceneGraph::query(const Sphere& sphere, std::vector<SceneNode*>& nodes) const
 {
-  for (SceneNode* r : m_roots)
+  updateProxies();
+
+  m_candidates.clear();
+  m_tree.query(sphere, m_candidates);
+
+  const size_t start = nodes.size();
+
+  for (void* candidate : m_candidates)
   {
-    if (sphere.intersects(r->worldTransform() * r->totalBounds()))
+    SceneNode* r = static_cast<SceneNode*>(candidate);
+    if (sphere.intersects(r->worldTotalBounds()))
       nodes.push_back(r);
   }
+
+  sortBySerial(nodes, start);
 }
 
 void SceneGraph::query(const Frustum& frustum, std::vector<SceneNode*>& nodes) const
 {
-  for (SceneNode* r : m_roots)
+  updateProxies();
+
+  m_candidates.clear();
+  m_tree.query(frustum, m_candidates);
+
+  m_candidateBounds.clear();
+
+  for (void* candidate : m_candidates)
+    m_candidateBounds.add(static_cast<SceneNode*>(candidate)->worldTotalBounds());
+
+  frustum.intersects(m_candidateBounds, m_candidateMask);
+
+  const size_t start = nodes.size();
+
+  for (size_t i = 0;  i < m_candidates.size();  i++)
   {
-    if (frustum.intersects(r->worldTransform() * r->totalBounds()))
-      nodes.push_back(r);
+    if (m_candidateMask[i / 32] & (1u << (i % 32)))
+      nodes.push_back(static_cast<SceneNode*>(m_candidates[i]));
   }
+
+  sortBySerial(nodes, start);
 }
 
 void SceneGraph::addRootNode(SceneNode& node)
@@ -320,6 +441,8 @@ void SceneGraph::addRootNode(SceneNode& node)
   node.removeFromParent();
   m_roots.push_back(&node);
   node.setGraph(this);
+  node.m_serial = m_nextSerial++;
+  node.invalidateProxy();
 }
 
 void SceneGraph::destroyRootNodes()
@@ -328,5 +451,48 @@ void SceneGraph::destroyRootNodes()
     delete m_roots.back();
 }
 
+void SceneGraph::updateProxies() const
+{
+  for (SceneNode* r : m_dirtyProxies)
+  {
+    const Sphere& sphere = r->worldTotalBounds();
+    const AABB bounds(sphere.center, vec3(sphere.radius * 2.f));
+
+    r->m_dirtyProxy = false;
+
+    if (r->m_proxy == NO_PROXY)
+      r->m_proxy = m_tree.createProxy(bounds, r);
+    else
+      m_tree.moveProxy(r->m_proxy, bounds);
+  }
+
+  m_dirtyProxies.clear();
+}
+
+void SceneGraph::removeProxy(SceneNode& node)
+{
+  if (node.m_dirtyProxy)
+  {
+    m_dirtyProxies.erase(std::find(m_dirtyProxies.begin(),
+                                   m_dirtyProxies.end(),
+                                   &node));
+    node.m_dirtyProxy = false;
+  }
+
+  if (node.m_proxy != NO_PROXY)
+  {
+    m_tree.destroyProxy(node.m_proxy);
+    node.m_proxy = NO_PROXY;
+  }
+}
+
+void SceneGraph::sortBySerial(std::vector<SceneNode*>& nodes, size_t start) const
+{
+  std::sort(nodes.begin() + start, nodes.end(), [](SceneNode* a, SceneNode* b)
+  {
+    return a->m_serial < b->m_serial;
+  });
+}
+
 } /*namespace wendy*/
 
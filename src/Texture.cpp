@@ -118,6 +118,36 @@ GLenum convertToGL(TextureType type, CubeFace face)
     return convertToGL(face);
 }
 
+std::string imageTextureName(const TextureParams& params,
+                             const std::string& imageName)
+{
+  std::string name;
+  name += "image:";
+  name += imageName;
+
+  if (params.flags & TF_MIPMAPPED)
+    name += " mipmapped";
+  if (params.flags & TF_SRGB)
+    name += " sRGB";
+
+  if (params.filterMode == FILTER_NEAREST)
+    name += " nearest";
+  else if (params.filterMode == FILTER_BILINEAR)
+    name += " bilinear";
+  else if (params.filterMode == FILTER_TRILINEAR)
+    name += " trilinear";
+
+  if (params.addressMode == ADDRESS_WRAP)
+    name += " wrap";
+  else if (params.addressMode == ADDRESS_CLAMP)
+    name += " clamp";
+
+  if (params.maxAnisotropy != 1.f)
+    name += wendy::format(" %f", params.maxAnisotropy);
+
+  return name;
+}
+
 } /*namespace*/
 
 TextureData::TextureData(const Image& image):
@@ -125,7 +155,9 @@ TextureData::TextureData(const Image& image):
   width(image.width()),
   height(image.height()),
   depth(image.depth()),
-  texels(image.pixels())
+  texels(image.pixels()),
+  levels(image.levelCount()),
+  sRGB(image.isSRGB())
 {
 }
 
@@ -133,12 +165,15 @@ TextureData::TextureData(PixelFormat format,
                          uint width,
                          uint height,
                          uint depth,
-                         const void* texels):
+                         const void* texels,
+                         uint levels):
   format(format),
   width(width),
   height(height),
   depth(depth),
-  texels(texels)
+  texels(texels),
+  levels(levels),
+  sRGB(false)
 {
 }
 
@@ -197,6 +232,13 @@ bool Texture::copyFrom(const TextureImage& image,
     return false;
   }
 
+  if (m_format.isCompressed())
+  {
+    logError("Cannot copy texture data into compressed texture %s",
+             name().c_str());
+    return false;
+  }
+
   if (is1D())
   {
     if (data.dimensionCount() > 1)
@@ -260,6 +302,13 @@ bool Texture::copyFrom(const TextureImage& image,
 
 void Texture::generateMipmaps()
 {
+  if (m_format.isCompressed())
+  {
+    logError("Cannot generate mipmaps for compressed texture %s",
+             name().c_str());
+    return;
+  }
+
   m_context.setTexture(this);
   glGenerateMipmap(convertToGL(m_params.type));
   glTexParameteri(convertToGL(m_params.type),
@@ -324,9 +373,9 @@ size_t Texture::size() const
   for (uint i = 0;  i < m_levels;  i++)
   {
     if (m_params.type == TEXTURE_CUBE)
-      size += width(i) * height(i) * depth(i) * m_format.size();
+      size += m_format.size(width(i), height(i), depth(i));
     else
-      size += width(i) * height(i) * depth(i) * m_format.size() * 6;
+      size += m_format.size(width(i), height(i), depth(i)) * 6;
   }
 
   return size;
@@ -342,11 +391,20 @@ Ref<Image> Texture::data(const TextureImage& image)
 
   m_context.setTexture(this);
 
-  glGetTexImage(convertToGL(m_params.type, image.face),
-                image.level,
-                convertToGL(m_format.semantic()),
-                convertToGL(m_format.type()),
-                result->pixels());
+  if (m_format.isCompressed())
+  {
+    glGetCompressedTexImage(convertToGL(m_params.type, image.face),
+                            image.level,
+                            result->pixels());
+  }
+  else
+  {
+    glGetTexImage(convertToGL(m_params.type, image.face),
+                  image.level,
+                  convertToGL(m_format.semantic()),
+                  convertToGL(m_format.type()),
+                  result->pixels());
+  }
 
 #if WENDY_DEBUG
   if (!checkGL("Error during copy to image from level %u of texture %s",
@@ -378,29 +436,7 @@ Ref<Texture> Texture::read(RenderContext& context,
 {
   ResourceCache& cache = context.cache();
 
-  std::string name;
-  name += "image:";
-  name += imageName;
-
-  if (params.flags & TF_MIPMAPPED)
-    name += " mipmapped";
-  if (params.flags & TF_SRGB)
-    name += " sRGB";
-
-  if (params.filterMode == FILTER_NEAREST)
-    name += " nearest";
-  else if (params.filterMode == FILTER_BILINEAR)
-    name += " bilinear";
-  else if (params.filterMode == FILTER_TRILINEAR)
-    name += " trilinear";
-
-  if (params.addressMode == ADDRESS_WRAP)
-    name += " wrap";
-  else if (params.addressMode == ADDRESS_CLAMP)
-    name += " clamp";
-
-  if (params.maxAnisotropy != 1.f)
-    name += wendy::format(" %f", params.maxAnisotropy);
+  const std::string name = imageTextureName(params, imageName);
 
   if (Ref<Texture> texture = cache.find<Texture>(name))
     return texture;
@@ -415,14 +451,62 @@ Ref<Texture> Texture::read(RenderContext& context,
   return create(ResourceInfo(cache, name), context, params, *data);
 }
 
+AsyncResource<Texture> Texture::readAsync(RenderContext& context,
+                                          const TextureParams& params,
+                                          const std::string& imageName)
+{
+  ResourceCache& cache = context.cache();
+
+  const std::string name = imageTextureName(params, imageName);
+
+  std::function<bool (Ref<Image>&)> decode = [&cache, name, imageName](Ref<Image>& data)
+  {
+    data = Image::read(cache, imageName);
+    if (!data)
+    {
+      logError("Failed to read image for texture %s", name.c_str());
+      return false;
+    }
+
+    return true;
+  };
+
+  std::function<Ref<Texture> (Ref<Image>&)> finish = [&context, params, name](Ref<Image>& data) -> Ref<Texture>
+  {
+    const ResourceInfo info(context.cache(), name);
+
+    if ((params.type != TEXTURE_2D && params.type != TEXTURE_RECT) ||
+        data->format().isCompressed() || data->levelCount() > 1)
+    {
+      return create(info, context, params, *data);
+    }
+
+    // Allocate storage now and stream the texels in over later frames, so
+    // that large images do not stall the frame that finishes them
+    TextureData storage(*data);
+    storage.texels = nullptr;
+
+    Ref<Texture> texture(new Texture(info, context, params));
+    texture->m_streaming = true;
+    if (!texture->init(storage))
+      return nullptr;
+
+    context.queueUpload(*texture, *data);
+    return texture;
+  };
+
+  return cache.loadAsync<Texture, Ref<Image>>(name, decode, finish);
+}
+
 Texture::Texture(const ResourceInfo& info,
                  RenderContext& context,
                  const TextureParams& params):
-  Resource(info),
+  Resource(info, this),
   m_context(context),
   m_params(params),
   m_textureID(0),
-  m_levels(0)
+  m_levels(0),
+  m_streaming(false)
 {
 }
 
@@ -430,7 +514,7 @@ bool Texture::init(const TextureData& data)
 {
   m_format = data.format;
 
-  const bool sRGB = (m_params.flags & TF_SRGB) ? true : false;
+  const bool sRGB = (m_params.flags & TF_SRGB) || data.sRGB;
   const bool mipmapped = (m_params.flags & TF_MIPMAPPED) ? true : false;
 
   if (!convertToGL(m_format, sRGB))
@@ -450,6 +534,12 @@ bool Texture::init(const TextureData& data)
     }
   }
 
+  if (m_format.isCompressed() && m_params.type != TEXTURE_2D)
+  {
+    logError("Compressed texture %s is not two-dimensional", name().c_str());
+    return false;
+  }
+
   if (m_params.type == TEXTURE_RECT)
   {
     if (data.dimensionCount() > 2)
@@ -514,6 +604,12 @@ bool Texture::init(const TextureData& data)
     m_depth = data.depth;
   }
 
+  // Mipmap levels included in the data are used as they are, as compressed
+  // textures cannot generate their own
+  uint dataLevels = 1;
+  if (mipmapped && m_params.type == TEXTURE_2D)
+    dataLevels = data.levels;
+
   glGenTextures(1, &m_textureID);
 
   if (m_context.debug())
@@ -576,20 +672,62 @@ bool Texture::init(const TextureData& data)
   }
   else
   {
-    glTexImage2D(convertToGL(m_params.type),
-                 0,
-                 convertToGL(m_format, sRGB),
-                 m_width, m_height,
-                 0,
-                 convertToGL(m_format.semantic()),
-                 convertToGL(m_format.type()),
-                 data.texels);
+    const char* texels = (const char*) data.texels;
+
+    for (uint level = 0;  level < dataLevels;  level++)
+    {
+      const uint width = max(m_width >> level, 1u);
+      const uint height = max(m_height >> level, 1u);
+
+      if (m_format.isCompressed())
+      {
+        glCompressedTexImage2D(convertToGL(m_params.type),
+                               level,
+                               convertToGL(m_format, sRGB),
+                               width, height,
+                               0,
+                               m_format.size(width, height),
+                               texels);
+      }
+      else
+      {
+        glTexImage2D(convertToGL(m_params.type),
+                     level,
+                     convertToGL(m_format, sRGB),
+                     width, height,
+                     0,
+                     convertToGL(m_format.semantic()),
+                     convertToGL(m_format.type()),
+                     texels);
+      }
+
+      if (texels)
+        texels += m_format.size(width, height);
+    }
   }
 
   if (mipmapped)
   {
-    glGenerateMipmap(convertToGL(m_params.type));
-    m_levels = uint(log2(float(max(max(m_width, m_height), m_depth))));
+    if (dataLevels > 1 || m_format.isCompressed())
+    {
+      if (dataLevels == 1)
+      {
+        logWarning("Compressed texture %s has no mipmap levels to use",
+                   name().c_str());
+      }
+
+      m_levels = dataLevels;
+      glTexParameteri(convertToGL(m_params.type), GL_TEXTURE_MAX_LEVEL,
+                      m_levels - 1);
+    }
+    else
+    {
+      // Streamed textures generate their mipmaps once all texels have arrived
+      if (!m_streaming)
+        glGenerateMipmap(convertToGL(m_params.type));
+
+      m_levels = uint(log2(float(max(max(m_width, m_height), m_depth))));
+    }
   }
   else
     m_levels = 1;
@@ -615,6 +753,26 @@ bool Texture::init(const TextureData& data)
     }
   }
 
+  // Single and dual channel compressed formats are stored as red and
+  // red-green, so make them sample like luminance and luminance-alpha
+  if (m_format == PixelFormat::L_BC4 || m_format == PixelFormat::LA_BC5)
+  {
+    if (GREG_ARB_texture_swizzle)
+    {
+      const GLint alpha = (m_format == PixelFormat::LA_BC5) ? GL_GREEN : GL_ONE;
+      const GLint swizzle[] = { GL_RED, GL_RED, GL_RED, alpha };
+
+      glTexParameteriv(convertToGL(m_params.type), GL_TEXTURE_SWIZZLE_RGBA,
+                       swizzle);
+    }
+    else
+    {
+      logWarning("Cannot swizzle texture %s to luminance: "
+                 "GL_ARB_texture_swizzle is missing",
+                 name().c_str());
+    }
+  }
+
   if (!checkGL("OpenGL error during creation of texture %s format %s",
                name().c_str(),
                stringCast(m_format).c_str()))
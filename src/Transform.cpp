@@ -127,7 +127,7 @@ Transform3::Transform3(vec3 position, quat rotation, float scale):
 Transform3 Transform3::inverse() const
 {
   const quat ir = glm::inverse(rotation);
-  return Transform3(ir * -position, ir, 1.f / scale);
+  return Transform3(ir * -position / scale, ir, 1.f / scale);
 }
 
 Transform3::operator mat4 () const
@@ -149,7 +149,7 @@ Transform3::operator mat4 () const
 
 Transform3 Transform3::operator * (const Transform3& other) const
 {
-  return Transform3(position + rotation * other.position,
+  return Transform3(position + rotation * (scale * other.position),
                     rotation * other.rotation,
                     scale * other.scale);
 }
@@ -33,9 +33,11 @@
 namespace wendy
 {
 
-VertexComponent::VertexComponent(const char* name, size_t count):
+VertexComponent::VertexComponent(const char* name, size_t count, bool instanced):
   m_name(name),
-  m_count(count)
+  m_count(count),
+  m_offset(0),
+  m_instanced(instanced)
 {
 }
 
@@ -49,11 +51,11 @@ VertexFormat::VertexFormat(const char* specification)
     throw Exception("Invalid vertex format specification");
 }
 
-bool VertexFormat::createComponent(const char* name, size_t count)
+bool VertexFormat::createComponent(const char* name, size_t count, bool instanced)
 {
-  if (count < 1 || count > 4)
+  if ((count < 1 || count > 4) && count != 16)
   {
-    logError("Vertex components must have between 1 and 4 elements");
+    logError("Vertex components must have between 1 and 4, or 16 elements");
     return false;
   }
 
@@ -67,7 +69,7 @@ bool VertexFormat::createComponent(const char* name, size_t count)
 
   const size_t offset = size();
 
-  m_components.push_back(VertexComponent(name, count));
+  m_components.push_back(VertexComponent(name, count, instanced));
   VertexComponent& component = m_components.back();
   component.m_offset = offset;
   return true;
@@ -78,15 +80,18 @@ bool VertexFormat::createComponents(const char* specification)
   const char* c = specification;
   while (*c != '\0')
   {
-    if (*c < '1' || *c > '4')
+    if (!std::isdigit(*c))
     {
       logError("Invalid vertex component element count");
       return false;
     }
 
-    const size_t count = *c - '0';
+    size_t count = 0;
 
-    if (*(++c) == '\0')
+    while (std::isdigit(*c))
+      count = count * 10 + (*c++ - '0');
+
+    if (*c == '\0')
     {
       logError("Unexpected end of vertex format specification");
       return false;
@@ -108,6 +113,19 @@ bool VertexFormat::createComponents(const char* specification)
       return false;
     }
 
+    bool instanced = false;
+
+    if (std::tolower(*c) == 'i')
+    {
+      instanced = true;
+
+      if (*(++c) == '\0')
+      {
+        logError("Unexpected end of vertex format specification");
+        return false;
+      }
+    }
+
     if (*(c++) != ':')
     {
       logError("Invalid vertex component specification; expected :");
@@ -119,7 +137,7 @@ bool VertexFormat::createComponents(const char* specification)
     while (*c != '\0' && *c != ' ')
       name += *c++;
 
-    if (!createComponent(name.c_str(), count))
+    if (!createComponent(name.c_str(), count, instanced))
       return false;
 
     while (*c != '\0' && *c == ' ')
@@ -170,7 +188,14 @@ std::string stringCast(const VertexFormat& format)
   std::ostringstream result;
 
   for (const VertexComponent& c : format.components())
-    result << c.elementCount() << 'f' << ':' << c.name() << ' ';
+  {
+    result << c.elementCount() << 'f';
+
+    if (c.isInstanced())
+      result << 'i';
+
+    result << ':' << c.name() << ' ';
+  }
 
   return result.str();
 }
@@ -185,9 +210,13 @@ const VertexFormat Vertex2ft2fv::format("2f:vTexCoord 2f:vPosition");
 
 const VertexFormat Vertex2ft3fv::format("2f:vTexCoord 3f:vPosition");
 
+const VertexFormat Vertex4fc2ft2fv::format("4f:vColor 2f:vTexCoord 2f:vPosition");
+
 const VertexFormat Vertex4fc2ft3fv::format("4f:vColor 2f:vTexCoord 3f:vPosition");
 
 const VertexFormat Vertex3fn2ft3fv::format("3f:vNormal 2f:vTexCoord 3f:vPosition");
 
+const VertexFormat InstanceTransform::format("16fi:wyInstanceM");
+
 } /*namespace wendy*/
 
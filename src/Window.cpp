@@ -267,6 +267,8 @@ bool Window::update()
 {
   ProfileNodeCall call("Window::update");
 
+  deliverLog();
+
   if (Gamepad::present())
   {
     if (!m_gamepad)
@@ -0,0 +1,228 @@
+///////////////////////////////////////////////////////////////////////
+// Wendy - a simple game engine
+// Copyright (c) 2014 Camilla Berglund <elmindreda@elmindreda.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any
+// damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any
+// purpose, including commercial applications, and to alter it and
+// redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you
+//     must not claim that you wrote the original software. If you use
+//     this software in a product, an acknowledgment in the product
+//     documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and
+//     must not be misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source
+//     distribution.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <wendy/Config.hpp>
+
+#include <wendy/Core.hpp>
+#include <wendy/Rect.hpp>
+#include <wendy/Path.hpp>
+#include <wendy/Pixel.hpp>
+#include <wendy/Resource.hpp>
+#include <wendy/Image.hpp>
+#include <wendy/Compressor.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace wendy;
+
+namespace
+{
+
+void usage()
+{
+  std::fprintf(stderr,
+               "Usage: wendy_compress [-f FORMAT] [-m] [-t PSNR] SOURCE TARGET.ktx\n"
+               "       wendy_compress -c [-t PSNR] SOURCE TARGET.ktx\n"
+               "\n"
+               "Compresses SOURCE into the KTX file TARGET, or with -c compares an\n"
+               "existing TARGET against SOURCE, and prints the PSNR of the result.\n"
+               "\n"
+               "  -f FORMAT  Compressed format: bc1, bc3, bc4 or bc5, defaulting to\n"
+               "             the one matching the channels of SOURCE\n"
+               "  -m         Include a box filtered mipmap chain\n"
+               "  -c         Check TARGET instead of writing it\n"
+               "  -t PSNR    Fail if the PSNR is below this many decibels\n");
+}
+
+PixelFormat defaultFormat(const PixelFormat& source)
+{
+  switch (source.semantic())
+  {
+    case PixelFormat::L:
+      return PixelFormat::L_BC4;
+    case PixelFormat::LA:
+      return PixelFormat::LA_BC5;
+    case PixelFormat::RGB:
+      return PixelFormat::RGB_BC1;
+    case PixelFormat::RGBA:
+      return PixelFormat::RGBA_BC3;
+    default:
+      return PixelFormat();
+  }
+}
+
+PixelFormat parseFormat(const char* name)
+{
+  if (std::strcmp(name, "bc1") == 0)
+    return PixelFormat::RGB_BC1;
+  if (std::strcmp(name, "bc3") == 0)
+    return PixelFormat::RGBA_BC3;
+  if (std::strcmp(name, "bc4") == 0)
+    return PixelFormat::L_BC4;
+  if (std::strcmp(name, "bc5") == 0)
+    return PixelFormat::LA_BC5;
+
+  return PixelFormat();
+}
+
+} /*namespace*/
+
+int main(int argc, char** argv)
+{
+  PixelFormat format;
+  bool mipmapped = false;
+  bool check = false;
+  double threshold = 0.0;
+  std::vector<const char*> names;
+
+  for (int i = 1;  i < argc;  i++)
+  {
+    if (std::strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+    {
+      format = parseFormat(argv[++i]);
+      if (!format.isValid())
+      {
+        std::fprintf(stderr, "Unknown compressed format %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    }
+    else if (std::strcmp(argv[i], "-m") == 0)
+      mipmapped = true;
+    else if (std::strcmp(argv[i], "-c") == 0)
+      check = true;
+    else if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+      threshold = std::atof(argv[++i]);
+    else if (argv[i][0] == '-')
+    {
+      usage();
+      return EXIT_FAILURE;
+    }
+    else
+      names.push_back(argv[i]);
+  }
+
+  if (names.size() != 2)
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  // Without search paths, resource names are used as paths
+  ResourceCache cache;
+
+  Ref<Image> source = Image::read(cache, names[0]);
+  if (!source)
+    return EXIT_FAILURE;
+
+  Ref<Image> compressed;
+
+  if (check)
+  {
+    compressed = Image::read(cache, names[1]);
+    if (!compressed)
+      return EXIT_FAILURE;
+
+    mipmapped = compressed->levelCount() > 1;
+  }
+
+  if (mipmapped)
+  {
+    source = createMipmaps(*source);
+    if (!source)
+      return EXIT_FAILURE;
+  }
+
+  if (!check)
+  {
+    if (!format.isValid())
+      format = defaultFormat(source->format());
+
+    compressed = compressImage(*source, format);
+    if (!compressed)
+      return EXIT_FAILURE;
+  }
+
+  Ref<Image> decompressed = decompressImage(*compressed);
+  if (!decompressed)
+    return EXIT_FAILURE;
+
+  // Compare only the channels kept by the compressed format
+  if (source->format() != decompressed->format())
+  {
+    if (source->format() != PixelFormat::RGBA8 ||
+        decompressed->format() != PixelFormat::RGB8)
+    {
+      std::fprintf(stderr, "Image %s does not match pixel format %s\n",
+                   names[0],
+                   stringCast(compressed->format()).c_str());
+      return EXIT_FAILURE;
+    }
+
+    std::vector<uint8> texels;
+
+    for (uint level = 0;  level < source->levelCount();  level++)
+    {
+      const uint width = max(source->width() >> level, 1u);
+      const uint height = max(source->height() >> level, 1u);
+      const uint8* pixels = (const uint8*) source->pixels(level);
+
+      for (uint i = 0;  i < width * height;  i++)
+        texels.insert(texels.end(), pixels + i * 4, pixels + i * 4 + 3);
+    }
+
+    source = Image::create(ResourceInfo(cache),
+                           PixelFormat::RGB8,
+                           source->width(), source->height(), 1,
+                           texels.data(), 0,
+                           source->levelCount());
+  }
+
+  const double psnr = computePSNR(*source, *decompressed);
+  if (psnr < 0.0)
+    return EXIT_FAILURE;
+
+  std::printf("%s: %s %ux%u, %u levels, %.2f dB\n",
+              names[1],
+              stringCast(compressed->format()).c_str(),
+              compressed->width(),
+              compressed->height(),
+              compressed->levelCount(),
+              psnr);
+
+  // A result below the threshold is not written, so no bad file is left behind
+  if (psnr < threshold)
+  {
+    std::fprintf(stderr, "PSNR of %s is below %.2f dB\n", names[1], threshold);
+    return EXIT_FAILURE;
+  }
+
+  if (!check && !compressed->write(Path(names[1])))
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
+